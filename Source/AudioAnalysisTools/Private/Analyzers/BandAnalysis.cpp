@@ -0,0 +1,180 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/BandAnalysis.h"
+#include "AudioAnalysisToolsDefines.h"
+#include "Math/UnrealMathUtility.h"
+
+namespace
+{
+	/**
+	 * Calculate the one-pole smoothing coefficient for the given time constant
+	 *
+	 * @param TimeConstant The time constant in seconds. Values <= 0 disable smoothing
+	 * @param DeltaTime The time step in seconds
+	 * @return The coefficient applied to the previous value
+	 */
+	FORCEINLINE float GetSmoothingCoefficient(float TimeConstant, float DeltaTime)
+	{
+		return TimeConstant > 0 ? FMath::Exp(-DeltaTime / TimeConstant) : 0.f;
+	}
+}
+
+UBandAnalysis::UBandAnalysis()
+	: BandLayout(EFrequencyBandLayout::ThirdOctave),
+	  AttackTime(0),
+	  ReleaseTime(0),
+	  PeakHoldTime(0),
+	  PeakReleaseTime(0)
+{
+}
+
+UBandAnalysis* UBandAnalysis::CreateBandAnalysis(EFrequencyBandLayout InBandLayout, float InAttackTime, float InReleaseTime, float InPeakHoldTime)
+{
+	UBandAnalysis* BandAnalysis = NewObject<UBandAnalysis>();
+	BandAnalysis->UpdateSmoothing(InAttackTime, InReleaseTime);
+	BandAnalysis->UpdatePeakHold(InPeakHoldTime);
+	BandAnalysis->UpdateBandLayout(InBandLayout);
+	return BandAnalysis;
+}
+
+void UBandAnalysis::UpdateBandLayout(EFrequencyBandLayout InBandLayout)
+{
+	BandLayout = InBandLayout;
+
+	// Base-2 nominal bands relative to 1 kHz (IEC 61260)
+	int32 FirstBandIndex, LastBandIndex, BandsPerOctave;
+	switch (BandLayout)
+	{
+	case EFrequencyBandLayout::Octave:
+		FirstBandIndex = -5;
+		LastBandIndex = 4;
+		BandsPerOctave = 1;
+		break;
+	case EFrequencyBandLayout::ThirdOctave:
+	default:
+		FirstBandIndex = -17;
+		LastBandIndex = 13;
+		BandsPerOctave = 3;
+		break;
+	}
+
+	const int64 NumBands = LastBandIndex - FirstBandIndex + 1;
+	const float HalfBandRatio = FMath::Pow(2.f, 1.f / (2.f * BandsPerOctave));
+
+	CenterFrequencies.SetNum(NumBands);
+	LowEdges.SetNum(NumBands);
+	HighEdges.SetNum(NumBands);
+
+	for (int64 Band = 0; Band < NumBands; ++Band)
+	{
+		const float CenterFrequency = 1000.f * FMath::Pow(2.f, static_cast<float>(FirstBandIndex + Band) / BandsPerOctave);
+
+		CenterFrequencies[Band] = CenterFrequency;
+		LowEdges[Band] = CenterFrequency / HalfBandRatio;
+		HighEdges[Band] = CenterFrequency * HalfBandRatio;
+	}
+
+	BandLevels.Init(0, NumBands);
+	SmoothedBandLevels.Init(0, NumBands);
+	PeakBandLevels.Init(0, NumBands);
+	PeakHoldTimers.Init(0, NumBands);
+
+	BandMap.Invalidate();
+}
+
+void UBandAnalysis::UpdateSmoothing(float InAttackTime, float InReleaseTime)
+{
+	AttackTime = FMath::Max(InAttackTime, 0.f);
+	ReleaseTime = FMath::Max(InReleaseTime, 0.f);
+}
+
+void UBandAnalysis::UpdatePeakHold(float InPeakHoldTime, float InPeakReleaseTime)
+{
+	PeakHoldTime = FMath::Max(InPeakHoldTime, 0.f);
+	PeakReleaseTime = FMath::Max(InPeakReleaseTime, 0.f);
+}
+
+bool UBandAnalysis::ProcessMagnitude(const TArray<float>& MagnitudeSpectrum, int32 SampleRate, float DeltaTime)
+{
+	return ProcessMagnitude(TArray64<float>(MagnitudeSpectrum), SampleRate, DeltaTime);
+}
+
+bool UBandAnalysis::ProcessMagnitude(const TArray64<float>& MagnitudeSpectrum, int32 SampleRate, float DeltaTime)
+{
+	if (MagnitudeSpectrum.Num() <= 0 || SampleRate <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot process band analysis: magnitude spectrum size ('%lld') and sample rate ('%d') must be > '0'"), MagnitudeSpectrum.Num(), SampleRate);
+		return false;
+	}
+
+	if (!BandMap.IsBuiltFor(MagnitudeSpectrum.Num(), SampleRate))
+	{
+		BandMap.Build(LowEdges, HighEdges, MagnitudeSpectrum.Num(), SampleRate);
+	}
+
+	BandMap.ComputeRootMeanSquare(MagnitudeSpectrum.GetData(), BandLevels.GetData());
+
+	DeltaTime = FMath::Max(DeltaTime, 0.f);
+
+	const float AttackCoefficient = GetSmoothingCoefficient(AttackTime, DeltaTime);
+	const float ReleaseCoefficient = GetSmoothingCoefficient(ReleaseTime, DeltaTime);
+	const float PeakReleaseCoefficient = GetSmoothingCoefficient(PeakReleaseTime, DeltaTime);
+
+	for (int64 Band = 0; Band < BandLevels.Num(); ++Band)
+	{
+		const float Level = BandLevels[Band];
+		float& SmoothedLevel = SmoothedBandLevels[Band];
+
+		const float Coefficient = Level > SmoothedLevel ? AttackCoefficient : ReleaseCoefficient;
+		SmoothedLevel = Level + Coefficient * (SmoothedLevel - Level);
+
+		float& PeakLevel = PeakBandLevels[Band];
+		float& PeakHoldTimer = PeakHoldTimers[Band];
+
+		if (SmoothedLevel >= PeakLevel)
+		{
+			PeakLevel = SmoothedLevel;
+			PeakHoldTimer = PeakHoldTime;
+		}
+		else if (PeakHoldTimer > 0)
+		{
+			PeakHoldTimer -= DeltaTime;
+		}
+		else
+		{
+			PeakLevel = FMath::Max(SmoothedLevel, PeakLevel * PeakReleaseCoefficient);
+		}
+	}
+
+	return true;
+}
+
+int64 UBandAnalysis::GetNumBands() const
+{
+	return CenterFrequencies.Num();
+}
+
+float UBandAnalysis::GetBandCenterFrequency(int64 Band) const
+{
+	if (!(Band >= 0 && Band < CenterFrequencies.Num()))
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot obtain band center frequency: the specified band is '%lld', but it is expected to be >= '0' and < '%lld'"), Band, CenterFrequencies.Num());
+		return -1;
+	}
+	return CenterFrequencies[Band];
+}
+
+TArray<float> UBandAnalysis::GetBandLevels_BP() const
+{
+	return TArray<float>(BandLevels);
+}
+
+TArray<float> UBandAnalysis::GetSmoothedBandLevels_BP() const
+{
+	return TArray<float>(SmoothedBandLevels);
+}
+
+TArray<float> UBandAnalysis::GetPeakBandLevels_BP() const
+{
+	return TArray<float>(PeakBandLevels);
+}
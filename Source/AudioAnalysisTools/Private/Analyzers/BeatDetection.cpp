@@ -5,11 +5,52 @@
 #include "Math/UnrealMathUtility.h"
 #include "Math/NumericLimits.h"
 
+namespace
+{
+	/** The frequency range of the kick drum fundamental, in Hz */
+	constexpr float KickLowFrequency = 40.f;
+	constexpr float KickHighFrequency = 130.f;
+
+	/** The frequency range of the snare drum body and snap, in Hz */
+	constexpr float SnareLowFrequency = 150.f;
+	constexpr float SnareHighFrequency = 2500.f;
+
+	/** The frequency range of the hi-hat, in Hz */
+	constexpr float HiHatLowFrequency = 6000.f;
+	constexpr float HiHatHighFrequency = 16000.f;
+
+	float FrequencyToMel(float Frequency)
+	{
+		return 2595.f * FMath::LogX(10.f, 1.f + Frequency / 700.f);
+	}
+
+	float MelToFrequency(float Mel)
+	{
+		return 700.f * (FMath::Pow(10.f, Mel / 2595.f) - 1.f);
+	}
+
+	/** Add a value to a running sum, collecting the rounding error in the compensation (Neumaier summation) */
+	void AddCompensated(double& Sum, double& Compensation, double Value)
+	{
+		const double NewSum = Sum + Value;
+		Compensation += FMath::Abs(Sum) >= FMath::Abs(Value) ? (Sum - NewSum) + Value : (Value - NewSum) + Sum;
+		Sum = NewSum;
+	}
+}
+
 UBeatDetection::UBeatDetection()
 	: HistoryPosition(0),
 	  FFTSubbandSize(0),
-	  EnergyHistorySize(0)
+	  EnergyHistorySize(0),
+	  BandLayout(EBeatDetectionBandLayout::Linear),
+	  MinFrequency(30.f),
+	  MaxFrequency(16000.f),
+	  NumProcessedSpectrums(0)
 {
+	for (FSignalHistory& History : BeatHistories)
+	{
+		History.Reset(0, 1., 0.5f);
+	}
 }
 
 UBeatDetection* UBeatDetection::CreateBeatDetection(int64 InFFTSubbandsSize, int64 InEnergyHistorySize)
@@ -32,6 +73,12 @@ void UBeatDetection::UpdateFFTSubbandSize(int64 InFFTSubbandSize)
 		return;
 	}
 
+	if (BandLayout == EBeatDetectionBandLayout::Custom && InFFTSubbandSize != CustomEdges.Num() - 1)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Beat Detection FFT subbands size '%lld' does not match the '%lld' custom band edges. The value '%lld' will remain unchanged, update the custom band edges or the band layout instead"), InFFTSubbandSize, CustomEdges.Num(), FFTSubbandSize);
+		return;
+	}
+
 	UE_LOG(LogAudioAnalysis, Log, TEXT("Updating Beat Detection FFT subbands size from '%lld' to '%lld'"), FFTSubbandSize, InFFTSubbandSize);
 	
 	FFTSubbandSize = InFFTSubbandSize;
@@ -40,12 +87,148 @@ void UBeatDetection::UpdateFFTSubbandSize(int64 InFFTSubbandSize)
 	FFTAverageEnergy.SetNum(FFTSubbandSize);
 	FFTVariance.SetNum(FFTSubbandSize);
 	FFTBeatValues.SetNum(FFTSubbandSize);
-	EnergyHistory.SetNum(FFTSubbandSize);
+	BeatMask.Init(0, (FFTSubbandSize + 63) / 64);
+
+	UpdateBandEdges();
 
 	// We resized the external array, so we have to resize the new array
 	UpdateEnergyHistorySize(EnergyHistorySize);
 }
 
+void UBeatDetection::UpdateBandLayout(EBeatDetectionBandLayout InLayout, float InMinFrequency, float InMaxFrequency)
+{
+	if (InLayout == EBeatDetectionBandLayout::Custom)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update Beat Detection band layout: use UpdateCustomBandEdges to set the custom band edges"));
+		return;
+	}
+
+	if (InLayout != EBeatDetectionBandLayout::Linear && !(InMinFrequency > 0 && InMaxFrequency > InMinFrequency))
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update Beat Detection band layout: min frequency is '%f' and max frequency is '%f', expected 0 < min < max"), InMinFrequency, InMaxFrequency);
+		return;
+	}
+
+	BandLayout = InLayout;
+	MinFrequency = InMinFrequency;
+	MaxFrequency = InMaxFrequency;
+
+	UpdateBandEdges();
+	UpdateEnergyHistorySize(EnergyHistorySize);
+}
+
+void UBeatDetection::UpdateCustomBandEdges(const TArray<float>& EdgeFrequencies)
+{
+	if (EdgeFrequencies.Num() < 2)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update Beat Detection custom band edges: '%d' edges specified, expected at least '2'"), EdgeFrequencies.Num());
+		return;
+	}
+
+	for (int32 EdgeIndex = 0; EdgeIndex < EdgeFrequencies.Num(); ++EdgeIndex)
+	{
+		if (EdgeFrequencies[EdgeIndex] < 0 || (EdgeIndex > 0 && EdgeFrequencies[EdgeIndex] <= EdgeFrequencies[EdgeIndex - 1]))
+		{
+			UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update Beat Detection custom band edges: the edges must be non-negative and strictly ascending (edge '%d' is '%f')"), EdgeIndex, EdgeFrequencies[EdgeIndex]);
+			return;
+		}
+	}
+
+	BandLayout = EBeatDetectionBandLayout::Custom;
+	CustomEdges = TArray64<float>(EdgeFrequencies);
+
+	// Rebuilds the edges and resets the energy history
+	UpdateFFTSubbandSize(CustomEdges.Num() - 1);
+}
+
+void UBeatDetection::UpdateBandEdges()
+{
+	BandMap.Invalidate();
+
+	if (BandLayout == EBeatDetectionBandLayout::Linear)
+	{
+		LowEdges.Reset();
+		HighEdges.Reset();
+		return;
+	}
+
+	LowEdges.SetNum(FFTSubbandSize);
+	HighEdges.SetNum(FFTSubbandSize);
+
+	for (int64 SubbandIndex = 0; SubbandIndex < FFTSubbandSize; ++SubbandIndex)
+	{
+		switch (BandLayout)
+		{
+		case EBeatDetectionBandLayout::Logarithmic:
+		{
+			const float OctaveSpan = FMath::Log2(MaxFrequency / MinFrequency);
+			LowEdges[SubbandIndex] = MinFrequency * FMath::Pow(2.f, OctaveSpan * SubbandIndex / FFTSubbandSize);
+			HighEdges[SubbandIndex] = MinFrequency * FMath::Pow(2.f, OctaveSpan * (SubbandIndex + 1) / FFTSubbandSize);
+			break;
+		}
+		case EBeatDetectionBandLayout::Mel:
+		{
+			const float MinMel = FrequencyToMel(MinFrequency);
+			const float MelSpan = FrequencyToMel(MaxFrequency) - MinMel;
+			LowEdges[SubbandIndex] = MelToFrequency(MinMel + MelSpan * SubbandIndex / FFTSubbandSize);
+			HighEdges[SubbandIndex] = MelToFrequency(MinMel + MelSpan * (SubbandIndex + 1) / FFTSubbandSize);
+			break;
+		}
+		case EBeatDetectionBandLayout::Custom:
+		{
+			LowEdges[SubbandIndex] = CustomEdges[SubbandIndex];
+			HighEdges[SubbandIndex] = CustomEdges[SubbandIndex + 1];
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	KickRange = FindSubbandRange(KickLowFrequency, KickHighFrequency);
+	SnareRange = FindSubbandRange(SnareLowFrequency, SnareHighFrequency);
+	HiHatRange = FindSubbandRange(HiHatLowFrequency, HiHatHighFrequency);
+}
+
+UBeatDetection::FSubbandRange UBeatDetection::FindSubbandRange(float LowFrequency, float HighFrequency) const
+{
+	FSubbandRange Range;
+	Range.Low = INDEX_NONE;
+
+	int64 ClosestSubband = 0;
+	float ClosestDistance = TNumericLimits<float>::Max();
+	const float RangeCenter = FMath::Sqrt(LowFrequency * HighFrequency);
+
+	for (int64 SubbandIndex = 0; SubbandIndex < LowEdges.Num(); ++SubbandIndex)
+	{
+		const float CenterFrequency = FMath::Sqrt(FMath::Max(LowEdges[SubbandIndex], 1.f) * HighEdges[SubbandIndex]);
+
+		if (CenterFrequency >= LowFrequency && CenterFrequency <= HighFrequency)
+		{
+			if (Range.Low == INDEX_NONE)
+			{
+				Range.Low = SubbandIndex;
+			}
+			Range.High = SubbandIndex;
+		}
+
+		// Distance in octaves, so that the closest sub-band is found in musical terms
+		const float Distance = FMath::Abs(FMath::Log2(CenterFrequency / RangeCenter));
+		if (Distance < ClosestDistance)
+		{
+			ClosestDistance = Distance;
+			ClosestSubband = SubbandIndex;
+		}
+	}
+
+	if (Range.Low == INDEX_NONE)
+	{
+		Range.Low = Range.High = ClosestSubband;
+	}
+
+	return Range;
+}
+
 void UBeatDetection::UpdateEnergyHistorySize(int64 InEnergyHistorySize)
 {
 	// We'll assume nothing, and make sure our user has made a reasonable request
@@ -60,92 +243,217 @@ void UBeatDetection::UpdateEnergyHistorySize(int64 InEnergyHistorySize)
 	
 	EnergyHistorySize = InEnergyHistorySize;
 
-	for (int64 SubbandIndex = 0; SubbandIndex < FFTSubbandSize; ++SubbandIndex)
+	EnergyHistory.Init(0, FFTSubbandSize * EnergyHistorySize);
+	EnergyHistorySums.Init(0, FFTSubbandSize);
+	EnergyHistoryCompensations.Init(0, FFTSubbandSize);
+	HistoryPosition = 0;
+}
+
+void UBeatDetection::UpdateMappedSubbands(const TArray64<float>& MagnitudeSpectrum, int32 SampleRate)
+{
+	if (!BandMap.IsBuiltFor(MagnitudeSpectrum.Num(), SampleRate))
 	{
-		EnergyHistory[SubbandIndex].SetNum(EnergyHistorySize);
+		BandMap.Build(LowEdges, HighEdges, MagnitudeSpectrum.Num(), SampleRate);
 	}
+
+	BandMap.ComputeMeanAndVariance(MagnitudeSpectrum.GetData(), FFTSubbands.GetData(), FFTVariance.GetData());
 }
 
-void UBeatDetection::UpdateFFT(const TArray64<float>& MagnitudeSpectrum)
+void UBeatDetection::UpdateFFT(const TArray64<float>& MagnitudeSpectrum, int32 SampleRate)
 {
-	const int64 MagnitudeSpectrumSize{MagnitudeSpectrum.Num()};
-
-	// Sub-band calculation
-	for (int64 SubbandIndex = 0; SubbandIndex < FFTSubbandSize; ++SubbandIndex)
+	if (BandLayout == EBeatDetectionBandLayout::Linear)
 	{
-		FFTSubbands[SubbandIndex] = 0;
+		const int64 MagnitudeSpectrumSize{MagnitudeSpectrum.Num()};
+		const int64 SubbandWidth{MagnitudeSpectrumSize / FFTSubbandSize};
+		const float SubbandScale{static_cast<float>(FFTSubbandSize) / MagnitudeSpectrumSize};
 
-		for (int64 SubbandInternalIndex = 0; SubbandInternalIndex < MagnitudeSpectrumSize / FFTSubbandSize; ++SubbandInternalIndex)
+		for (int64 SubbandIndex = 0; SubbandIndex < FFTSubbandSize; ++SubbandIndex)
 		{
-			FFTSubbands[SubbandIndex] += MagnitudeSpectrum[SubbandIndex * (MagnitudeSpectrumSize / FFTSubbandSize) + SubbandInternalIndex];
+			const float* SubbandMagnitudes = MagnitudeSpectrum.GetData() + SubbandIndex * SubbandWidth;
+
+			// Sub-band calculation
+			float SubbandValue = 0;
+			for (int64 SubbandInternalIndex = 0; SubbandInternalIndex < SubbandWidth; ++SubbandInternalIndex)
+			{
+				SubbandValue += SubbandMagnitudes[SubbandInternalIndex];
+			}
+			// After summing the subband values, divide the added number of times to get the average value
+			SubbandValue *= SubbandScale;
+			FFTSubbands[SubbandIndex] = SubbandValue;
+
+			// Calculation of subband variance value
+			float Variance = 0;
+			for (int64 SubbandInternalIndex = 0; SubbandInternalIndex < SubbandWidth; ++SubbandInternalIndex)
+			{
+				const float Deviation = SubbandMagnitudes[SubbandInternalIndex] - SubbandValue;
+				Variance += Deviation * Deviation;
+			}
+			FFTVariance[SubbandIndex] = Variance * SubbandScale;
 		}
-		// After summing the subband values, divide the added number of times to get the average value
-		FFTSubbands[SubbandIndex] *= static_cast<float>(FFTSubbandSize) / MagnitudeSpectrumSize;
+	}
+	else
+	{
+		UpdateMappedSubbands(MagnitudeSpectrum, SampleRate);
+	}
 
-		// Calculation of subband variance value
-		for (int64 SubbandInternalIndex = 0; SubbandInternalIndex < MagnitudeSpectrumSize / FFTSubbandSize; ++SubbandInternalIndex)
-		{
-			FFTVariance[SubbandIndex] += FMath::Pow(MagnitudeSpectrum[SubbandIndex * (MagnitudeSpectrumSize / FFTSubbandSize) + SubbandInternalIndex] - FFTSubbands[SubbandIndex], 2);
-		}
-		FFTVariance[SubbandIndex] *= static_cast<float>(FFTSubbandSize) / MagnitudeSpectrumSize;
+	for (int64 SubbandIndex = 0; SubbandIndex < FFTSubbandSize; ++SubbandIndex)
+	{
+		const float SubbandValue = FFTSubbands[SubbandIndex];
 
 		// Reduce possible noise with linear digression using some magic numbers
 		FFTBeatValues[SubbandIndex] = (-0.0025714 * FFTVariance[SubbandIndex]) + 1.15142857;
+
+		// Calculation of energy average from the running sum, before the current value enters the history
+		FFTAverageEnergy[SubbandIndex] = static_cast<float>((EnergyHistorySums[SubbandIndex] + EnergyHistoryCompensations[SubbandIndex]) / EnergyHistorySize);
+
+		// Replace the oldest value in the energy history with the calculated subband
+		float& HistoryValue = EnergyHistory[SubbandIndex * EnergyHistorySize + HistoryPosition];
+		AddCompensated(EnergyHistorySums[SubbandIndex], EnergyHistoryCompensations[SubbandIndex], SubbandValue);
+		AddCompensated(EnergyHistorySums[SubbandIndex], EnergyHistoryCompensations[SubbandIndex], -static_cast<double>(HistoryValue));
+		HistoryValue = SubbandValue;
 	}
 
-	// Calculation of energy average
-	for (int64 SubbandIndex = 0; SubbandIndex < FFTSubbandSize; ++SubbandIndex)
+	// Evaluate the beats of all sub-bands at once, 64 sub-bands per mask word. The compare is branchless so the inner loop can be vectorized
+	for (int64 WordIndex = 0; WordIndex < BeatMask.Num(); ++WordIndex)
 	{
-		FFTAverageEnergy[SubbandIndex] = 0;
-		for (int64 EnergyHistoryIndex = 0; EnergyHistoryIndex < EnergyHistorySize; ++EnergyHistoryIndex)
+		const int64 FirstSubband = WordIndex * 64;
+		const int64 NumWordSubbands = FMath::Min<int64>(64, FFTSubbandSize - FirstSubband);
+
+		const float* Subbands = FFTSubbands.GetData() + FirstSubband;
+		const float* AverageEnergy = FFTAverageEnergy.GetData() + FirstSubband;
+		const float* BeatValues = FFTBeatValues.GetData() + FirstSubband;
+
+		uint64 Word = 0;
+		for (int64 BitIndex = 0; BitIndex < NumWordSubbands; ++BitIndex)
 		{
-			// Average of total energy += Energy history of each subband
-			FFTAverageEnergy[SubbandIndex] += EnergyHistory[SubbandIndex][EnergyHistoryIndex];
+			Word |= static_cast<uint64>(Subbands[BitIndex] > AverageEnergy[BitIndex] * BeatValues[BitIndex]) << BitIndex;
 		}
+		BeatMask[WordIndex] = Word;
+	}
 
-		// Divide the sum by the history energy to get a weighted average
-		FFTAverageEnergy[SubbandIndex] /= EnergyHistorySize;
+	// A pseudo-cyclic list is represented by circular array indexes
+	HistoryPosition = (HistoryPosition + 1) % EnergyHistorySize;
+}
+
+void UBeatDetection::ProcessMagnitude(const TArray<float>& MagnitudeSpectrum, int32 SampleRate, float Timestamp)
+{
+	ProcessMagnitude(TArray64<float>(MagnitudeSpectrum), SampleRate, static_cast<double>(Timestamp));
+}
+
+void UBeatDetection::ProcessMagnitude(const TArray64<float>& MagnitudeSpectrum, int32 SampleRate, double Timestamp)
+{
+	if (BandLayout != EBeatDetectionBandLayout::Linear && SampleRate <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to process magnitude spectrum for beat detection: the sample rate is '%d', expected > '0'"), SampleRate);
+		return;
 	}
 
-	// Put new values into the energy history
-	for (int64 SubbandIndex = 0; SubbandIndex < FFTSubbandSize; ++SubbandIndex)
+	UpdateFFT(MagnitudeSpectrum, SampleRate);
+
+	const double HistoryTimestamp = Timestamp >= 0 ? Timestamp : static_cast<double>(NumProcessedSpectrums);
+	++NumProcessedSpectrums;
+
+	if (BeatHistories[0].IsEnabled())
 	{
-		// Add the calculated subband to the HistoryPosition in the energy history
-		EnergyHistory[SubbandIndex][HistoryPosition] = FFTSubbands[SubbandIndex];
+		BeatHistories[static_cast<int32>(EBeatDetectionSignal::Kick)].Add(IsKick() ? 1.f : 0.f, HistoryTimestamp);
+		BeatHistories[static_cast<int32>(EBeatDetectionSignal::Snare)].Add(IsSnare() ? 1.f : 0.f, HistoryTimestamp);
+		BeatHistories[static_cast<int32>(EBeatDetectionSignal::HiHat)].Add(IsHiHat() ? 1.f : 0.f, HistoryTimestamp);
+		BeatHistories[static_cast<int32>(EBeatDetectionSignal::NumBeats)].Add(static_cast<float>(CountBeatsInRange(0, FFTSubbandSize - 1)), HistoryTimestamp);
 	}
+}
 
-	// A pseudo-cyclic list is represented by circular array indexes
-	HistoryPosition = (HistoryPosition + 1) % EnergyHistorySize;
+void UBeatDetection::EnableHistory(int64 Capacity, float WindowDuration)
+{
+	if (Capacity <= 0 || WindowDuration < 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to enable beat detection history: capacity is '%lld' and window duration is '%f', expected > '0' and >= '0'"), Capacity, WindowDuration);
+		return;
+	}
+
+	for (FSignalHistory& History : BeatHistories)
+	{
+		History.Reset(Capacity, WindowDuration, History.GetThreshold());
+	}
+}
+
+void UBeatDetection::DisableHistory()
+{
+	for (FSignalHistory& History : BeatHistories)
+	{
+		History.Reset(0, History.GetWindowDuration(), History.GetThreshold());
+	}
+}
+
+void UBeatDetection::UpdateHistoryThreshold(EBeatDetectionSignal Signal, float Threshold)
+{
+	if (Signal >= EBeatDetectionSignal::Count)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update beat detection history threshold: invalid beat signal"));
+		return;
+	}
+
+	FSignalHistory& History = BeatHistories[static_cast<int32>(Signal)];
+	History.Reset(History.GetCapacity(), History.GetWindowDuration(), Threshold);
 }
 
-void UBeatDetection::ProcessMagnitude(const TArray<float>& MagnitudeSpectrum)
+float UBeatDetection::GetHistoryMax(EBeatDetectionSignal Signal) const
 {
-	ProcessMagnitude(TArray64<float>(MagnitudeSpectrum));
+	return Signal < EBeatDetectionSignal::Count ? GetHistory(Signal).GetWindowMax() : 0;
 }
 
-void UBeatDetection::ProcessMagnitude(const TArray64<float>& MagnitudeSpectrum)
+float UBeatDetection::GetHistoryMean(EBeatDetectionSignal Signal) const
 {
-	UpdateFFT(MagnitudeSpectrum);
+	return Signal < EBeatDetectionSignal::Count ? GetHistory(Signal).GetWindowMean() : 0;
+}
+
+int64 UBeatDetection::GetHistoryCountAboveThreshold(EBeatDetectionSignal Signal) const
+{
+	return Signal < EBeatDetectionSignal::Count ? GetHistory(Signal).GetWindowCountAboveThreshold() : 0;
 }
 
 bool UBeatDetection::IsBeat(int64 SubBand) const
 {
 	// Prevent out of array exception
-	if (SubBand >= FFTSubbandSize)
+	if (SubBand < 0 || SubBand >= FFTSubbandSize)
 	{
-		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot detect a beat: FFT sub-band ('%lld') must not exceed the sub-band size ('%lld')"), SubBand, FFTSubbandSize);
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot detect a beat: FFT sub-band ('%lld') must be >= '0' and must not exceed the sub-band size ('%lld')"), SubBand, FFTSubbandSize);
 		return false;
 	}
-	return FFTSubbands[SubBand] > FFTAverageEnergy[SubBand] * FFTBeatValues[SubBand];
+	return (BeatMask[SubBand / 64] >> (SubBand % 64)) & 1;
+}
+
+bool UBeatDetection::IsBeatInRange(const FSubbandRange& Range) const
+{
+	if (Range.High < Range.Low)
+	{
+		return false;
+	}
+
+	if (Range.High == Range.Low)
+	{
+		return IsBeat(Range.Low);
+	}
+
+	return IsBeatRange(Range.Low, Range.High, (Range.High - Range.Low) / 3);
 }
 
 bool UBeatDetection::IsKick() const
 {
+	if (BandLayout != EBeatDetectionBandLayout::Linear)
+	{
+		return IsBeatInRange(KickRange);
+	}
+
 	return IsBeat(KICK_BAND);
 }
 
 bool UBeatDetection::IsSnare() const
 {
+	if (BandLayout != EBeatDetectionBandLayout::Linear)
+	{
+		return IsBeatInRange(SnareRange);
+	}
+
 	constexpr int64 Low = 1;
 	const int64 High = FFTSubbandSize / 3;
 	const int64 Threshold = (High - Low) / 3;
@@ -155,6 +463,11 @@ bool UBeatDetection::IsSnare() const
 
 bool UBeatDetection::IsHiHat() const
 {
+	if (BandLayout != EBeatDetectionBandLayout::Linear)
+	{
+		return IsBeatInRange(HiHatRange);
+	}
+
 	const int64 Low = FFTSubbandSize / 2;
 	const int64 High = FFTSubbandSize - 1;
 	const int64 Threshold = (High - Low) / 3;
@@ -182,17 +495,37 @@ bool UBeatDetection::IsBeatRange(int64 Low, int64 High, int64 Threshold) const
 		return false;
 	}
 
-	int64 NumOfBeats = 0;
+	return CountBeatsInRange(Low, High) > Threshold;
+}
+
+int64 UBeatDetection::CountBeatsInRange(int64 Low, int64 High) const
+{
+	if (!(Low >= 0 && High < FFTSubbandSize && Low <= High))
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot count beats in range: the span is '%lld' to '%lld', expected 0 <= low <= high < '%lld'"), Low, High, FFTSubbandSize);
+		return 0;
+	}
+
+	const int64 LowWord = Low / 64;
+	const int64 HighWord = High / 64;
+
+	// Masks keeping the bits at and above Low in the first word, and at and below High in the last word
+	const uint64 LowMask = ~0ull << (Low % 64);
+	const uint64 HighMask = ~0ull >> (63 - High % 64);
 
-	for (int64 Index = Low; Index < High + 1; ++Index)
+	if (LowWord == HighWord)
 	{
-		if (IsBeat(Index))
-		{
-			NumOfBeats++;
-		}
+		return FMath::CountBits(BeatMask[LowWord] & LowMask & HighMask);
+	}
+
+	int64 NumOfBeats = FMath::CountBits(BeatMask[LowWord] & LowMask);
+	for (int64 WordIndex = LowWord + 1; WordIndex < HighWord; ++WordIndex)
+	{
+		NumOfBeats += FMath::CountBits(BeatMask[WordIndex]);
 	}
+	NumOfBeats += FMath::CountBits(BeatMask[HighWord] & HighMask);
 
-	return NumOfBeats > Threshold;
+	return NumOfBeats;
 }
 
 float UBeatDetection::GetBand(int64 Subband) const
@@ -244,3 +577,23 @@ TArray<float> UBeatDetection::GetFFTBeatValues_BP() const
 	}
 	return TArray<float>(FFTBeatValues);
 }
+
+bool UBeatDetection::FillFFTSubbands(TArray<float>& Values) const
+{
+	return AudioAnalysisTools::CopyToBlueprintArray(FFTSubbands, Values, TEXT("FFT sub-bands"));
+}
+
+bool UBeatDetection::FillFFTAverageEnergy(TArray<float>& Values) const
+{
+	return AudioAnalysisTools::CopyToBlueprintArray(FFTAverageEnergy, Values, TEXT("FFT average energy"));
+}
+
+bool UBeatDetection::FillFFTVariance(TArray<float>& Values) const
+{
+	return AudioAnalysisTools::CopyToBlueprintArray(FFTVariance, Values, TEXT("FFT variance"));
+}
+
+bool UBeatDetection::FillFFTBeatValues(TArray<float>& Values) const
+{
+	return AudioAnalysisTools::CopyToBlueprintArray(FFTBeatValues, Values, TEXT("FFT beat values"));
+}
@@ -0,0 +1,242 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/BeatTracker.h"
+#include "AudioAnalysisToolsDefines.h"
+#include "Math/UnrealMathUtility.h"
+
+namespace
+{
+	/** The tempo assumed until a beat period is provided */
+	constexpr float DefaultBPM = 120.f;
+
+	/** The smoothing applied to the measured onset detection function rate */
+	constexpr float FrameDurationSmoothing = 0.9f;
+}
+
+UBeatTracker::UBeatTracker()
+	: MinTransitionLag(0),
+	  Alpha(0),
+	  Tightness(0),
+	  BeatPeriod(0),
+	  FrameDuration(0),
+	  CurrentFrame(-1),
+	  LastBeatFrame(0),
+	  NextBeatFrame(-1),
+	  PredictionFrame(0),
+	  CurrentTimestamp(0),
+	  bBeatDue(false)
+{
+}
+
+UBeatTracker* UBeatTracker::CreateBeatTracker(int64 InScoreHistorySize, float InAlpha, float InTightness)
+{
+	UBeatTracker* BeatTracker = NewObject<UBeatTracker>();
+	BeatTracker->UpdateParameters(InScoreHistorySize, InAlpha, InTightness);
+	return BeatTracker;
+}
+
+void UBeatTracker::UpdateParameters(int64 InScoreHistorySize, float InAlpha, float InTightness)
+{
+	if (InScoreHistorySize < 8)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update beat tracker parameters: score history size is '%lld', expected >= '8'"), InScoreHistorySize);
+		return;
+	}
+
+	if (!(InAlpha >= 0 && InAlpha < 1) || InTightness <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update beat tracker parameters: alpha is '%f' and tightness is '%f', expected 0 <= alpha < 1 and tightness > 0"), InAlpha, InTightness);
+		return;
+	}
+
+	UE_LOG(LogAudioAnalysis, Log, TEXT("Updating Beat Tracker score history size from '%lld' to '%lld'"), CumulativeScore.Num(), InScoreHistorySize);
+
+	Alpha = InAlpha;
+	Tightness = InTightness;
+
+	CumulativeScore.Init(0, InScoreHistorySize);
+	FutureScore.Reset();
+	TransitionWeights.Reset();
+
+	BeatPeriod = 0;
+	CurrentFrame = -1;
+	LastBeatFrame = 0;
+	NextBeatFrame = -1;
+	PredictionFrame = 0;
+	bBeatDue = false;
+}
+
+void UBeatTracker::SetBeatPeriod(float NewBeatPeriod)
+{
+	// The prediction looks up to twice the period back from one period ahead, which must stay within the score history
+	const float MaxBeatPeriod = (CumulativeScore.Num() - 1) / 2.f;
+	NewBeatPeriod = FMath::Clamp(NewBeatPeriod, 2.f, MaxBeatPeriod);
+
+	if (TransitionWeights.Num() > 0 && FMath::IsNearlyEqual(NewBeatPeriod, BeatPeriod, 0.01f))
+	{
+		return;
+	}
+
+	BeatPeriod = NewBeatPeriod;
+
+	// Log-Gaussian weighting of the previous beat position, centered one beat period back
+	MinTransitionLag = FMath::Max<int64>(1, FMath::RoundToInt(BeatPeriod / 2));
+	const int64 MaxTransitionLag = FMath::Min<int64>(FMath::RoundToInt(2 * BeatPeriod), CumulativeScore.Num() - 1);
+
+	TransitionWeights.SetNumUninitialized(MaxTransitionLag - MinTransitionLag + 1);
+	for (int64 Lag = MinTransitionLag; Lag <= MaxTransitionLag; ++Lag)
+	{
+		const float Deviation = Tightness * FMath::Loge(Lag / BeatPeriod);
+		TransitionWeights[Lag - MinTransitionLag] = FMath::Exp(-0.5f * Deviation * Deviation);
+	}
+}
+
+bool UBeatTracker::ProcessOnsetValue(float OnsetValue, float Timestamp, float DeltaTime, float InBeatPeriod)
+{
+	return ProcessOnsetValue(OnsetValue, static_cast<double>(Timestamp), DeltaTime, InBeatPeriod);
+}
+
+bool UBeatTracker::ProcessOnsetValue(float OnsetValue, double Timestamp, float DeltaTime, float InBeatPeriod)
+{
+	if (CumulativeScore.Num() <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot process onset value: the beat tracker parameters have not been set"));
+		return false;
+	}
+
+	if (DeltaTime > 0)
+	{
+		FrameDuration = FrameDuration > 0 ? FrameDurationSmoothing * FrameDuration + (1.f - FrameDurationSmoothing) * DeltaTime : DeltaTime;
+	}
+
+	if (InBeatPeriod > 0)
+	{
+		SetBeatPeriod(InBeatPeriod);
+	}
+	else if (TransitionWeights.Num() <= 0 && FrameDuration > 0)
+	{
+		SetBeatPeriod(60.f / (DefaultBPM * FrameDuration));
+	}
+
+	if (TransitionWeights.Num() <= 0)
+	{
+		// The frame rate is not known yet
+		return false;
+	}
+
+	++CurrentFrame;
+	CurrentTimestamp = Timestamp;
+
+	// Each score is the current onset strength plus the best score of a preceding beat about one period earlier
+	CumulativeScore[CurrentFrame % CumulativeScore.Num()] = (1.f - Alpha) * OnsetValue + Alpha * GetBestPastScore(CurrentFrame);
+
+	bBeatDue = CurrentFrame == NextBeatFrame;
+	if (bBeatDue)
+	{
+		LastBeatFrame = CurrentFrame;
+
+		// Extrapolate one period ahead right away, so the beat phase and the time to the next beat keep running until the prediction half a period later refines it
+		NextBeatFrame = LastBeatFrame + FMath::Max<int64>(1, FMath::RoundToInt(BeatPeriod));
+	}
+
+	if (CurrentFrame >= PredictionFrame)
+	{
+		PredictNextBeat();
+	}
+
+	return bBeatDue;
+}
+
+float UBeatTracker::GetScore(int64 Frame) const
+{
+	if (Frame > CurrentFrame)
+	{
+		const int64 FutureIndex = Frame - CurrentFrame - 1;
+		return FutureIndex < FutureScore.Num() ? FutureScore[FutureIndex] : 0;
+	}
+
+	if (Frame < 0 || Frame <= CurrentFrame - CumulativeScore.Num())
+	{
+		return 0;
+	}
+
+	return CumulativeScore[Frame % CumulativeScore.Num()];
+}
+
+float UBeatTracker::GetBestPastScore(int64 Frame) const
+{
+	float BestScore = 0;
+
+	for (int64 Index = 0; Index < TransitionWeights.Num(); ++Index)
+	{
+		BestScore = FMath::Max(BestScore, TransitionWeights[Index] * GetScore(Frame - MinTransitionLag - Index));
+	}
+
+	return BestScore;
+}
+
+void UBeatTracker::PredictNextBeat()
+{
+	const int64 Period = FMath::Max<int64>(1, FMath::RoundToInt(BeatPeriod));
+
+	// Extend the cumulative score one period ahead, assuming no further onsets. Each future score only depends on scores at least one frame earlier
+	FutureScore.SetNumUninitialized(Period);
+	for (int64 Ahead = 1; Ahead <= Period; ++Ahead)
+	{
+		FutureScore[Ahead - 1] = Alpha * GetBestPastScore(CurrentFrame + Ahead);
+	}
+
+	// Prefer beats close to one period after the last beat
+	const float ExpectedAhead = FMath::Clamp<float>(LastBeatFrame + BeatPeriod - CurrentFrame, 1.f, Period);
+	const float Spread = FMath::Max(1.f, BeatPeriod / 2);
+
+	int64 BestAhead = Period;
+	float BestScore = -1;
+
+	for (int64 Ahead = 1; Ahead <= Period; ++Ahead)
+	{
+		const float Distance = (Ahead - ExpectedAhead) / Spread;
+		const float Score = FutureScore[Ahead - 1] * FMath::Exp(-0.5f * Distance * Distance);
+
+		if (Score > BestScore)
+		{
+			BestScore = Score;
+			BestAhead = Ahead;
+		}
+	}
+
+	NextBeatFrame = CurrentFrame + BestAhead;
+	PredictionFrame = NextBeatFrame + FMath::Max<int64>(1, Period / 2);
+}
+
+float UBeatTracker::GetBeatPhase() const
+{
+	const int64 BeatSpan = NextBeatFrame - LastBeatFrame;
+
+	if (BeatSpan <= 0 || CurrentFrame < 0)
+	{
+		return 0;
+	}
+
+	return FMath::Clamp(static_cast<float>(CurrentFrame - LastBeatFrame) / BeatSpan, 0.f, 1.f - KINDA_SMALL_NUMBER);
+}
+
+float UBeatTracker::GetTimeToNextBeat() const
+{
+	return FMath::Max<int64>(0, NextBeatFrame - CurrentFrame) * FrameDuration;
+}
+
+float UBeatTracker::GetNextBeatTimestamp() const
+{
+	return static_cast<float>(GetPreciseNextBeatTimestamp());
+}
+
+double UBeatTracker::GetPreciseNextBeatTimestamp() const
+{
+	return CurrentTimestamp + GetTimeToNextBeat();
+}
+
+float UBeatTracker::GetBPM() const
+{
+	return BeatPeriod > 0 && FrameDuration > 0 ? 60.f / (BeatPeriod * FrameDuration) : 0;
+}
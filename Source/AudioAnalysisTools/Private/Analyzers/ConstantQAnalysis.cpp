@@ -0,0 +1,253 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/ConstantQAnalysis.h"
+#include "Analyzers/FFTAudioAnalyzer.h"
+#include "AudioAnalysisToolsDefines.h"
+#include "Math/UnrealMathUtility.h"
+#include "Math/NumericLimits.h"
+
+namespace
+{
+	/** Kernel entries with a magnitude below this value are dropped from the sparse kernel (as in the original Brown-Puckette implementation) */
+	constexpr float ConstantQKernelThreshold = 0.0054f;
+
+	/** Number of pitch classes in the chroma vector */
+	constexpr int64 NumChromaBins = 12;
+}
+
+UConstantQAnalysis::UConstantQAnalysis()
+	: MinFrequency(0),
+	  BinsPerOctave(0),
+	  NumOctaves(0),
+	  ParametersRevision(0),
+	  KernelFFTSize(0),
+	  KernelSampleRate(0)
+{
+}
+
+UConstantQAnalysis* UConstantQAnalysis::CreateConstantQAnalysis(float InMinFrequency, int32 InBinsPerOctave, int32 InNumOctaves)
+{
+	UConstantQAnalysis* ConstantQAnalysis = NewObject<UConstantQAnalysis>();
+	ConstantQAnalysis->UpdateParameters(InMinFrequency, InBinsPerOctave, InNumOctaves);
+	return ConstantQAnalysis;
+}
+
+void UConstantQAnalysis::UpdateParameters(float InMinFrequency, int32 InBinsPerOctave, int32 InNumOctaves)
+{
+	if (InMinFrequency <= 0 || InBinsPerOctave <= 0 || InNumOctaves <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update Constant-Q parameters: min frequency ('%f'), bins per octave ('%d') and number of octaves ('%d') must all be > '0'"), InMinFrequency, InBinsPerOctave, InNumOctaves);
+		return;
+	}
+
+	UE_LOG(LogAudioAnalysis, Log, TEXT("Updating Constant-Q parameters: min frequency '%f', bins per octave '%d', number of octaves '%d'"), InMinFrequency, InBinsPerOctave, InNumOctaves);
+
+	MinFrequency = InMinFrequency;
+	BinsPerOctave = InBinsPerOctave;
+	NumOctaves = InNumOctaves;
+
+	ConstantQSpectrum.Init(0, static_cast<int64>(BinsPerOctave) * NumOctaves);
+	Chroma.Init(0, NumChromaBins);
+
+	// Force the kernel to be rebuilt on the next processed frame
+	KernelFFTSize = 0;
+	++ParametersRevision;
+}
+
+bool UConstantQAnalysis::ProcessFFT(const TArray<float>& FFTReal, const TArray<float>& FFTImaginary, int32 SampleRate)
+{
+	return ProcessFFT(TArray64<float>(FFTReal), TArray64<float>(FFTImaginary), SampleRate);
+}
+
+bool UConstantQAnalysis::ProcessFFT(const TArray64<float>& FFTReal, const TArray64<float>& FFTImaginary, int32 SampleRate)
+{
+	if (FFTReal.Num() != FFTImaginary.Num())
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot process Constant-Q transform: real FFT size ('%lld') must equal imaginary FFT size ('%lld')"), FFTReal.Num(), FFTImaginary.Num());
+		return false;
+	}
+
+	if (FFTReal.Num() <= 0 || SampleRate <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot process Constant-Q transform: FFT size ('%lld') and sample rate ('%d') must be > '0'"), FFTReal.Num(), SampleRate);
+		return false;
+	}
+
+	if (BinsPerOctave <= 0 || NumOctaves <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot process Constant-Q transform: the parameters have not been set"));
+		return false;
+	}
+
+	if (FFTReal.Num() != KernelFFTSize || SampleRate != KernelSampleRate)
+	{
+		UpdateKernel(FFTReal.Num(), SampleRate);
+	}
+
+	const int64 NumBins = ConstantQSpectrum.Num();
+
+	// Sparse matrix-vector product of the spectral kernel and the FFT frame
+	for (int64 Bin = 0; Bin < NumBins; ++Bin)
+	{
+		float SumReal = 0;
+		float SumImaginary = 0;
+
+		for (int64 EntryIndex = KernelRowOffsets[Bin]; EntryIndex < KernelRowOffsets[Bin + 1]; ++EntryIndex)
+		{
+			const int64 FFTIndex = KernelBinIndices[EntryIndex];
+
+			SumReal += FFTReal[FFTIndex] * KernelReal[EntryIndex] - FFTImaginary[FFTIndex] * KernelImaginary[EntryIndex];
+			SumImaginary += FFTReal[FFTIndex] * KernelImaginary[EntryIndex] + FFTImaginary[FFTIndex] * KernelReal[EntryIndex];
+		}
+
+		ConstantQSpectrum[Bin] = FMath::Sqrt(SumReal * SumReal + SumImaginary * SumImaginary);
+	}
+
+	// Fold the constant-Q bins into pitch classes
+	for (float& ChromaValue : Chroma)
+	{
+		ChromaValue = 0;
+	}
+
+	float MaxChromaValue = 0;
+
+	for (int64 Bin = 0; Bin < NumBins; ++Bin)
+	{
+		float& ChromaValue = Chroma[ChromaIndices[Bin]];
+		ChromaValue += ConstantQSpectrum[Bin];
+		MaxChromaValue = FMath::Max(MaxChromaValue, ChromaValue);
+	}
+
+	if (MaxChromaValue > 0)
+	{
+		for (float& ChromaValue : Chroma)
+		{
+			ChromaValue /= MaxChromaValue;
+		}
+	}
+
+	return true;
+}
+
+void UConstantQAnalysis::UpdateKernel(int64 FFTSize, int32 SampleRate)
+{
+	const int64 NumBins = static_cast<int64>(BinsPerOctave) * NumOctaves;
+	const double Q = 1. / (FMath::Pow(2., 1. / BinsPerOctave) - 1.);
+
+	KernelRowOffsets.Reset(NumBins + 1);
+	KernelBinIndices.Reset();
+	KernelReal.Reset();
+	KernelImaginary.Reset();
+	ChromaIndices.SetNum(NumBins);
+
+	KernelRowOffsets.Add(0);
+
+	FFTStateStruct* FFTState = UFFTAudioAnalyzer::PerformFFTAlloc(FFTSize, 0, nullptr, nullptr);
+
+	TArray64<FFTComplexSamples> TemporalKernel;
+	TemporalKernel.SetNumUninitialized(FFTSize);
+
+	TArray64<FFTComplexSamples> SpectralKernel;
+	SpectralKernel.SetNumUninitialized(FFTSize);
+
+	int64 NumClampedBins = 0;
+	int64 NumDroppedBins = 0;
+
+	for (int64 Bin = 0; Bin < NumBins; ++Bin)
+	{
+		const double BinFrequency = MinFrequency * FMath::Pow(2., static_cast<double>(Bin) / BinsPerOctave);
+
+		// Pitch class of the bin, where 0 is C (MIDI note 60 is C4)
+		const int32 MidiNote = FMath::RoundToInt(69. + 12. * FMath::Log2(BinFrequency / 440.));
+		ChromaIndices[Bin] = static_cast<int32>(((MidiNote % NumChromaBins) + NumChromaBins) % NumChromaBins);
+
+		// Bins above the Nyquist frequency cannot be represented and are left empty
+		if (BinFrequency >= SampleRate / 2.)
+		{
+			++NumDroppedBins;
+			KernelRowOffsets.Add(KernelBinIndices.Num());
+			continue;
+		}
+
+		// The window length is inversely proportional to the frequency. Windows longer than the FFT are clamped, which lowers Q for those bins
+		int64 WindowLength = static_cast<int64>(FMath::CeilToDouble(Q * SampleRate / BinFrequency));
+		if (WindowLength > FFTSize)
+		{
+			WindowLength = FFTSize;
+			++NumClampedBins;
+		}
+
+		FMemory::Memzero(TemporalKernel.GetData(), sizeof(FFTComplexSamples) * FFTSize);
+
+		// Center the temporal kernel in the frame
+		const int64 Offset = (FFTSize - WindowLength) / 2;
+
+		for (int64 Index = 0; Index < WindowLength; ++Index)
+		{
+			const double Window = WindowLength > 1 ? (0.54 - 0.46 * FMath::Cos(2. * PI * Index / (WindowLength - 1))) / WindowLength : 1.;
+			const double Phase = 2. * PI * BinFrequency * Index / SampleRate;
+
+			TemporalKernel[Offset + Index].Real = Window * FMath::Cos(Phase);
+			TemporalKernel[Offset + Index].Imaginary = Window * FMath::Sin(Phase);
+		}
+
+		UFFTAudioAnalyzer::PerformFFT(FFTState, TemporalKernel.GetData(), SpectralKernel.GetData());
+
+		// Keep only the significant entries, already conjugated and normalized so that the per-frame product is a plain complex multiply-add
+		for (int64 FFTIndex = 0; FFTIndex < FFTSize; ++FFTIndex)
+		{
+			const FFTComplexSamples& Entry = SpectralKernel[FFTIndex];
+
+			if (FMath::Sqrt(Entry.Real * Entry.Real + Entry.Imaginary * Entry.Imaginary) > ConstantQKernelThreshold)
+			{
+				KernelBinIndices.Add(FFTIndex);
+				KernelReal.Add(Entry.Real / FFTSize);
+				KernelImaginary.Add(-Entry.Imaginary / FFTSize);
+			}
+		}
+
+		KernelRowOffsets.Add(KernelBinIndices.Num());
+	}
+
+	FMemory::Free(FFTState);
+
+	if (NumClampedBins > 0)
+	{
+		UE_LOG(LogAudioAnalysis, Warning, TEXT("Constant-Q kernel: '%lld' low frequency bins need a longer window than the frame size ('%lld') and will have reduced resolution. Increase the frame size or the min frequency to avoid this"), NumClampedBins, FFTSize);
+	}
+
+	if (NumDroppedBins > 0)
+	{
+		UE_LOG(LogAudioAnalysis, Warning, TEXT("Constant-Q kernel: '%lld' bins are above the Nyquist frequency ('%f') and will always be zero"), NumDroppedBins, SampleRate / 2.);
+	}
+
+	UE_LOG(LogAudioAnalysis, Log, TEXT("Built Constant-Q kernel for FFT size '%lld' and sample rate '%d': '%lld' bins, '%lld' non-zero entries"), FFTSize, SampleRate, NumBins, KernelBinIndices.Num());
+
+	KernelFFTSize = FFTSize;
+	KernelSampleRate = SampleRate;
+}
+
+float UConstantQAnalysis::GetBinFrequency(int64 Bin) const
+{
+	if (!(Bin >= 0 && Bin < ConstantQSpectrum.Num()))
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot obtain Constant-Q bin frequency: the specified bin is '%lld', but it is expected to be >= '0' and < '%lld'"), Bin, ConstantQSpectrum.Num());
+		return -1;
+	}
+	return MinFrequency * FMath::Pow(2.f, static_cast<float>(Bin) / BinsPerOctave);
+}
+
+TArray<float> UConstantQAnalysis::GetConstantQSpectrum_BP() const
+{
+	if (ConstantQSpectrum.Num() > TNumericLimits<int32>::Max())
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to obtain Constant-Q spectrum: array with int32 size (max length: %d) cannot fit int64 size data (retrieved length: %lld)"), TNumericLimits<int32>::Max(), ConstantQSpectrum.Num());
+		return TArray<float>();
+	}
+	return TArray<float>(ConstantQSpectrum);
+}
+
+TArray<float> UConstantQAnalysis::GetChroma_BP() const
+{
+	return TArray<float>(Chroma);
+}
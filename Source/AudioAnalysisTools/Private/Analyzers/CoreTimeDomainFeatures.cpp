@@ -2,78 +2,136 @@
 
 #include "Analyzers/CoreTimeDomainFeatures.h"
 #include "AudioAnalysisToolsDefines.h"
+#include "Math/VectorRegister.h"
+#include "Misc/EngineVersionComparison.h"
 
-float UCoreTimeDomainFeatures::GetRootMeanSquare(const TArray<float>& AudioFrame)
+namespace
 {
-	return GetRootMeanSquare(TArray64<float>(AudioFrame));
-}
+#if UE_VERSION_OLDER_THAN(5, 0, 0)
+	using FFloatVector = VectorRegister;
+#else
+	using FFloatVector = VectorRegister4Float;
+#endif
 
-float UCoreTimeDomainFeatures::GetRootMeanSquare(const TArray64<float>& AudioFrame)
-{
-	float Sum = 0;
+	float HorizontalSum(const FFloatVector& Vector)
+	{
+		float Lanes[4];
+		VectorStore(Vector, Lanes);
+		return (Lanes[0] + Lanes[1]) + (Lanes[2] + Lanes[3]);
+	}
 
-	// Sum the squared samples
-	for (const float Frame : AudioFrame)
+	float HorizontalMax(const FFloatVector& Vector)
 	{
-		Sum += FMath::Pow(Frame, 2);
+		float Lanes[4];
+		VectorStore(Vector, Lanes);
+		return FMath::Max(FMath::Max(Lanes[0], Lanes[1]), FMath::Max(Lanes[2], Lanes[3]));
 	}
+}
+
+float UCoreTimeDomainFeatures::GetRootMeanSquare(const TArray<float>& AudioFrame)
+{
+	return GetFrameStats(TArrayView64<const float>(AudioFrame.GetData(), AudioFrame.Num())).RootMeanSquare;
+}
 
-	// Return the square root of the mean of squared samples
-	return FMath::Sqrt(Sum / static_cast<float>(AudioFrame.Num()));
+float UCoreTimeDomainFeatures::GetRootMeanSquare(const TArray64<float>& AudioFrame)
+{
+	return GetFrameStats(AudioFrame).RootMeanSquare;
 }
 
 float UCoreTimeDomainFeatures::GetPeakEnergy(const TArray<float>& AudioFrame)
 {
-	return GetPeakEnergy(TArray64<float>(AudioFrame));
+	return GetFrameStats(TArrayView64<const float>(AudioFrame.GetData(), AudioFrame.Num())).PeakEnergy;
 }
 
 float UCoreTimeDomainFeatures::GetPeakEnergy(const TArray64<float>& AudioFrame)
 {
-	// Create variable with very small value to hold the peak value
-	float Peak = -10000.f;
-
-	for (const float Frame : AudioFrame)
-	{
-		// Store the absolute value of the sample
-		const float AbsSample = FMath::Abs(Frame);
-
-		// If the absolute value is larger than the peak
-		if (AbsSample > Peak)
-		{
-			// The peak takes on the sample value
-			Peak = AbsSample;
-		}
-	}
-
-	return Peak;
+	return GetFrameStats(AudioFrame).PeakEnergy;
 }
 
 float UCoreTimeDomainFeatures::GetZeroCrossingRate(const TArray<float>& AudioFrame)
 {
-	return GetZeroCrossingRate(TArray64<float>(AudioFrame));
+	return GetFrameStats(TArrayView64<const float>(AudioFrame.GetData(), AudioFrame.Num())).ZeroCrossingRate;
 }
 
 float UCoreTimeDomainFeatures::GetZeroCrossingRate(const TArray64<float>& AudioFrame)
 {
-	// Create a variable to hold the zero crossing rate
-	float ZeroCrossingRateValue{0.f};
+	return GetFrameStats(AudioFrame).ZeroCrossingRate;
+}
 
-	// For each audio sample, starting from the second one
-	for (TArray64<float>::SizeType FrameIndex = 1; FrameIndex < AudioFrame.Num(); ++FrameIndex)
+FTimeDomainFrameStats UCoreTimeDomainFeatures::GetFrameStats(const TArray<float>& AudioFrames)
+{
+	return GetFrameStats(TArrayView64<const float>(AudioFrames.GetData(), AudioFrames.Num()));
+}
+
+FTimeDomainFrameStats UCoreTimeDomainFeatures::GetFrameStats(TArrayView64<const float> AudioFrames)
+{
+	FTimeDomainFrameStats Stats;
+
+	const int64 NumFrames = AudioFrames.Num();
+	if (NumFrames <= 0)
 	{
-		// Initialise two booleans indicating whether or not
-		// The current and previous sample are positive
-
-		const bool bIsCurrentPositive{AudioFrame[FrameIndex] > 0};
-		const bool bIsPreviousPositive{AudioFrame[FrameIndex - 1] > 0};
-
-		// If the sign is different
-		if (bIsCurrentPositive != bIsPreviousPositive)
-		{
-			// Add one to the zero crossing rate
-			ZeroCrossingRateValue += 1.0;
-		}
+		return Stats;
 	}
 
-	return ZeroCrossingRateValue;
+	const float* Frames = AudioFrames.GetData();
+
+	// The first sample has no predecessor to cross zero from, so it is accumulated on its own and the vector loop starts from the second one
+	float Sum = Frames[0];
+	float SumOfSquares = Frames[0] * Frames[0];
+	float Peak = FMath::Abs(Frames[0]);
+	float ZeroCrossings = 0;
+
+	// Two independent accumulators per feature, so consecutive vector additions do not wait for each other
+	const FFloatVector Zero = VectorZero();
+	const FFloatVector One = VectorOne();
+	FFloatVector Sum0 = Zero, Sum1 = Zero;
+	FFloatVector SumOfSquares0 = Zero, SumOfSquares1 = Zero;
+	FFloatVector Peak0 = Zero, Peak1 = Zero;
+	FFloatVector ZeroCrossings0 = Zero, ZeroCrossings1 = Zero;
+
+	int64 Index = 1;
+	for (; Index + 8 <= NumFrames; Index += 8)
+	{
+		const FFloatVector Current0 = VectorLoad(Frames + Index);
+		const FFloatVector Current1 = VectorLoad(Frames + Index + 4);
+		const FFloatVector Previous0 = VectorLoad(Frames + Index - 1);
+		const FFloatVector Previous1 = VectorLoad(Frames + Index + 3);
+
+		Sum0 = VectorAdd(Sum0, Current0);
+		Sum1 = VectorAdd(Sum1, Current1);
+
+		SumOfSquares0 = VectorMultiplyAdd(Current0, Current0, SumOfSquares0);
+		SumOfSquares1 = VectorMultiplyAdd(Current1, Current1, SumOfSquares1);
+
+		Peak0 = VectorMax(Peak0, VectorAbs(Current0));
+		Peak1 = VectorMax(Peak1, VectorAbs(Current1));
+
+		// A zero crossing is a lane where the "is positive" mask differs from the previous sample, counted as 1 without branching
+		ZeroCrossings0 = VectorAdd(ZeroCrossings0, VectorBitwiseAnd(VectorBitwiseXor(VectorCompareGT(Current0, Zero), VectorCompareGT(Previous0, Zero)), One));
+		ZeroCrossings1 = VectorAdd(ZeroCrossings1, VectorBitwiseAnd(VectorBitwiseXor(VectorCompareGT(Current1, Zero), VectorCompareGT(Previous1, Zero)), One));
+	}
+
+	Sum += HorizontalSum(VectorAdd(Sum0, Sum1));
+	SumOfSquares += HorizontalSum(VectorAdd(SumOfSquares0, SumOfSquares1));
+	Peak = FMath::Max(Peak, HorizontalMax(VectorMax(Peak0, Peak1)));
+	ZeroCrossings += HorizontalSum(VectorAdd(ZeroCrossings0, ZeroCrossings1));
+
+	// Remaining samples that do not fill a whole iteration
+	for (; Index < NumFrames; ++Index)
+	{
+		const float Frame = Frames[Index];
+
+		Sum += Frame;
+		SumOfSquares += Frame * Frame;
+		Peak = FMath::Max(Peak, FMath::Abs(Frame));
+		ZeroCrossings += (Frame > 0) != (Frames[Index - 1] > 0) ? 1.f : 0.f;
+	}
+
+	Stats.Energy = SumOfSquares;
+	Stats.RootMeanSquare = FMath::Sqrt(SumOfSquares / static_cast<float>(NumFrames));
+	Stats.PeakEnergy = Peak;
+	Stats.ZeroCrossingRate = ZeroCrossings;
+	Stats.DCOffset = Sum / static_cast<float>(NumFrames);
+
+	return Stats;
 }
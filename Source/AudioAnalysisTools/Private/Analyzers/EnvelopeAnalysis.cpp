@@ -0,0 +1,263 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/EnvelopeAnalysis.h"
+#include "AudioAnalysisToolsDefines.h"
+#include "Math/VectorRegister.h"
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+#if UE_VERSION_OLDER_THAN(5, 0, 0)
+	using FFloatVector = VectorRegister;
+#else
+	using FFloatVector = VectorRegister4Float;
+#endif
+
+	/** The maximum number of control values kept when they are not consumed */
+	constexpr int32 MaxPendingControlValues = 4096;
+
+	/** Calculate the one-pole coefficient for the time constant */
+	float CalculateCoefficient(float TimeConstant, int32 SampleRate)
+	{
+		return TimeConstant > 0 ? FMath::Exp(-1.f / (TimeConstant * SampleRate)) : 0.f;
+	}
+
+	/**
+	 * Follow a single channel of interleaved audio over a block of frames
+	 * The recursion is serial in time, so the envelope stays in a register for the whole block and the attack/release choice is a select rather than a branch
+	 */
+	template <bool bSquared>
+	float FollowChannel(const float* Samples, int64 NumFrames, int32 Stride, float Envelope, float AttackCoefficient, float ReleaseCoefficient)
+	{
+		for (int64 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+		{
+			const float Sample = Samples[FrameIndex * Stride];
+			const float Input = bSquared ? Sample * Sample : FMath::Abs(Sample);
+			const float Coefficient = Input > Envelope ? AttackCoefficient : ReleaseCoefficient;
+			Envelope = Input + Coefficient * (Envelope - Input);
+		}
+
+		return Envelope;
+	}
+
+	/**
+	 * Follow four adjacent channels of interleaved audio over a block of frames, one channel per vector lane
+	 * The channels are independent, so the serial recursion runs for all four at once
+	 */
+	template <bool bSquared>
+	void FollowChannels4(const float* Samples, int64 NumFrames, int32 Stride, float* Envelopes, float AttackCoefficient, float ReleaseCoefficient)
+	{
+		const FFloatVector Attack = VectorSetFloat1(AttackCoefficient);
+		const FFloatVector Release = VectorSetFloat1(ReleaseCoefficient);
+		FFloatVector Envelope = VectorLoad(Envelopes);
+
+		for (int64 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+		{
+			const FFloatVector Sample = VectorLoad(Samples + FrameIndex * Stride);
+			const FFloatVector Input = bSquared ? VectorMultiply(Sample, Sample) : VectorAbs(Sample);
+			const FFloatVector Coefficient = VectorSelect(VectorCompareGT(Input, Envelope), Attack, Release);
+			Envelope = VectorMultiplyAdd(Coefficient, VectorSubtract(Envelope, Input), Input);
+		}
+
+		VectorStore(Envelope, Envelopes);
+	}
+}
+
+UEnvelopeAnalysis::UEnvelopeAnalysis()
+	: Mode(EEnvelopeDetectionMode::Peak),
+	  AttackTime(0),
+	  ReleaseTime(0),
+	  ControlRate(120.f),
+	  SampleRate(0),
+	  AttackCoefficient(0),
+	  ReleaseCoefficient(0),
+	  FramesPerControlValue(1),
+	  FramesUntilControlValue(1),
+	  CombinedEnvelope(0)
+{
+}
+
+UEnvelopeAnalysis* UEnvelopeAnalysis::CreateEnvelopeAnalysis(EEnvelopeDetectionMode InMode, float InAttackTime, float InReleaseTime, float InControlRate)
+{
+	UEnvelopeAnalysis* EnvelopeAnalysis = NewObject<UEnvelopeAnalysis>();
+	EnvelopeAnalysis->UpdateParameters(InMode, InAttackTime, InReleaseTime, InControlRate);
+	return EnvelopeAnalysis;
+}
+
+void UEnvelopeAnalysis::UpdateParameters(EEnvelopeDetectionMode InMode, float InAttackTime, float InReleaseTime, float InControlRate)
+{
+	if (InAttackTime < 0 || InReleaseTime < 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update envelope analysis parameters: attack time is '%f' and release time is '%f', expected >= '0'"), InAttackTime, InReleaseTime);
+		return;
+	}
+
+	if (InControlRate <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update envelope analysis parameters: control rate is '%f', expected > '0'"), InControlRate);
+		return;
+	}
+
+	// The detector domain differs between the modes, so the running envelope cannot be carried over
+	if (InMode != Mode)
+	{
+		for (float& Envelope : Envelopes)
+		{
+			Envelope = InMode == EEnvelopeDetectionMode::RootMeanSquare ? Envelope * Envelope : FMath::Sqrt(Envelope);
+		}
+	}
+
+	Mode = InMode;
+	AttackTime = InAttackTime;
+	ReleaseTime = InReleaseTime;
+	ControlRate = InControlRate;
+
+	if (SampleRate > 0)
+	{
+		UpdateCoefficients(SampleRate);
+	}
+}
+
+void UEnvelopeAnalysis::Reset()
+{
+	Envelopes.Reset();
+	ControlEnvelopes.Reset();
+	CombinedEnvelope = 0;
+	FramesUntilControlValue = FramesPerControlValue;
+
+	FScopeLock Lock(&ControlValuesGuard);
+	PendingControlValues.Reset();
+}
+
+void UEnvelopeAnalysis::UpdateCoefficients(int32 InSampleRate)
+{
+	SampleRate = InSampleRate;
+	AttackCoefficient = CalculateCoefficient(AttackTime, SampleRate);
+	ReleaseCoefficient = CalculateCoefficient(ReleaseTime, SampleRate);
+
+	// The control rate cannot exceed the sample rate
+	FramesPerControlValue = FMath::Max(static_cast<double>(SampleRate) / ControlRate, 1.);
+	FramesUntilControlValue = FMath::Min(FramesUntilControlValue, FramesPerControlValue);
+}
+
+bool UEnvelopeAnalysis::ProcessAudioFrames(const TArray<float>& AudioFrames, int32 NumChannels, int32 InSampleRate)
+{
+	return ProcessAudioFrames(TArrayView64<const float>(AudioFrames.GetData(), AudioFrames.Num()), NumChannels, InSampleRate);
+}
+
+bool UEnvelopeAnalysis::ProcessAudioFrames(TArrayView64<const float> AudioFrames, int32 NumChannels, int32 InSampleRate)
+{
+	if (NumChannels <= 0 || InSampleRate <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to process audio frames for envelope analysis: number of channels is '%d' and sample rate is '%d', expected > '0'"), NumChannels, InSampleRate);
+		return false;
+	}
+
+	if (AudioFrames.Num() % NumChannels != 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to process audio frames for envelope analysis: the number of samples ('%lld') is not a multiple of the number of channels ('%d')"), AudioFrames.Num(), NumChannels);
+		return false;
+	}
+
+	if (InSampleRate != SampleRate)
+	{
+		UpdateCoefficients(InSampleRate);
+	}
+
+	if (Envelopes.Num() != NumChannels)
+	{
+		Envelopes.SetNumZeroed(NumChannels);
+		ControlEnvelopes.SetNumZeroed(NumChannels);
+	}
+
+	const bool bSquared = Mode == EEnvelopeDetectionMode::RootMeanSquare;
+	const int64 NumFrames = AudioFrames.Num() / NumChannels;
+	const float* Samples = AudioFrames.GetData();
+
+	TArray<float> NewControlValues;
+
+	int64 FrameIndex = 0;
+	while (FrameIndex < NumFrames)
+	{
+		// Process up to the next control point at once
+		const int64 NumBlockFrames = FMath::Min(NumFrames - FrameIndex, FMath::Max<int64>(static_cast<int64>(FMath::CeilToDouble(FramesUntilControlValue)), 1));
+
+		int32 Channel = 0;
+		for (; Channel + 4 <= NumChannels; Channel += 4)
+		{
+			const float* ChannelSamples = Samples + FrameIndex * NumChannels + Channel;
+			if (bSquared)
+			{
+				FollowChannels4<true>(ChannelSamples, NumBlockFrames, NumChannels, Envelopes.GetData() + Channel, AttackCoefficient, ReleaseCoefficient);
+			}
+			else
+			{
+				FollowChannels4<false>(ChannelSamples, NumBlockFrames, NumChannels, Envelopes.GetData() + Channel, AttackCoefficient, ReleaseCoefficient);
+			}
+		}
+
+		// The remaining channels (all of them for mono and stereo audio) are followed one at a time
+		for (; Channel < NumChannels; ++Channel)
+		{
+			const float* ChannelSamples = Samples + FrameIndex * NumChannels + Channel;
+			Envelopes[Channel] = bSquared
+				                     ? FollowChannel<true>(ChannelSamples, NumBlockFrames, NumChannels, Envelopes[Channel], AttackCoefficient, ReleaseCoefficient)
+				                     : FollowChannel<false>(ChannelSamples, NumBlockFrames, NumChannels, Envelopes[Channel], AttackCoefficient, ReleaseCoefficient);
+		}
+
+		FrameIndex += NumBlockFrames;
+		FramesUntilControlValue -= NumBlockFrames;
+
+		if (FramesUntilControlValue <= 0)
+		{
+			FramesUntilControlValue += FramesPerControlValue;
+
+			float MaxEnvelope = 0;
+			for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+			{
+				ControlEnvelopes[Channel] = bSquared ? FMath::Sqrt(Envelopes[Channel]) : Envelopes[Channel];
+				MaxEnvelope = FMath::Max(MaxEnvelope, ControlEnvelopes[Channel]);
+			}
+
+			CombinedEnvelope = MaxEnvelope;
+			NewControlValues.Add(MaxEnvelope);
+		}
+	}
+
+	if (NewControlValues.Num() > 0)
+	{
+		FScopeLock Lock(&ControlValuesGuard);
+
+		PendingControlValues.Append(NewControlValues);
+
+		if (PendingControlValues.Num() > MaxPendingControlValues)
+		{
+			UE_LOG(LogAudioAnalysis, Verbose, TEXT("Envelope control values are not being consumed, dropping the oldest ones"));
+			PendingControlValues.RemoveAt(0, PendingControlValues.Num() - MaxPendingControlValues);
+		}
+	}
+
+	return true;
+}
+
+float UEnvelopeAnalysis::GetEnvelope(int32 Channel) const
+{
+	if (!ControlEnvelopes.IsValidIndex(Channel))
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to get the envelope: channel '%d' is out of range, expected >= '0' and < '%d'"), Channel, ControlEnvelopes.Num());
+		return 0;
+	}
+
+	return ControlEnvelopes[Channel];
+}
+
+bool UEnvelopeAnalysis::ConsumeControlValues(TArray<float>& ControlValues)
+{
+	FScopeLock Lock(&ControlValuesGuard);
+
+	ControlValues = MoveTemp(PendingControlValues);
+	PendingControlValues.Reset();
+
+	return ControlValues.Num() > 0;
+}
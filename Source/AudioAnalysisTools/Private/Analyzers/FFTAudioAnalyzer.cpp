@@ -4,6 +4,7 @@
 
 #include "AudioAnalysisToolsDefines.h"
 #include "Math/UnrealMathUtility.h"
+#include "Math/VectorRegister.h"
 #include "Misc/EngineVersionComparison.h"
 
 #include "Async/ParallelFor.h"
@@ -338,6 +339,42 @@ void UFFTAudioAnalyzer::PerformFFT(FFTStateStruct* FFTState, const FFTComplexSam
 	PerformFFTStride(FFTState, SamplesIn, SamplesOut, 1);
 }
 
+int64 UFFTAudioAnalyzer::GetNextFastSize(int64 Size)
+{
+	if (Size <= 1)
+	{
+		return 1;
+	}
+
+	for (int64 Candidate = Size;; ++Candidate)
+	{
+		int64 Remainder = Candidate;
+
+		while (Remainder % 2 == 0)
+		{
+			Remainder /= 2;
+		}
+		while (Remainder % 3 == 0)
+		{
+			Remainder /= 3;
+		}
+		while (Remainder % 5 == 0)
+		{
+			Remainder /= 5;
+		}
+
+		if (Remainder == 1)
+		{
+			return Candidate;
+		}
+	}
+}
+
+float UFFTAudioAnalyzer::GetBinFrequency(int64 Bin, int64 FFTSize, int32 SampleRate)
+{
+	return FFTSize > 0 ? static_cast<float>(static_cast<double>(Bin) * SampleRate / FFTSize) : 0.f;
+}
+
 void CalculateFactors(int64 Number, int64* Factors)
 {
 	int64 Primes = 4;
@@ -422,3 +459,180 @@ FFTStateStruct* UFFTAudioAnalyzer::PerformFFTAlloc(int64 NFFT, int64 Inverse_FFT
 
 	return FFTState;
 }
+
+namespace
+{
+#if UE_VERSION_OLDER_THAN(5, 0, 0)
+	using FFloatVector = VectorRegister;
+
+	FFloatVector VectorSquareRoot(const FFloatVector& Vector)
+	{
+		float Lanes[4];
+		VectorStore(Vector, Lanes);
+		return MakeVectorRegister(FMath::Sqrt(Lanes[0]), FMath::Sqrt(Lanes[1]), FMath::Sqrt(Lanes[2]), FMath::Sqrt(Lanes[3]));
+	}
+#else
+	using FFloatVector = VectorRegister4Float;
+
+	FFloatVector VectorSquareRoot(const FFloatVector& Vector)
+	{
+		return VectorSqrt(Vector);
+	}
+#endif
+
+	/** The power the decibel spectrum is floored at, equal to -200 dB */
+	constexpr float MinDecibelPower = 1e-20f;
+
+	float PowerToDecibels(float Power)
+	{
+		return 10.f * FMath::LogX(10.f, FMath::Max(Power, MinDecibelPower));
+	}
+}
+
+void UFFTAudioAnalyzer::WindowAndPack(const float* AudioFrames, const float* Window, int64 FrameSize, FFTComplexSamples* SamplesOut)
+{
+	// FFTComplexSamples is a pair of floats, so the input is written as interleaved (real, 0) lanes
+	float* PackedOut = reinterpret_cast<float*>(SamplesOut);
+	const FFloatVector Zero = VectorZero();
+
+	int64 Index = 0;
+	for (; Index + 4 <= FrameSize; Index += 4)
+	{
+		const FFloatVector Windowed = VectorMultiply(VectorLoad(AudioFrames + Index), VectorLoad(Window + Index));
+
+		// (w0, w1, 0, 0) -> (w0, 0, w1, 0) and (w2, w3, 0, 0) -> (w2, 0, w3, 0)
+		VectorStore(VectorSwizzle(VectorShuffle(Windowed, Zero, 0, 1, 0, 0), 0, 2, 1, 3), PackedOut + 2 * Index);
+		VectorStore(VectorSwizzle(VectorShuffle(Windowed, Zero, 2, 3, 0, 0), 0, 2, 1, 3), PackedOut + 2 * Index + 4);
+	}
+
+	for (; Index < FrameSize; ++Index)
+	{
+		SamplesOut[Index].Real = AudioFrames[Index] * Window[Index];
+		SamplesOut[Index].Imaginary = 0.f;
+	}
+}
+
+void UFFTAudioAnalyzer::UnpackSpectrum(const FFTComplexSamples* Samples, int64 FrameSize, float* OutReal, float* OutImaginary, int64 NumBins, float* OutMagnitude, float* OutPower, float* OutDecibels)
+{
+	const float* Packed = reinterpret_cast<const float*>(Samples);
+	NumBins = FMath::Clamp<int64>(NumBins, 0, FrameSize);
+
+	const bool bNeedsPower = OutMagnitude || OutPower || OutDecibels;
+
+	// The bins with spectra
+	int64 Index = 0;
+	for (; Index + 4 <= NumBins; Index += 4)
+	{
+		const FFloatVector Low = VectorLoad(Packed + 2 * Index);
+		const FFloatVector High = VectorLoad(Packed + 2 * Index + 4);
+
+		// (r0, i0, r1, i1), (r2, i2, r3, i3) -> (r0, r1, r2, r3), (i0, i1, i2, i3)
+		const FFloatVector Real = VectorShuffle(Low, High, 0, 2, 0, 2);
+		const FFloatVector Imaginary = VectorShuffle(Low, High, 1, 3, 1, 3);
+
+		if (OutReal)
+		{
+			VectorStore(Real, OutReal + Index);
+		}
+
+		if (OutImaginary)
+		{
+			VectorStore(Imaginary, OutImaginary + Index);
+		}
+
+		if (!bNeedsPower)
+		{
+			continue;
+		}
+
+		const FFloatVector Power = VectorMultiplyAdd(Real, Real, VectorMultiply(Imaginary, Imaginary));
+
+		if (OutMagnitude)
+		{
+			VectorStore(VectorSquareRoot(Power), OutMagnitude + Index);
+		}
+
+		if (OutPower)
+		{
+			VectorStore(Power, OutPower + Index);
+		}
+
+		if (OutDecibels)
+		{
+			float PowerLanes[4];
+			VectorStore(Power, PowerLanes);
+
+			for (int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				OutDecibels[Index + Lane] = PowerToDecibels(PowerLanes[Lane]);
+			}
+		}
+	}
+
+	for (; Index < NumBins; ++Index)
+	{
+		const float Real = Samples[Index].Real;
+		const float Imaginary = Samples[Index].Imaginary;
+		const float Power = Real * Real + Imaginary * Imaginary;
+
+		if (OutReal)
+		{
+			OutReal[Index] = Real;
+		}
+
+		if (OutImaginary)
+		{
+			OutImaginary[Index] = Imaginary;
+		}
+
+		if (OutMagnitude)
+		{
+			OutMagnitude[Index] = FMath::Sqrt(Power);
+		}
+
+		if (OutPower)
+		{
+			OutPower[Index] = Power;
+		}
+
+		if (OutDecibels)
+		{
+			OutDecibels[Index] = PowerToDecibels(Power);
+		}
+	}
+
+	if (!OutReal && !OutImaginary)
+	{
+		return;
+	}
+
+	// The remaining samples are only copied out
+	for (; Index + 4 <= FrameSize; Index += 4)
+	{
+		const FFloatVector Low = VectorLoad(Packed + 2 * Index);
+		const FFloatVector High = VectorLoad(Packed + 2 * Index + 4);
+
+		if (OutReal)
+		{
+			VectorStore(VectorShuffle(Low, High, 0, 2, 0, 2), OutReal + Index);
+		}
+
+		if (OutImaginary)
+		{
+			VectorStore(VectorShuffle(Low, High, 1, 3, 1, 3), OutImaginary + Index);
+		}
+	}
+
+	for (; Index < FrameSize; ++Index)
+	{
+		if (OutReal)
+		{
+			OutReal[Index] = Samples[Index].Real;
+		}
+
+		if (OutImaginary)
+		{
+			OutImaginary[Index] = Samples[Index].Imaginary;
+		}
+	}
+}
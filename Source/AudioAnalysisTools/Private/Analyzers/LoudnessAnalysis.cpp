@@ -0,0 +1,457 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/LoudnessAnalysis.h"
+#include "AudioAnalysisToolsDefines.h"
+#include "Sound/ImportedSoundWave.h"
+#include "Async/ParallelFor.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	/** The duration of the blocks the energy is accumulated into, in seconds */
+	constexpr double BlockDuration = 0.1;
+
+	/** The number of blocks in the momentary (400 ms) window, which is also the gating block */
+	constexpr int32 NumMomentaryBlocks = 4;
+
+	/** The number of blocks in the short-term (3 s) window */
+	constexpr int32 NumShortTermBlocks = 30;
+
+	/** Gating blocks below this loudness are ignored by the integrated loudness, in LUFS */
+	constexpr float AbsoluteGate = -70.f;
+
+	/** Gating blocks this far below the absolute-gated loudness are ignored by the integrated loudness, in LU */
+	constexpr float RelativeGate = -10.f;
+
+	/** The loudness of the highest histogram bin, in LUFS. Louder blocks are counted in that bin */
+	constexpr float MaxHistogramLoudness = 5.f;
+
+	/** The width of the histogram bins, in LU */
+	constexpr float HistogramResolution = 0.01f;
+
+	/** The loudness reported for silence, in LUFS */
+	constexpr float SilenceLoudness = -144.f;
+
+	/** The number of blocks analyzed by one task of the offline analysis */
+	constexpr int64 BlocksPerChunk = 100;
+
+	/** The duration of the audio preceding a chunk that is filtered only to settle the filter states, in seconds */
+	constexpr double WarmUpDuration = 1.;
+
+	constexpr double Pi = 3.14159265358979323846;
+
+	float EnergyToLoudness(double Energy)
+	{
+		// -0.691 compensates the gain of the K-weighting at 1 kHz
+		return Energy > 0 ? FMath::Max(static_cast<float>(-0.691 + 10. * FMath::Loge(Energy) / FMath::Loge(10.)), SilenceLoudness) : SilenceLoudness;
+	}
+
+	int64 GetHistogramBin(float Loudness)
+	{
+		constexpr int64 NumBins = static_cast<int64>((MaxHistogramLoudness - AbsoluteGate) / HistogramResolution);
+		return FMath::Clamp<int64>(FMath::FloorToInt((Loudness - AbsoluteGate) / HistogramResolution), 0, NumBins - 1);
+	}
+
+	/**
+	 * Calculate the two K-weighting stages of ITU-R BS.1770 for the sample rate
+	 * The analog prototypes are re-discretized, so the coefficients match the published 48 kHz ones and stay correct for other sample rates
+	 */
+	void CalculateKWeighting(int32 SampleRate, FLoudnessBiquadCoefficients& Shelf, FLoudnessBiquadCoefficients& HighPass)
+	{
+		// High shelf modeling the acoustic effect of the head
+		{
+			constexpr double CenterFrequency = 1681.974450955533;
+			constexpr double GainDecibels = 3.999843853973347;
+			constexpr double Q = 0.7071752369554196;
+
+			const double K = FMath::Tan(Pi * CenterFrequency / SampleRate);
+			const double HighGain = FMath::Pow(10., GainDecibels / 20.);
+			const double BandGain = FMath::Pow(HighGain, 0.4996667741545416);
+			const double A0 = 1. + K / Q + K * K;
+
+			Shelf.B0 = (HighGain + BandGain * K / Q + K * K) / A0;
+			Shelf.B1 = 2. * (K * K - HighGain) / A0;
+			Shelf.B2 = (HighGain - BandGain * K / Q + K * K) / A0;
+			Shelf.A1 = 2. * (K * K - 1.) / A0;
+			Shelf.A2 = (1. - K / Q + K * K) / A0;
+		}
+
+		// High pass (RLB weighting)
+		{
+			constexpr double CenterFrequency = 38.13547087602444;
+			constexpr double Q = 0.5003270373238773;
+
+			const double K = FMath::Tan(Pi * CenterFrequency / SampleRate);
+			const double A0 = 1. + K / Q + K * K;
+
+			HighPass.B0 = 1.;
+			HighPass.B1 = -2.;
+			HighPass.B2 = 1.;
+			HighPass.A1 = 2. * (K * K - 1.) / A0;
+			HighPass.A2 = (1. - K / Q + K * K) / A0;
+		}
+	}
+
+	/** Calculate the weight of each channel. 5.1 layouts skip the LFE and boost the surrounds, everything else is weighted equally */
+	void CalculateChannelWeights(int32 NumChannels, TArray<float>& ChannelWeights)
+	{
+		ChannelWeights.Init(1.f, NumChannels);
+
+		if (NumChannels == 6)
+		{
+			ChannelWeights[3] = 0.f;
+			ChannelWeights[4] = 1.41f;
+			ChannelWeights[5] = 1.41f;
+		}
+	}
+
+	/**
+	 * K-weight a single channel of interleaved audio and sum the squares of the output
+	 *
+	 * @param Samples The first sample of the channel
+	 * @param NumFrames The number of frames to process
+	 * @param Stride The number of interleaved channels
+	 * @param Shelf The first K-weighting stage
+	 * @param HighPass The second K-weighting stage
+	 * @param States The four filter states of the channel (transposed direct form II), updated in place
+	 * @return The sum of the squared K-weighted samples
+	 */
+	double FilterSquaredSum(const float* Samples, int64 NumFrames, int32 Stride, const FLoudnessBiquadCoefficients& Shelf, const FLoudnessBiquadCoefficients& HighPass, double* States)
+	{
+		double ShelfState1 = States[0], ShelfState2 = States[1];
+		double HighPassState1 = States[2], HighPassState2 = States[3];
+		double Sum = 0;
+
+		for (int64 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+		{
+			const double Input = Samples[FrameIndex * Stride];
+
+			const double Shelved = Shelf.B0 * Input + ShelfState1;
+			ShelfState1 = Shelf.B1 * Input - Shelf.A1 * Shelved + ShelfState2;
+			ShelfState2 = Shelf.B2 * Input - Shelf.A2 * Shelved;
+
+			const double Weighted = HighPass.B0 * Shelved + HighPassState1;
+			HighPassState1 = HighPass.B1 * Shelved - HighPass.A1 * Weighted + HighPassState2;
+			HighPassState2 = HighPass.B2 * Shelved - HighPass.A2 * Weighted;
+
+			Sum += Weighted * Weighted;
+		}
+
+		States[0] = ShelfState1;
+		States[1] = ShelfState2;
+		States[2] = HighPassState1;
+		States[3] = HighPassState2;
+
+		return Sum;
+	}
+}
+
+FLoudnessGatingHistogram::FLoudnessGatingHistogram()
+	: NumBlocks(0),
+	  TotalEnergy(0)
+{
+}
+
+void FLoudnessGatingHistogram::Reset()
+{
+	BinCounts.Reset();
+	BinEnergies.Reset();
+	NumBlocks = 0;
+	TotalEnergy = 0;
+}
+
+void FLoudnessGatingHistogram::Add(double Energy)
+{
+	const float Loudness = EnergyToLoudness(Energy);
+	if (Loudness <= AbsoluteGate)
+	{
+		return;
+	}
+
+	// Allocated on the first block, so unused meters do not hold the bins
+	if (BinCounts.Num() <= 0)
+	{
+		const int64 NumBins = GetHistogramBin(MaxHistogramLoudness) + 1;
+		BinCounts.SetNumZeroed(NumBins);
+		BinEnergies.SetNumZeroed(NumBins);
+	}
+
+	const int64 Bin = GetHistogramBin(Loudness);
+	++BinCounts[Bin];
+	BinEnergies[Bin] += Energy;
+
+	++NumBlocks;
+	TotalEnergy += Energy;
+}
+
+float FLoudnessGatingHistogram::GetIntegratedLoudness() const
+{
+	if (NumBlocks <= 0)
+	{
+		return SilenceLoudness;
+	}
+
+	const float RelativeThreshold = EnergyToLoudness(TotalEnergy / NumBlocks) + RelativeGate;
+
+	int64 GatedNumBlocks = 0;
+	double GatedEnergy = 0;
+
+	// The bin holding the relative threshold is counted whole, which limits the error to the bin width
+	for (int64 Bin = GetHistogramBin(RelativeThreshold); Bin < BinCounts.Num(); ++Bin)
+	{
+		GatedNumBlocks += BinCounts[Bin];
+		GatedEnergy += BinEnergies[Bin];
+	}
+
+	return GatedNumBlocks > 0 ? EnergyToLoudness(GatedEnergy / GatedNumBlocks) : SilenceLoudness;
+}
+
+ULoudnessAnalysis::ULoudnessAnalysis()
+	: NumChannels(0),
+	  SampleRate(0),
+	  FramesPerBlock(0),
+	  NumBlockFrames(0),
+	  BlockPosition(0),
+	  NumBlocks(0),
+	  MomentaryLoudness(SilenceLoudness),
+	  ShortTermLoudness(SilenceLoudness),
+	  MaxMomentaryLoudness(SilenceLoudness)
+{
+}
+
+ULoudnessAnalysis* ULoudnessAnalysis::CreateLoudnessAnalysis()
+{
+	return NewObject<ULoudnessAnalysis>();
+}
+
+void ULoudnessAnalysis::Reset()
+{
+	FilterStates.Init(0, NumChannels * 4);
+	BlockChannelSums.Init(0, NumChannels);
+	BlockEnergies.Init(0, NumShortTermBlocks);
+
+	NumBlockFrames = 0;
+	BlockPosition = 0;
+	NumBlocks = 0;
+
+	MomentaryLoudness = SilenceLoudness;
+	ShortTermLoudness = SilenceLoudness;
+	MaxMomentaryLoudness = SilenceLoudness;
+
+	GatingHistogram.Reset();
+}
+
+void ULoudnessAnalysis::Configure(int32 InNumChannels, int32 InSampleRate)
+{
+	NumChannels = InNumChannels;
+	SampleRate = InSampleRate;
+	FramesPerBlock = FMath::Max<int64>(FMath::RoundToInt(SampleRate * BlockDuration), 1);
+
+	CalculateKWeighting(SampleRate, ShelfCoefficients, HighPassCoefficients);
+	CalculateChannelWeights(NumChannels, ChannelWeights);
+
+	Reset();
+}
+
+bool ULoudnessAnalysis::ProcessAudioFrames(const TArray<float>& AudioFrames, int32 InNumChannels, int32 InSampleRate)
+{
+	return ProcessAudioFrames(TArrayView64<const float>(AudioFrames.GetData(), AudioFrames.Num()), InNumChannels, InSampleRate);
+}
+
+bool ULoudnessAnalysis::ProcessAudioFrames(TArrayView64<const float> AudioFrames, int32 InNumChannels, int32 InSampleRate)
+{
+	if (InNumChannels <= 0 || InSampleRate <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to process audio frames for loudness analysis: number of channels is '%d' and sample rate is '%d', expected > '0'"), InNumChannels, InSampleRate);
+		return false;
+	}
+
+	if (AudioFrames.Num() % InNumChannels != 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to process audio frames for loudness analysis: the number of samples ('%lld') is not a multiple of the number of channels ('%d')"), AudioFrames.Num(), InNumChannels);
+		return false;
+	}
+
+	if (InNumChannels != NumChannels || InSampleRate != SampleRate)
+	{
+		Configure(InNumChannels, InSampleRate);
+	}
+
+	const int64 NumFrames = AudioFrames.Num() / NumChannels;
+	const float* Samples = AudioFrames.GetData();
+
+	int64 FrameIndex = 0;
+	while (FrameIndex < NumFrames)
+	{
+		// Process up to the end of the current block at once
+		const int64 NumFramesToProcess = FMath::Min(NumFrames - FrameIndex, FramesPerBlock - NumBlockFrames);
+
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			BlockChannelSums[Channel] += FilterSquaredSum(Samples + FrameIndex * NumChannels + Channel, NumFramesToProcess, NumChannels, ShelfCoefficients, HighPassCoefficients, FilterStates.GetData() + Channel * 4);
+		}
+
+		FrameIndex += NumFramesToProcess;
+		NumBlockFrames += NumFramesToProcess;
+
+		if (NumBlockFrames == FramesPerBlock)
+		{
+			FinishBlock();
+		}
+	}
+
+	return true;
+}
+
+void ULoudnessAnalysis::FinishBlock()
+{
+	double BlockEnergy = 0;
+	for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+	{
+		BlockEnergy += ChannelWeights[Channel] * BlockChannelSums[Channel] / FramesPerBlock;
+		BlockChannelSums[Channel] = 0;
+	}
+
+	BlockEnergies[BlockPosition] = BlockEnergy;
+	BlockPosition = (BlockPosition + 1) % NumShortTermBlocks;
+	NumBlockFrames = 0;
+	++NumBlocks;
+
+	// The blocks before the first one are treated as silence
+	double MomentaryEnergy = 0;
+	double ShortTermEnergy = 0;
+	for (int32 Age = 0; Age < NumShortTermBlocks; ++Age)
+	{
+		const double Energy = BlockEnergies[(BlockPosition - 1 - Age + NumShortTermBlocks) % NumShortTermBlocks];
+		MomentaryEnergy += Age < NumMomentaryBlocks ? Energy : 0;
+		ShortTermEnergy += Energy;
+	}
+	MomentaryEnergy /= NumMomentaryBlocks;
+	ShortTermEnergy /= NumShortTermBlocks;
+
+	MomentaryLoudness = EnergyToLoudness(MomentaryEnergy);
+	ShortTermLoudness = EnergyToLoudness(ShortTermEnergy);
+
+	// Each momentary window is a gating block (400 ms, overlapping by 75%) once it lies fully within the audio
+	if (NumBlocks >= NumMomentaryBlocks)
+	{
+		GatingHistogram.Add(MomentaryEnergy);
+		MaxMomentaryLoudness = FMath::Max(MaxMomentaryLoudness, MomentaryLoudness);
+	}
+}
+
+float ULoudnessAnalysis::GetIntegratedLoudness() const
+{
+	return GatingHistogram.GetIntegratedLoudness();
+}
+
+bool ULoudnessAnalysis::AnalyzeImportedSoundWave(UImportedSoundWave* ImportedSoundWave, FLoudnessStatistics& Statistics)
+{
+	if (!ImportedSoundWave)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to analyze loudness: the specified sound wave is invalid"));
+		return false;
+	}
+
+	FScopeLock Lock(&*ImportedSoundWave->DataGuard);
+
+	if (!ImportedSoundWave->GetPCMBuffer().IsValid())
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to analyze loudness: PCM buffer is invalid"));
+		return false;
+	}
+
+	const int32 NumChannels = ImportedSoundWave->NumChannels;
+	const int32 SampleRate = ImportedSoundWave->GetSampleRate();
+
+	if (NumChannels <= 0 || SampleRate <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to analyze loudness: number of channels is '%d' and sample rate is '%d', expected > '0'"), NumChannels, SampleRate);
+		return false;
+	}
+
+	const float* PCMData = ImportedSoundWave->GetPCMBuffer().PCMData.GetView().GetData();
+	const int64 NumFrames = static_cast<int64>(ImportedSoundWave->GetPCMBuffer().PCMData.GetView().Num()) / NumChannels;
+	const int64 FramesPerBlock = FMath::Max<int64>(FMath::RoundToInt(SampleRate * BlockDuration), 1);
+	const int64 NumTotalBlocks = NumFrames / FramesPerBlock;
+
+	if (NumTotalBlocks < NumMomentaryBlocks)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to analyze loudness: the sound wave has '%lld' frames, expected at least '%lld' (400 ms)"), NumFrames, FramesPerBlock * NumMomentaryBlocks);
+		return false;
+	}
+
+	FLoudnessBiquadCoefficients Shelf, HighPass;
+	CalculateKWeighting(SampleRate, Shelf, HighPass);
+
+	TArray<float> ChannelWeights;
+	CalculateChannelWeights(NumChannels, ChannelWeights);
+
+	TArray64<double> BlockEnergies;
+	BlockEnergies.SetNumZeroed(NumTotalBlocks);
+
+	const int64 NumWarmUpFrames = static_cast<int64>(SampleRate * WarmUpDuration);
+	const int32 NumChunks = static_cast<int32>((NumTotalBlocks + BlocksPerChunk - 1) / BlocksPerChunk);
+
+	// The filters are recursive, so each chunk restarts them on the audio just before it instead of waiting for the previous chunk
+	ParallelFor(NumChunks, [&](int32 ChunkIndex)
+	{
+		const int64 FirstBlock = ChunkIndex * BlocksPerChunk;
+		const int64 EndBlock = FMath::Min(FirstBlock + BlocksPerChunk, NumTotalBlocks);
+		const int64 ChunkStartFrame = FirstBlock * FramesPerBlock;
+		const int64 WarmUpStartFrame = FMath::Max<int64>(ChunkStartFrame - NumWarmUpFrames, 0);
+
+		TArray<double> States;
+		States.SetNumZeroed(NumChannels * 4);
+
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			FilterSquaredSum(PCMData + WarmUpStartFrame * NumChannels + Channel, ChunkStartFrame - WarmUpStartFrame, NumChannels, Shelf, HighPass, States.GetData() + Channel * 4);
+		}
+
+		for (int64 Block = FirstBlock; Block < EndBlock; ++Block)
+		{
+			double BlockEnergy = 0;
+			for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+			{
+				const double Sum = FilterSquaredSum(PCMData + Block * FramesPerBlock * NumChannels + Channel, FramesPerBlock, NumChannels, Shelf, HighPass, States.GetData() + Channel * 4);
+				BlockEnergy += ChannelWeights[Channel] * Sum / FramesPerBlock;
+			}
+			BlockEnergies[Block] = BlockEnergy;
+		}
+	});
+
+	FLoudnessGatingHistogram Histogram;
+	float MaxMomentaryLoudness = SilenceLoudness;
+	float MaxShortTermLoudness = SilenceLoudness;
+
+	for (int64 Block = 0; Block < NumTotalBlocks; ++Block)
+	{
+		// Same windows as the streaming meter, with the blocks before the start treated as silence
+		double ShortTermEnergy = 0;
+		for (int64 Window = FMath::Max<int64>(Block - NumShortTermBlocks + 1, 0); Window <= Block; ++Window)
+		{
+			ShortTermEnergy += BlockEnergies[Window];
+		}
+		MaxShortTermLoudness = FMath::Max(MaxShortTermLoudness, EnergyToLoudness(ShortTermEnergy / NumShortTermBlocks));
+
+		if (Block + 1 >= NumMomentaryBlocks)
+		{
+			double MomentaryEnergy = 0;
+			for (int64 Window = Block - NumMomentaryBlocks + 1; Window <= Block; ++Window)
+			{
+				MomentaryEnergy += BlockEnergies[Window];
+			}
+			MomentaryEnergy /= NumMomentaryBlocks;
+
+			Histogram.Add(MomentaryEnergy);
+			MaxMomentaryLoudness = FMath::Max(MaxMomentaryLoudness, EnergyToLoudness(MomentaryEnergy));
+		}
+	}
+
+	Statistics.IntegratedLoudness = Histogram.GetIntegratedLoudness();
+	Statistics.MaxMomentaryLoudness = MaxMomentaryLoudness;
+	Statistics.MaxShortTermLoudness = MaxShortTermLoudness;
+
+	return true;
+}
@@ -0,0 +1,305 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/MultiResolutionAnalysis.h"
+#include "AudioAnalysisToolsDefines.h"
+#include "Misc/ScopeLock.h"
+
+UMultiResolutionAnalysis::UMultiResolutionAnalysis()
+	: SampleRate(0)
+{
+}
+
+void UMultiResolutionAnalysis::BeginDestroy()
+{
+	FreeFFTConfigurations();
+
+	Super::BeginDestroy();
+}
+
+UMultiResolutionAnalysis* UMultiResolutionAnalysis::CreateMultiResolutionAnalysis(const TArray<FAnalysisResolution>& Resolutions, EAnalysisWindowType WindowType)
+{
+	UMultiResolutionAnalysis* MultiResolutionAnalysis = NewObject<UMultiResolutionAnalysis>();
+	MultiResolutionAnalysis->UpdateParameters(Resolutions, WindowType);
+	return MultiResolutionAnalysis;
+}
+
+bool UMultiResolutionAnalysis::UpdateParameters(const TArray<FAnalysisResolution>& Resolutions, EAnalysisWindowType WindowType)
+{
+	for (const FAnalysisResolution& Resolution : Resolutions)
+	{
+		if (Resolution.FrameSize < 2 || Resolution.HopSize <= 0)
+		{
+			UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update multi-resolution analysis parameters: the frame size is '%lld' and the hop size is '%lld', expected >= '2' and > '0'"), Resolution.FrameSize, Resolution.HopSize);
+			return false;
+		}
+	}
+
+	FScopeLock Lock(&DataGuard);
+
+	FreeFFTConfigurations();
+	Streams.Reset();
+	States.Reset();
+
+	for (const FAnalysisResolution& Resolution : Resolutions)
+	{
+		FResolutionState& State = States.AddDefaulted_GetRef();
+		State.Resolution = Resolution;
+
+		// Resolutions with the same decimation share one stream, so the input is decimated once per factor
+		State.StreamIndex = Streams.IndexOfByPredicate([&Resolution](const FDecimatedStream& Stream)
+		{
+			return Stream.Decimator.GetFactor() == Resolution.Decimation;
+		});
+
+		if (State.StreamIndex == INDEX_NONE)
+		{
+			State.StreamIndex = Streams.AddDefaulted();
+			Streams[State.StreamIndex].Decimator.Reset(Resolution.Decimation);
+		}
+
+		State.Window = UWindowsLibrary::GetCachedWindow(Resolution.FrameSize, WindowType);
+		State.FFTConfiguration = UFFTAudioAnalyzer::PerformFFTAlloc(Resolution.FrameSize, 0, nullptr, nullptr);
+		State.FFTInput.SetNumZeroed(Resolution.FrameSize);
+		State.FFTOutput.SetNumZeroed(Resolution.FrameSize);
+		State.MagnitudeSpectrum.SetNumZeroed(Resolution.FrameSize / 2);
+		State.PreviousMagnitudeSpectrum.SetNumZeroed(Resolution.FrameSize / 2);
+	}
+
+	Reset();
+	return true;
+}
+
+void UMultiResolutionAnalysis::Reset()
+{
+	FScopeLock Lock(&DataGuard);
+
+	for (FDecimatedStream& Stream : Streams)
+	{
+		Stream.Decimator.Reset(Stream.Decimator.GetFactor());
+		Stream.NumSamples = 0;
+		Stream.FirstSampleIndex = 0;
+	}
+
+	for (FResolutionState& State : States)
+	{
+		FMemory::Memzero(State.MagnitudeSpectrum.GetData(), State.MagnitudeSpectrum.Num() * sizeof(float));
+		FMemory::Memzero(State.PreviousMagnitudeSpectrum.GetData(), State.PreviousMagnitudeSpectrum.Num() * sizeof(float));
+
+		State.NextFrameEnd = State.Resolution.FrameSize;
+		State.NumProcessedFrames = 0;
+		State.FrameTimestamp = 0;
+		State.FrameStats = FTimeDomainFrameStats();
+		State.SpectralFlux = 0;
+	}
+}
+
+bool UMultiResolutionAnalysis::ProcessAudioFrames(const TArray<float>& AudioFrames, int32 InSampleRate)
+{
+	return ProcessAudioFrames(TArrayView64<const float>(AudioFrames.GetData(), AudioFrames.Num()), InSampleRate);
+}
+
+bool UMultiResolutionAnalysis::ProcessAudioFrames(TArrayView64<const float> AudioFrames, int32 InSampleRate)
+{
+	if (InSampleRate <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to process multi-resolution analysis: the sample rate is '%d', expected > '0'"), InSampleRate);
+		return false;
+	}
+
+	FScopeLock Lock(&DataGuard);
+
+	if (States.Num() <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to process multi-resolution analysis: no resolutions are specified"));
+		return false;
+	}
+
+	if (InSampleRate != SampleRate)
+	{
+		SampleRate = InSampleRate;
+		Reset();
+	}
+
+	// Decimate the input once per stream and append it to the shared buffer
+	for (FDecimatedStream& Stream : Streams)
+	{
+		Stream.Decimator.Process(AudioFrames, Stream.NewSamples);
+
+		if (Stream.Samples.Num() < Stream.NumSamples + Stream.NewSamples.Num())
+		{
+			Stream.Samples.SetNumUninitialized(Stream.NumSamples + Stream.NewSamples.Num());
+		}
+		FMemory::Memcpy(Stream.Samples.GetData() + Stream.NumSamples, Stream.NewSamples.GetData(), Stream.NewSamples.Num() * sizeof(float));
+		Stream.NumSamples += Stream.NewSamples.Num();
+	}
+
+	// Analyze every frame completed by the new audio, in order, directly from the shared buffer
+	for (int32 ResolutionIndex = 0; ResolutionIndex < States.Num(); ++ResolutionIndex)
+	{
+		FResolutionState& State = States[ResolutionIndex];
+		const FDecimatedStream& Stream = Streams[State.StreamIndex];
+		const int64 BufferEnd = Stream.FirstSampleIndex + Stream.NumSamples;
+
+		for (; State.NextFrameEnd <= BufferEnd; State.NextFrameEnd += State.Resolution.HopSize)
+		{
+			const int64 FrameStart = State.NextFrameEnd - State.Resolution.FrameSize;
+
+			// A frame that already left the buffer (a hop larger than the frame size and the block) is skipped
+			if (FrameStart < Stream.FirstSampleIndex)
+			{
+				continue;
+			}
+
+			State.FrameTimestamp = static_cast<double>(FrameStart) * Stream.Decimator.GetFactorValue() / SampleRate;
+			AnalyzeFrame(State, ResolutionIndex, Stream.Samples.GetData() + (FrameStart - Stream.FirstSampleIndex));
+		}
+	}
+
+	// Drop the buffered audio no resolution needs anymore
+	for (int32 StreamIndex = 0; StreamIndex < Streams.Num(); ++StreamIndex)
+	{
+		FDecimatedStream& Stream = Streams[StreamIndex];
+		int64 FirstNeededIndex = Stream.FirstSampleIndex + Stream.NumSamples;
+
+		for (const FResolutionState& State : States)
+		{
+			if (State.StreamIndex == StreamIndex)
+			{
+				FirstNeededIndex = FMath::Min(FirstNeededIndex, State.NextFrameEnd - State.Resolution.FrameSize);
+			}
+		}
+
+		const int64 NumDropped = FMath::Clamp<int64>(FirstNeededIndex - Stream.FirstSampleIndex, 0, Stream.NumSamples);
+		if (NumDropped > 0)
+		{
+			Stream.NumSamples -= NumDropped;
+			FMemory::Memmove(Stream.Samples.GetData(), Stream.Samples.GetData() + NumDropped, Stream.NumSamples * sizeof(float));
+			Stream.FirstSampleIndex += NumDropped;
+		}
+	}
+
+	return true;
+}
+
+void UMultiResolutionAnalysis::AnalyzeFrame(FResolutionState& State, int32 ResolutionIndex, const float* Frames)
+{
+	const int64 FrameSize = State.Resolution.FrameSize;
+
+	State.FrameStats = UCoreTimeDomainFeatures::GetFrameStats(TArrayView64<const float>(Frames, FrameSize));
+
+	UFFTAudioAnalyzer::WindowAndPack(Frames, State.Window->Values.GetData(), FrameSize, State.FFTInput.GetData());
+	UFFTAudioAnalyzer::PerformFFT(State.FFTConfiguration, State.FFTInput.GetData(), State.FFTOutput.GetData());
+
+	Swap(State.MagnitudeSpectrum, State.PreviousMagnitudeSpectrum);
+	UFFTAudioAnalyzer::UnpackSpectrum(State.FFTOutput.GetData(), FrameSize, nullptr, nullptr, State.MagnitudeSpectrum.Num(), State.MagnitudeSpectrum.GetData(), nullptr, nullptr);
+
+	float SpectralFlux = 0;
+	for (int64 Index = 0; Index < State.MagnitudeSpectrum.Num(); ++Index)
+	{
+		SpectralFlux += FMath::Max(State.MagnitudeSpectrum[Index] - State.PreviousMagnitudeSpectrum[Index], 0.f);
+	}
+
+	State.SpectralFlux = SpectralFlux;
+	++State.NumProcessedFrames;
+
+	OnFrameNative.Broadcast(ResolutionIndex, State.FrameTimestamp);
+}
+
+void UMultiResolutionAnalysis::FreeFFTConfigurations()
+{
+	for (FResolutionState& State : States)
+	{
+		FMemory::Free(State.FFTConfiguration);
+		State.FFTConfiguration = nullptr;
+	}
+}
+
+int32 UMultiResolutionAnalysis::GetNumResolutions() const
+{
+	FScopeLock Lock(&DataGuard);
+	return States.Num();
+}
+
+int64 UMultiResolutionAnalysis::GetNumProcessedFrames(int32 ResolutionIndex) const
+{
+	FScopeLock Lock(&DataGuard);
+	return States.IsValidIndex(ResolutionIndex) ? States[ResolutionIndex].NumProcessedFrames : 0;
+}
+
+float UMultiResolutionAnalysis::GetFrameTimestamp(int32 ResolutionIndex) const
+{
+	return static_cast<float>(GetPreciseFrameTimestamp(ResolutionIndex));
+}
+
+double UMultiResolutionAnalysis::GetPreciseFrameTimestamp(int32 ResolutionIndex) const
+{
+	FScopeLock Lock(&DataGuard);
+	return States.IsValidIndex(ResolutionIndex) ? States[ResolutionIndex].FrameTimestamp : 0;
+}
+
+TArray<float> UMultiResolutionAnalysis::GetMagnitudeSpectrum(int32 ResolutionIndex) const
+{
+	TArray<float> Spectrum;
+	FillMagnitudeSpectrum(ResolutionIndex, Spectrum);
+	return Spectrum;
+}
+
+bool UMultiResolutionAnalysis::FillMagnitudeSpectrum(int32 ResolutionIndex, TArray<float>& Spectrum) const
+{
+	FScopeLock Lock(&DataGuard);
+
+	if (!States.IsValidIndex(ResolutionIndex))
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to get the magnitude spectrum: the resolution index '%d' is invalid, expected < '%d'"), ResolutionIndex, States.Num());
+		return false;
+	}
+
+	return AudioAnalysisTools::CopyToBlueprintArray(States[ResolutionIndex].MagnitudeSpectrum, Spectrum, TEXT("magnitude spectrum"));
+}
+
+void UMultiResolutionAnalysis::ReadMagnitudeSpectrum(int32 ResolutionIndex, TFunctionRef<void(const TArray64<float>&)> Reader) const
+{
+	FScopeLock Lock(&DataGuard);
+
+	if (States.IsValidIndex(ResolutionIndex))
+	{
+		Reader(States[ResolutionIndex].MagnitudeSpectrum);
+	}
+}
+
+FTimeDomainFrameStats UMultiResolutionAnalysis::GetFrameStats(int32 ResolutionIndex) const
+{
+	FScopeLock Lock(&DataGuard);
+	return States.IsValidIndex(ResolutionIndex) ? States[ResolutionIndex].FrameStats : FTimeDomainFrameStats();
+}
+
+float UMultiResolutionAnalysis::GetSpectralFlux(int32 ResolutionIndex) const
+{
+	FScopeLock Lock(&DataGuard);
+	return States.IsValidIndex(ResolutionIndex) ? States[ResolutionIndex].SpectralFlux : 0.f;
+}
+
+int32 UMultiResolutionAnalysis::GetResolutionSampleRate(int32 ResolutionIndex) const
+{
+	FScopeLock Lock(&DataGuard);
+
+	if (!States.IsValidIndex(ResolutionIndex))
+	{
+		return 0;
+	}
+
+	return SampleRate / FPolyphaseDecimator::GetFactorValue(States[ResolutionIndex].Resolution.Decimation);
+}
+
+float UMultiResolutionAnalysis::GetBinFrequency(int32 ResolutionIndex, int64 Bin) const
+{
+	FScopeLock Lock(&DataGuard);
+
+	if (!States.IsValidIndex(ResolutionIndex))
+	{
+		return 0.f;
+	}
+
+	const FResolutionState& State = States[ResolutionIndex];
+	return UFFTAudioAnalyzer::GetBinFrequency(Bin, State.Resolution.FrameSize, SampleRate / FPolyphaseDecimator::GetFactorValue(State.Resolution.Decimation));
+}
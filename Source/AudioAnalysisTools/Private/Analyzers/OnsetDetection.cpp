@@ -4,8 +4,66 @@
 #include "AudioAnalysisToolsDefines.h"
 #include "Math/UnrealMathUtility.h"
 
+namespace
+{
+	/**
+	 * Polynomial approximation of atan2. The minimax polynomial for atan on [0, 1] has a maximum error of 1.7e-6 rad
+	 * Written without branches so that loops calling it can be vectorized
+	 */
+	FORCEINLINE float FastAtan2(float Y, float X)
+	{
+		const float AbsX = FMath::Abs(X);
+		const float AbsY = FMath::Abs(Y);
+
+		// Ratio in [0, 1], mapped back to the full circle below
+		const float Ratio = FMath::Min(AbsX, AbsY) / (FMath::Max(AbsX, AbsY) + SMALL_NUMBER);
+		const float Ratio2 = Ratio * Ratio;
+
+		float Angle = -0.01172120f;
+		Angle = Angle * Ratio2 + 0.05265332f;
+		Angle = Angle * Ratio2 - 0.11643287f;
+		Angle = Angle * Ratio2 + 0.19354346f;
+		Angle = Angle * Ratio2 - 0.33262347f;
+		Angle = Angle * Ratio2 + 0.99997726f;
+		Angle *= Ratio;
+
+		Angle = AbsY > AbsX ? HALF_PI - Angle : Angle;
+		Angle = X < 0 ? PI - Angle : Angle;
+		return Y < 0 ? -Angle : Angle;
+	}
+
+	/**
+	 * Wrap the phase into the [-pi, pi) range without loops
+	 */
+	FORCEINLINE float WrapPhase(float Phase)
+	{
+		return Phase - TWO_PI * FMath::FloorToFloat(Phase * INV_PI * 0.5f + 0.5f);
+	}
+
+	/**
+	 * Polynomial approximation of sin for values in the [-pi, pi] range
+	 * The argument is reflected into [-pi / 2, pi / 2], where the degree 9 polynomial has a maximum error of 3.6e-6
+	 */
+	FORCEINLINE float FastSin(float Value)
+	{
+		Value = Value > HALF_PI ? PI - Value : Value;
+		Value = Value < -HALF_PI ? -PI - Value : Value;
+
+		const float Value2 = Value * Value;
+
+		float Result = 1.f / 362880.f;
+		Result = Result * Value2 - 1.f / 5040.f;
+		Result = Result * Value2 + 1.f / 120.f;
+		Result = Result * Value2 - 1.f / 6.f;
+		Result = Result * Value2 + 1.f;
+		return Result * Value;
+	}
+}
+
 UOnsetDetection::UOnsetDetection()
-	: FrameSize(0)
+	: PreviousFrameEnergy(0),
+	  NumProcessedFrames(0),
+	  FrameSize(0)
 {
 }
 
@@ -33,41 +91,37 @@ void UOnsetDetection::UpdateFrameSize(int64 InFrameSize)
 	PrevPhaseSpectrum2_ComplexSpectralDifference.SetNum(FrameSize);
 	PrevMagnitudeSpectrum_ComplexSpectralDifference.SetNum(FrameSize);
 
+	PrevMagnitudeSpectrum_Frame.Reset();
+	PrevPhaseSpectrum_Frame.Reset();
+	PrevPhaseSpectrum2_Frame.Reset();
+
 	PreviousEnergySum = 0;
+	PreviousFrameEnergy = 0;
 }
 
 float UOnsetDetection::GetEnergyEnvelope(const TArray<float>& AudioFrames)
 {
-	return GetEnergyEnvelope(TArray64<float>(AudioFrames));
+	return UCoreTimeDomainFeatures::GetFrameStats(AudioFrames).Energy;
 }
 
 float UOnsetDetection::GetEnergyEnvelope(const TArray64<float>& AudioFrames)
 {
-	float EnergyEnvelopeValue{0};
-
-	// Sum the squares of the samples
-	for (const auto& BufferValue : AudioFrames)
-	{
-		EnergyEnvelopeValue += FMath::Pow(BufferValue, 2);
-	}
-
-	return EnergyEnvelopeValue;
+	return UCoreTimeDomainFeatures::GetFrameStats(AudioFrames).Energy;
 }
 
 float UOnsetDetection::GetEnergyDifference(const TArray<float>& AudioFrames)
 {
-	return GetEnergyDifference(TArray64<float>(AudioFrames));
+	return GetEnergyDifference(UCoreTimeDomainFeatures::GetFrameStats(AudioFrames));
 }
 
 float UOnsetDetection::GetEnergyDifference(const TArray64<float>& AudioFrames)
 {
-	float EnergyDifferenceValue{0};
+	return GetEnergyDifference(UCoreTimeDomainFeatures::GetFrameStats(AudioFrames));
+}
 
-	// Sum the squares of the samples
-	for (const auto& BufferValue : AudioFrames)
-	{
-		EnergyDifferenceValue += FMath::Pow(BufferValue, 2);
-	}
+float UOnsetDetection::GetEnergyDifference(const FTimeDomainFrameStats& FrameStats)
+{
+	const float EnergyDifferenceValue{FrameStats.Energy};
 
 	// Sample is first order difference in energy
 	const float Difference{EnergyDifferenceValue - PreviousEnergySum};
@@ -90,9 +144,10 @@ float UOnsetDetection::GetSpectralDifference(const TArray<float>& MagnitudeSpect
 
 float UOnsetDetection::GetSpectralDifference(const TArray64<float>& MagnitudeSpectrum)
 {
-	if (MagnitudeSpectrum.Num() != FrameSize)
+	// Only reset the history of this function, so that callers with different input sizes do not wipe each other's state
+	if (MagnitudeSpectrum.Num() != PrevMagnitudeSpectrum_SpectralDifference.Num())
 	{
-		UpdateFrameSize(MagnitudeSpectrum.Num());
+		PrevMagnitudeSpectrum_SpectralDifference.SetNumZeroed(MagnitudeSpectrum.Num());
 	}
 
 	float SpectralDifferenceValue{0};
@@ -102,11 +157,8 @@ float UOnsetDetection::GetSpectralDifference(const TArray64<float>& MagnitudeSpe
 		// Calculate difference
 		const float Difference{MagnitudeSpectrum[Index] - PrevMagnitudeSpectrum_SpectralDifference[Index]};
 
-		// Ensure all difference values are positive
-		FMath::Abs(Difference);
-
-		// Add difference to sum
-		SpectralDifferenceValue += Difference;
+		// Add the absolute difference to sum
+		SpectralDifferenceValue += FMath::Abs(Difference);
 
 		// Store the sample for next time
 		PrevMagnitudeSpectrum_SpectralDifference[Index] = MagnitudeSpectrum[Index];
@@ -122,9 +174,9 @@ float UOnsetDetection::GetSpectralDifferenceHWR(const TArray<float>& MagnitudeSp
 
 float UOnsetDetection::GetSpectralDifferenceHWR(const TArray64<float>& MagnitudeSpectrum)
 {
-	if (MagnitudeSpectrum.Num() != FrameSize)
+	if (MagnitudeSpectrum.Num() != PrevMagnitudeSpectrum_SpectralDifferenceHWR.Num())
 	{
-		UpdateFrameSize(MagnitudeSpectrum.Num());
+		PrevMagnitudeSpectrum_SpectralDifferenceHWR.SetNumZeroed(MagnitudeSpectrum.Num());
 	}
 
 	float SpectralDifferenceHWRValue{0};
@@ -161,9 +213,11 @@ float UOnsetDetection::GetComplexSpectralDifference(const TArray64<float>& FFTRe
 		return -1;
 	}
 
-	if (FFTReal.Num() != FrameSize)
+	if (FFTReal.Num() != PrevMagnitudeSpectrum_ComplexSpectralDifference.Num())
 	{
-		UpdateFrameSize(FFTReal.Num());
+		PrevPhaseSpectrum_ComplexSpectralDifference.SetNumZeroed(FFTReal.Num());
+		PrevPhaseSpectrum2_ComplexSpectralDifference.SetNumZeroed(FFTReal.Num());
+		PrevMagnitudeSpectrum_ComplexSpectralDifference.SetNumZeroed(FFTReal.Num());
 	}
 
 	float ComplexSpectralDifferenceValue{0};
@@ -203,6 +257,65 @@ float UOnsetDetection::GetComplexSpectralDifference(const TArray64<float>& FFTRe
 	return ComplexSpectralDifferenceValue;
 }
 
+float UOnsetDetection::GetComplexSpectralDifferenceFast(const TArray<float>& FFTReal, const TArray<float>& FFTImaginary, const TArray<float>& MagnitudeSpectrum)
+{
+	return GetComplexSpectralDifferenceFast(TArray64<float>(FFTReal), TArray64<float>(FFTImaginary), TArray64<float>(MagnitudeSpectrum));
+}
+
+float UOnsetDetection::GetComplexSpectralDifferenceFast(const TArray64<float>& FFTReal, const TArray64<float>& FFTImaginary, const TArray64<float>& MagnitudeSpectrum)
+{
+	if (FFTReal.Num() != FFTImaginary.Num())
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot get fast complex spectral difference: real FFT size ('%lld') must equal imaginary FFT size ('%lld')"), FFTReal.Num(), FFTImaginary.Num());
+		return -1;
+	}
+
+	// For real input, bins above N / 2 mirror the lower ones
+	const int64 NumBins = FFTReal.Num() / 2 + 1;
+
+	if (PrevMagnitudeSpectrum_ComplexSpectralDifferenceFast.Num() != NumBins)
+	{
+		PrevPhaseSpectrum_ComplexSpectralDifferenceFast.SetNumZeroed(NumBins);
+		PrevPhaseSpectrum2_ComplexSpectralDifferenceFast.SetNumZeroed(NumBins);
+		PrevMagnitudeSpectrum_ComplexSpectralDifferenceFast.SetNumZeroed(NumBins);
+	}
+
+	const float* Real = FFTReal.GetData();
+	const float* Imaginary = FFTImaginary.GetData();
+	float* PrevPhase = PrevPhaseSpectrum_ComplexSpectralDifferenceFast.GetData();
+	float* PrevPhase2 = PrevPhaseSpectrum2_ComplexSpectralDifferenceFast.GetData();
+	float* PrevMagnitude = PrevMagnitudeSpectrum_ComplexSpectralDifferenceFast.GetData();
+
+	// The magnitude spectrum usually holds N / 2 bins, so the Nyquist bin magnitude is computed
+	const int64 NumReusedMagnitudes = FMath::Min(MagnitudeSpectrum.Num(), NumBins);
+	const float* Magnitudes = MagnitudeSpectrum.GetData();
+
+	float ComplexSpectralDifferenceValue{0};
+
+	for (int64 Index = 0; Index < NumBins; ++Index)
+	{
+		const float PhaseValue{FastAtan2(Imaginary[Index], Real[Index])};
+
+		const float MagnitudeValue{Index < NumReusedMagnitudes ? Magnitudes[Index] : FMath::Sqrt(Real[Index] * Real[Index] + Imaginary[Index] * Imaginary[Index])};
+
+		// Phase deviation from the linear phase prediction, wrapped into [-pi, pi)
+		const float PhaseDeviation{WrapPhase(PhaseValue - 2 * PrevPhase[Index] + PrevPhase2[Index])};
+
+		// Euclidean distance between the predicted and the current complex values
+		const float MagnitudeDifference{MagnitudeValue - PrevMagnitude[Index]};
+		const float PhaseDifference{-MagnitudeValue * FastSin(PhaseDeviation)};
+
+		ComplexSpectralDifferenceValue += FMath::Sqrt(MagnitudeDifference * MagnitudeDifference + PhaseDifference * PhaseDifference);
+
+		// Store values for the next calculation
+		PrevPhase2[Index] = PrevPhase[Index];
+		PrevPhase[Index] = PhaseValue;
+		PrevMagnitude[Index] = MagnitudeValue;
+	}
+
+	return ComplexSpectralDifferenceValue;
+}
+
 float UOnsetDetection::GetHighFrequencyContent(const TArray<float>& MagnitudeSpectrum)
 {
 	return GetHighFrequencyContent(TArray64<float>(MagnitudeSpectrum));
@@ -219,3 +332,137 @@ float UOnsetDetection::GetHighFrequencyContent(const TArray64<float>& MagnitudeS
 
 	return HighFrequencyContentValue;
 }
+
+FOnsetDetectionValues UOnsetDetection::ProcessFrame(const TArray<float>& AudioFrames, const TArray<float>& FFTReal, const TArray<float>& FFTImaginary, const TArray<float>& MagnitudeSpectrum, bool bFastComplexSpectralDifference, float Timestamp)
+{
+	return ProcessFrame(TArray64<float>(AudioFrames), TArray64<float>(FFTReal), TArray64<float>(FFTImaginary), TArray64<float>(MagnitudeSpectrum), bFastComplexSpectralDifference, static_cast<double>(Timestamp));
+}
+
+const FOnsetDetectionValues& UOnsetDetection::ProcessFrame(const TArray64<float>& AudioFrames, const TArray64<float>& FFTReal, const TArray64<float>& FFTImaginary, const TArray64<float>& MagnitudeSpectrum, bool bFastComplexSpectralDifference, double Timestamp)
+{
+	return ProcessFrame(UCoreTimeDomainFeatures::GetFrameStats(AudioFrames), FFTReal, FFTImaginary, MagnitudeSpectrum, bFastComplexSpectralDifference, Timestamp);
+}
+
+const FOnsetDetectionValues& UOnsetDetection::ProcessFrame(const FTimeDomainFrameStats& FrameStats, const TArray64<float>& FFTReal, const TArray64<float>& FFTImaginary, const TArray64<float>& MagnitudeSpectrum, bool bFastComplexSpectralDifference, double Timestamp)
+{
+	if (FFTReal.Num() != FFTImaginary.Num())
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot process onset detection frame: real FFT size ('%lld') must equal imaginary FFT size ('%lld')"), FFTReal.Num(), FFTImaginary.Num());
+		FrameValues = FOnsetDetectionValues();
+		return FrameValues;
+	}
+
+	FOnsetDetectionValues Values;
+
+	// Energy functions
+	Values.EnergyEnvelope = FrameStats.Energy;
+	Values.EnergyDifference = FMath::Max(Values.EnergyEnvelope - PreviousFrameEnergy, 0.f);
+	PreviousFrameEnergy = Values.EnergyEnvelope;
+
+	// For real input, bins above N / 2 mirror the lower ones
+	const int64 NumBins = FFTReal.Num() > 0 ? FFTReal.Num() / 2 + 1 : 0;
+
+	if (PrevMagnitudeSpectrum_Frame.Num() != NumBins)
+	{
+		PrevMagnitudeSpectrum_Frame.SetNumZeroed(NumBins);
+		PrevPhaseSpectrum_Frame.SetNumZeroed(NumBins);
+		PrevPhaseSpectrum2_Frame.SetNumZeroed(NumBins);
+	}
+
+	const float* Real = FFTReal.GetData();
+	const float* Imaginary = FFTImaginary.GetData();
+	float* PrevMagnitude = PrevMagnitudeSpectrum_Frame.GetData();
+	float* PrevPhase = PrevPhaseSpectrum_Frame.GetData();
+	float* PrevPhase2 = PrevPhaseSpectrum2_Frame.GetData();
+
+	const int64 NumReusedMagnitudes = FMath::Min(MagnitudeSpectrum.Num(), NumBins);
+	const float* Magnitudes = MagnitudeSpectrum.GetData();
+
+	// Spectral functions, all in one pass over the shared history
+	for (int64 Index = 0; Index < NumBins; ++Index)
+	{
+		const float MagnitudeValue{Index < NumReusedMagnitudes ? Magnitudes[Index] : FMath::Sqrt(Real[Index] * Real[Index] + Imaginary[Index] * Imaginary[Index])};
+		const float MagnitudeDifference{MagnitudeValue - PrevMagnitude[Index]};
+
+		Values.SpectralDifference += FMath::Abs(MagnitudeDifference);
+		Values.SpectralDifferenceHWR += FMath::Max(MagnitudeDifference, 0.f);
+		Values.HighFrequencyContent += MagnitudeValue * static_cast<float>(Index + 1);
+
+		const float PhaseValue{bFastComplexSpectralDifference ? FastAtan2(Imaginary[Index], Real[Index]) : FMath::Atan2(Imaginary[Index], Real[Index])};
+		const float PhaseDeviation{WrapPhase(PhaseValue - 2 * PrevPhase[Index] + PrevPhase2[Index])};
+		const float PhaseDifference{-MagnitudeValue * (bFastComplexSpectralDifference ? FastSin(PhaseDeviation) : FMath::Sin(PhaseDeviation))};
+
+		Values.ComplexSpectralDifference += FMath::Sqrt(MagnitudeDifference * MagnitudeDifference + PhaseDifference * PhaseDifference);
+
+		// Store values for the next frame
+		PrevPhase2[Index] = PrevPhase[Index];
+		PrevPhase[Index] = PhaseValue;
+		PrevMagnitude[Index] = MagnitudeValue;
+	}
+
+	FrameValues = Values;
+
+	const double HistoryTimestamp = Timestamp >= 0 ? Timestamp : static_cast<double>(NumProcessedFrames);
+	++NumProcessedFrames;
+
+	if (FrameHistories[0].IsEnabled())
+	{
+		FrameHistories[static_cast<int32>(EOnsetDetectionFunction::EnergyEnvelope)].Add(Values.EnergyEnvelope, HistoryTimestamp);
+		FrameHistories[static_cast<int32>(EOnsetDetectionFunction::EnergyDifference)].Add(Values.EnergyDifference, HistoryTimestamp);
+		FrameHistories[static_cast<int32>(EOnsetDetectionFunction::SpectralDifference)].Add(Values.SpectralDifference, HistoryTimestamp);
+		FrameHistories[static_cast<int32>(EOnsetDetectionFunction::SpectralDifferenceHWR)].Add(Values.SpectralDifferenceHWR, HistoryTimestamp);
+		FrameHistories[static_cast<int32>(EOnsetDetectionFunction::ComplexSpectralDifference)].Add(Values.ComplexSpectralDifference, HistoryTimestamp);
+		FrameHistories[static_cast<int32>(EOnsetDetectionFunction::HighFrequencyContent)].Add(Values.HighFrequencyContent, HistoryTimestamp);
+	}
+
+	return FrameValues;
+}
+
+void UOnsetDetection::EnableHistory(int64 Capacity, float WindowDuration)
+{
+	if (Capacity <= 0 || WindowDuration < 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to enable onset detection history: capacity is '%lld' and window duration is '%f', expected > '0' and >= '0'"), Capacity, WindowDuration);
+		return;
+	}
+
+	for (FSignalHistory& History : FrameHistories)
+	{
+		History.Reset(Capacity, WindowDuration, History.GetThreshold());
+	}
+}
+
+void UOnsetDetection::DisableHistory()
+{
+	for (FSignalHistory& History : FrameHistories)
+	{
+		History.Reset(0, History.GetWindowDuration(), History.GetThreshold());
+	}
+}
+
+void UOnsetDetection::UpdateHistoryThreshold(EOnsetDetectionFunction Function, float Threshold)
+{
+	if (Function >= EOnsetDetectionFunction::Count)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update onset detection history threshold: invalid onset detection function"));
+		return;
+	}
+
+	FSignalHistory& History = FrameHistories[static_cast<int32>(Function)];
+	History.Reset(History.GetCapacity(), History.GetWindowDuration(), Threshold);
+}
+
+float UOnsetDetection::GetHistoryMax(EOnsetDetectionFunction Function) const
+{
+	return Function < EOnsetDetectionFunction::Count ? GetHistory(Function).GetWindowMax() : 0;
+}
+
+float UOnsetDetection::GetHistoryMean(EOnsetDetectionFunction Function) const
+{
+	return Function < EOnsetDetectionFunction::Count ? GetHistory(Function).GetWindowMean() : 0;
+}
+
+int64 UOnsetDetection::GetHistoryCountAboveThreshold(EOnsetDetectionFunction Function) const
+{
+	return Function < EOnsetDetectionFunction::Count ? GetHistory(Function).GetWindowCountAboveThreshold() : 0;
+}
@@ -0,0 +1,172 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/OnsetPeakPicker.h"
+#include "AudioAnalysisToolsDefines.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	/** The maximum number of onset events kept when they are not consumed */
+	constexpr int32 MaxPendingEvents = 1024;
+}
+
+UOnsetPeakPicker::UOnsetPeakPicker()
+	: NumRecentValues(0),
+	  RecentPosition(0),
+	  Lookahead(0),
+	  MinInterOnsetInterval(0),
+	  Delta(0),
+	  MedianWeight(0),
+	  MeanWeight(0),
+	  Threshold(0),
+	  LastOnsetTimestamp(0),
+	  bHasPickedOnset(false),
+	  FirstPendingEvent(0),
+	  NumPendingEvents(0)
+{
+}
+
+UOnsetPeakPicker* UOnsetPeakPicker::CreateOnsetPeakPicker(int64 InWindowSize, int64 InLookahead, float InMinInterOnsetInterval, float InDelta, float InMedianWeight, float InMeanWeight)
+{
+	UOnsetPeakPicker* OnsetPeakPicker = NewObject<UOnsetPeakPicker>();
+	OnsetPeakPicker->UpdateParameters(InWindowSize, InLookahead, InMinInterOnsetInterval, InDelta, InMedianWeight, InMeanWeight);
+	return OnsetPeakPicker;
+}
+
+void UOnsetPeakPicker::UpdateParameters(int64 InWindowSize, int64 InLookahead, float InMinInterOnsetInterval, float InDelta, float InMedianWeight, float InMeanWeight)
+{
+	if (InWindowSize <= 0 || InLookahead < 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update onset peak picker parameters: window size is '%lld' and lookahead is '%lld', expected > '0' and >= '0'"), InWindowSize, InLookahead);
+		return;
+	}
+
+	if (InMinInterOnsetInterval < 0 || InMedianWeight < 0 || InMeanWeight < 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update onset peak picker parameters: min inter-onset interval, median weight and mean weight must not be negative"));
+		return;
+	}
+
+	Lookahead = InLookahead;
+	MinInterOnsetInterval = InMinInterOnsetInterval;
+	Delta = InDelta;
+	MedianWeight = InMedianWeight;
+	MeanWeight = InMeanWeight;
+
+	SlidingMedian.Reset(InWindowSize);
+
+	RecentValues.Init(0, 2 * Lookahead + 1);
+	RecentTimestamps.Init(0, 2 * Lookahead + 1);
+	NumRecentValues = 0;
+	RecentPosition = 0;
+
+	Threshold = 0;
+	bHasPickedOnset = false;
+}
+
+bool UOnsetPeakPicker::ProcessOnsetValue(float OnsetValue, float Timestamp)
+{
+	return ProcessOnsetValue(OnsetValue, static_cast<double>(Timestamp));
+}
+
+bool UOnsetPeakPicker::ProcessOnsetValue(float OnsetValue, double Timestamp)
+{
+	if (RecentValues.Num() <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot process onset value: the onset peak picker parameters have not been set"));
+		return false;
+	}
+
+	const int64 NumRecentSlots = RecentValues.Num();
+
+	RecentValues[RecentPosition] = OnsetValue;
+	RecentTimestamps[RecentPosition] = Timestamp;
+	RecentPosition = (RecentPosition + 1) % NumRecentSlots;
+	NumRecentValues = FMath::Min(NumRecentValues + 1, NumRecentSlots);
+
+	// The threshold window includes the lookahead values, so it is centered closer to the candidate
+	SlidingMedian.Add(OnsetValue);
+
+	if (NumRecentValues <= Lookahead)
+	{
+		return false;
+	}
+
+	// The candidate is Lookahead values back from the newest one
+	const int64 CandidatePosition = (RecentPosition - 1 - Lookahead + NumRecentSlots) % NumRecentSlots;
+	const float CandidateValue = RecentValues[CandidatePosition];
+	const double CandidateTimestamp = RecentTimestamps[CandidatePosition];
+
+	Threshold = Delta + MedianWeight * SlidingMedian.GetMedian() + MeanWeight * SlidingMedian.GetMean();
+
+	if (CandidateValue <= Threshold)
+	{
+		return false;
+	}
+
+	if (bHasPickedOnset && CandidateTimestamp - LastOnsetTimestamp < MinInterOnsetInterval)
+	{
+		return false;
+	}
+
+	// The candidate must be the maximum of the values around it. Ties are resolved in favor of the earliest value
+	for (int64 Offset = 1; Offset <= Lookahead; ++Offset)
+	{
+		if (RecentValues[(CandidatePosition + Offset) % NumRecentSlots] > CandidateValue)
+		{
+			return false;
+		}
+
+		if (Offset < NumRecentValues - Lookahead && RecentValues[(CandidatePosition - Offset + NumRecentSlots) % NumRecentSlots] >= CandidateValue)
+		{
+			return false;
+		}
+	}
+
+	LastOnsetTimestamp = CandidateTimestamp;
+	bHasPickedOnset = true;
+
+	{
+		FScopeLock Lock(&EventsGuard);
+
+		if (NumPendingEvents >= MaxPendingEvents)
+		{
+			UE_LOG(LogAudioAnalysis, Verbose, TEXT("Onset events are not being consumed, dropping the oldest one"));
+			FirstPendingEvent = (FirstPendingEvent + 1) % MaxPendingEvents;
+			--NumPendingEvents;
+		}
+
+		const FOnsetEvent OnsetEvent(static_cast<float>(CandidateTimestamp), CandidateValue);
+		const int32 Slot = (FirstPendingEvent + NumPendingEvents) % MaxPendingEvents;
+
+		// The ring only grows while it is not full, so the slot is either the next one to add or an existing one
+		if (Slot == PendingEvents.Num())
+		{
+			PendingEvents.Add(OnsetEvent);
+		}
+		else
+		{
+			PendingEvents[Slot] = OnsetEvent;
+		}
+
+		++NumPendingEvents;
+	}
+
+	return true;
+}
+
+bool UOnsetPeakPicker::ConsumeOnsetEvents(TArray<FOnsetEvent>& OnsetEvents)
+{
+	FScopeLock Lock(&EventsGuard);
+
+	OnsetEvents.Reset(NumPendingEvents);
+	for (int32 EventIndex = 0; EventIndex < NumPendingEvents; ++EventIndex)
+	{
+		OnsetEvents.Add(PendingEvents[(FirstPendingEvent + EventIndex) % MaxPendingEvents]);
+	}
+
+	FirstPendingEvent = 0;
+	NumPendingEvents = 0;
+
+	return OnsetEvents.Num() > 0;
+}
@@ -0,0 +1,347 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/PitchDetection.h"
+#include "AudioAnalysisToolsDefines.h"
+#include "Math/UnrealMathUtility.h"
+
+namespace
+{
+	/** The default McLeod threshold, as a fraction of the highest NSDF peak */
+	constexpr float DefaultMcLeodThreshold = 0.9f;
+
+	/** The default YIN threshold of the cumulative mean normalized difference */
+	constexpr float DefaultYinThreshold = 0.15f;
+
+	/**
+	 * Refine the position of an extremum with parabolic interpolation through the neighboring values
+	 *
+	 * @param Values The sampled function
+	 * @param Index The index of the sampled extremum. Must have a neighbor on both sides
+	 * @param OutPosition The refined position
+	 * @param OutValue The refined value
+	 */
+	void InterpolateParabolic(const TArray64<float>& Values, int64 Index, float& OutPosition, float& OutValue)
+	{
+		const float Previous = Values[Index - 1];
+		const float Current = Values[Index];
+		const float Next = Values[Index + 1];
+
+		const float Denominator = Previous - 2 * Current + Next;
+
+		if (FMath::IsNearlyZero(Denominator))
+		{
+			OutPosition = static_cast<float>(Index);
+			OutValue = Current;
+			return;
+		}
+
+		const float Offset = 0.5f * (Previous - Next) / Denominator;
+
+		OutPosition = static_cast<float>(Index) + Offset;
+		OutValue = Current - 0.25f * (Previous - Next) * Offset;
+	}
+}
+
+UPitchDetection::UPitchDetection()
+	: Method(EPitchDetectionMethod::McLeod),
+	  MinFrequency(0),
+	  MaxFrequency(0),
+	  Threshold(0),
+	  Pitch(0),
+	  Confidence(0),
+	  FrameSize(0),
+	  PaddedSize(0),
+	  ForwardFFT(nullptr),
+	  InverseFFT(nullptr)
+{
+}
+
+void UPitchDetection::BeginDestroy()
+{
+	FreeFFT();
+
+	Super::BeginDestroy();
+}
+
+UPitchDetection* UPitchDetection::CreatePitchDetection(EPitchDetectionMethod InMethod, float InMinFrequency, float InMaxFrequency, float InThreshold)
+{
+	UPitchDetection* PitchDetection = NewObject<UPitchDetection>();
+	PitchDetection->UpdateParameters(InMethod, InMinFrequency, InMaxFrequency, InThreshold);
+	return PitchDetection;
+}
+
+void UPitchDetection::UpdateParameters(EPitchDetectionMethod InMethod, float InMinFrequency, float InMaxFrequency, float InThreshold)
+{
+	if (!(InMinFrequency > 0 && InMaxFrequency > InMinFrequency))
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update pitch detection parameters: min frequency is '%f' and max frequency is '%f', expected 0 < min < max"), InMinFrequency, InMaxFrequency);
+		return;
+	}
+
+	Method = InMethod;
+	MinFrequency = InMinFrequency;
+	MaxFrequency = InMaxFrequency;
+	Threshold = InThreshold >= 0 ? InThreshold : (Method == EPitchDetectionMethod::Yin ? DefaultYinThreshold : DefaultMcLeodThreshold);
+}
+
+void UPitchDetection::UpdateFrameSize(int64 InFrameSize)
+{
+	if (InFrameSize == FrameSize && ForwardFFT && InverseFFT)
+	{
+		return;
+	}
+
+	UE_LOG(LogAudioAnalysis, Log, TEXT("Updating Pitch Detection frame size from '%lld' to '%lld'"), FrameSize, InFrameSize);
+
+	FrameSize = InFrameSize;
+
+	// Zero-pad to at least 2N - 1 so the circular correlation equals the linear one for all lags
+	const int64 NewPaddedSize = UFFTAudioAnalyzer::GetNextFastSize(2 * FrameSize - 1);
+
+	if (NewPaddedSize != PaddedSize || !ForwardFFT || !InverseFFT)
+	{
+		FreeFFT();
+
+		PaddedSize = NewPaddedSize;
+		ForwardFFT = UFFTAudioAnalyzer::PerformFFTAlloc(PaddedSize, 0, nullptr, nullptr);
+		InverseFFT = UFFTAudioAnalyzer::PerformFFTAlloc(PaddedSize, 1, nullptr, nullptr);
+
+		FFTInput.SetNumUninitialized(PaddedSize);
+		FFTOutput.SetNumUninitialized(PaddedSize);
+	}
+
+	Autocorrelation.SetNumUninitialized(FrameSize);
+}
+
+void UPitchDetection::FreeFFT()
+{
+	FMemory::Free(ForwardFFT);
+	FMemory::Free(InverseFFT);
+
+	ForwardFFT = nullptr;
+	InverseFFT = nullptr;
+}
+
+bool UPitchDetection::ProcessAudioFrames(const TArray<float>& AudioFrames, int32 SampleRate)
+{
+	return ProcessAudioFrames(TArray64<float>(AudioFrames), SampleRate);
+}
+
+bool UPitchDetection::ProcessAudioFrames(const TArray64<float>& AudioFrames, int32 SampleRate)
+{
+	Pitch = 0;
+	Confidence = 0;
+
+	if (SampleRate <= 0 || MinFrequency <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot detect pitch: sample rate ('%d') and min frequency ('%f') must be > '0'"), SampleRate, MinFrequency);
+		return false;
+	}
+
+	const int64 NumFrames = AudioFrames.Num();
+
+	// Lags beyond half of the frame overlap too few samples to be reliable
+	const int64 MinLag = FMath::Max<int64>(2, static_cast<int64>(SampleRate / MaxFrequency));
+	const int64 MaxLag = FMath::Min<int64>(static_cast<int64>(FMath::CeilToDouble(SampleRate / MinFrequency)), NumFrames / 2);
+
+	if (MaxLag <= MinLag)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot detect pitch: the frame size ('%lld') is too small for the min frequency ('%f') at sample rate '%d'"), NumFrames, MinFrequency, SampleRate);
+		return false;
+	}
+
+	UpdateFrameSize(NumFrames);
+	ComputeAutocorrelation(AudioFrames.GetData(), NumFrames);
+
+	// Both methods normalize the autocorrelation r(t) by m(t) = sum(x[j]^2 + x[j + t]^2), which is updated incrementally per lag
+	const float* Samples = AudioFrames.GetData();
+
+	float SquareSum = 0;
+	for (int64 Index = 0; Index < NumFrames; ++Index)
+	{
+		SquareSum += Samples[Index] * Samples[Index];
+	}
+
+	if (SquareSum <= 0)
+	{
+		return false;
+	}
+
+	float Normalization = 2 * SquareSum;
+	float CumulativeDifference = 0;
+
+	// One lag past MaxLag is needed for the parabolic interpolation
+	const int64 LastLag = FMath::Min(MaxLag + 1, NumFrames - 1);
+
+	// Both normalized functions are 1 at lag 0
+	Autocorrelation[0] = 1.f;
+
+	for (int64 Lag = 1; Lag <= LastLag; ++Lag)
+	{
+		Normalization -= Samples[Lag - 1] * Samples[Lag - 1] + Samples[NumFrames - Lag] * Samples[NumFrames - Lag];
+
+		if (Method == EPitchDetectionMethod::McLeod)
+		{
+			// Normalized square difference function, in the [-1, 1] range
+			Autocorrelation[Lag] = Normalization > 0 ? 2 * Autocorrelation[Lag] / Normalization : 0.f;
+		}
+		else
+		{
+			// Cumulative mean normalized difference function
+			const float Difference = FMath::Max(Normalization - 2 * Autocorrelation[Lag], 0.f);
+			CumulativeDifference += Difference;
+			Autocorrelation[Lag] = CumulativeDifference > 0 ? Difference * Lag / CumulativeDifference : 1.f;
+		}
+	}
+
+	float Period, PeriodConfidence;
+	const bool bFound = Method == EPitchDetectionMethod::McLeod
+		                    ? SelectMcLeodPeriod(MinLag, FMath::Min(MaxLag, LastLag - 1), Period, PeriodConfidence)
+		                    : SelectYinPeriod(MinLag, FMath::Min(MaxLag, LastLag - 1), Period, PeriodConfidence);
+
+	if (!bFound || Period <= 0)
+	{
+		return false;
+	}
+
+	Pitch = SampleRate / Period;
+	Confidence = FMath::Clamp(PeriodConfidence, 0.f, 1.f);
+
+	return true;
+}
+
+void UPitchDetection::ComputeAutocorrelation(const float* AudioFrames, int64 NumFrames)
+{
+	for (int64 Index = 0; Index < NumFrames; ++Index)
+	{
+		FFTInput[Index].Real = AudioFrames[Index];
+		FFTInput[Index].Imaginary = 0;
+	}
+	FMemory::Memzero(FFTInput.GetData() + NumFrames, sizeof(FFTComplexSamples) * (PaddedSize - NumFrames));
+
+	UFFTAudioAnalyzer::PerformFFT(ForwardFFT, FFTInput.GetData(), FFTOutput.GetData());
+
+	// The autocorrelation is the inverse transform of the power spectrum
+	for (int64 Index = 0; Index < PaddedSize; ++Index)
+	{
+		const FFTComplexSamples& Sample = FFTOutput[Index];
+
+		FFTInput[Index].Real = Sample.Real * Sample.Real + Sample.Imaginary * Sample.Imaginary;
+		FFTInput[Index].Imaginary = 0;
+	}
+
+	UFFTAudioAnalyzer::PerformFFT(InverseFFT, FFTInput.GetData(), FFTOutput.GetData());
+
+	// The inverse transform is not normalized
+	const float Scale = 1.f / PaddedSize;
+
+	for (int64 Index = 0; Index < NumFrames; ++Index)
+	{
+		Autocorrelation[Index] = FFTOutput[Index].Real * Scale;
+	}
+}
+
+bool UPitchDetection::SelectMcLeodPeriod(int64 MinLag, int64 MaxLag, float& OutPeriod, float& OutConfidence) const
+{
+	// Key maxima are the highest values between a positively sloped and a negatively sloped zero crossing of the NSDF
+	constexpr int32 MaxKeyMaxima = 128;
+	int64 KeyMaxima[MaxKeyMaxima];
+	int32 NumKeyMaxima = 0;
+
+	float HighestPeak = 0;
+
+	// Skip the main lobe around lag 0
+	int64 Lag = 1;
+	while (Lag <= MaxLag && Autocorrelation[Lag] > 0)
+	{
+		++Lag;
+	}
+
+	int64 CurrentMaximum = -1;
+
+	for (; Lag <= MaxLag; ++Lag)
+	{
+		const float Value = Autocorrelation[Lag];
+
+		if (Value > 0)
+		{
+			if (Lag >= MinLag && (CurrentMaximum < 0 || Value > Autocorrelation[CurrentMaximum]))
+			{
+				CurrentMaximum = Lag;
+			}
+		}
+		else if (CurrentMaximum >= 0)
+		{
+			if (NumKeyMaxima < MaxKeyMaxima)
+			{
+				KeyMaxima[NumKeyMaxima++] = CurrentMaximum;
+				HighestPeak = FMath::Max(HighestPeak, Autocorrelation[CurrentMaximum]);
+			}
+			CurrentMaximum = -1;
+		}
+	}
+
+	// The last positive lobe may be cut off by the lag range
+	if (CurrentMaximum >= 0 && NumKeyMaxima < MaxKeyMaxima)
+	{
+		KeyMaxima[NumKeyMaxima++] = CurrentMaximum;
+		HighestPeak = FMath::Max(HighestPeak, Autocorrelation[CurrentMaximum]);
+	}
+
+	if (NumKeyMaxima == 0 || HighestPeak <= 0)
+	{
+		return false;
+	}
+
+	// Select the first key maximum close enough to the highest one, which avoids picking multiples of the period
+	const float PeakThreshold = Threshold * HighestPeak;
+
+	for (int32 KeyIndex = 0; KeyIndex < NumKeyMaxima; ++KeyIndex)
+	{
+		if (Autocorrelation[KeyMaxima[KeyIndex]] >= PeakThreshold)
+		{
+			InterpolateParabolic(Autocorrelation, KeyMaxima[KeyIndex], OutPeriod, OutConfidence);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool UPitchDetection::SelectYinPeriod(int64 MinLag, int64 MaxLag, float& OutPeriod, float& OutConfidence) const
+{
+	int64 BestLag = -1;
+
+	// The first dip below the absolute threshold, followed down to its local minimum
+	for (int64 Lag = MinLag; Lag <= MaxLag; ++Lag)
+	{
+		if (Autocorrelation[Lag] < Threshold)
+		{
+			while (Lag + 1 <= MaxLag && Autocorrelation[Lag + 1] < Autocorrelation[Lag])
+			{
+				++Lag;
+			}
+			BestLag = Lag;
+			break;
+		}
+	}
+
+	// No dip below the threshold, so fall back to the global minimum
+	if (BestLag < 0)
+	{
+		BestLag = MinLag;
+		for (int64 Lag = MinLag + 1; Lag <= MaxLag; ++Lag)
+		{
+			if (Autocorrelation[Lag] < Autocorrelation[BestLag])
+			{
+				BestLag = Lag;
+			}
+		}
+	}
+
+	float Difference;
+	InterpolateParabolic(Autocorrelation, BestLag, OutPeriod, Difference);
+	OutConfidence = 1.f - Difference;
+
+	return true;
+}
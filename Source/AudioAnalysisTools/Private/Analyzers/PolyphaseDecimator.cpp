@@ -0,0 +1,111 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/PolyphaseDecimator.h"
+#include "WindowsLibrary.h"
+#include "Math/UnrealMathUtility.h"
+
+namespace
+{
+	/** The number of filter taps per polyphase branch. Together with the Kaiser beta it sets the transition width, which ends at the output Nyquist frequency */
+	constexpr int64 TapsPerBranch = 32;
+
+	/** The shape parameter of the Kaiser window, giving about 85 dB of stopband attenuation */
+	constexpr float KaiserBeta = 8.6f;
+
+	/** The cutoff frequency relative to the output sample rate, leaving the transition band below the output Nyquist frequency */
+	constexpr double RelativeCutoff = 0.4;
+}
+
+FPolyphaseDecimator::FPolyphaseDecimator()
+	: Factor(EAudioDecimationFactor::None),
+	  NextOutputOffset(0)
+{
+}
+
+void FPolyphaseDecimator::Reset(EAudioDecimationFactor InFactor)
+{
+	Factor = InFactor;
+	NextOutputOffset = 0;
+
+	const int32 FactorValue = GetFactorValue();
+	if (FactorValue <= 1)
+	{
+		ReversedTaps.Reset();
+		History.Reset();
+		return;
+	}
+
+	const int64 NumTaps = TapsPerBranch * FactorValue;
+	const TArray64<float> Window = UWindowsLibrary::CreateKaiserWindow(NumTaps, KaiserBeta);
+
+	// Windowed sinc with the cutoff given in cycles per input sample
+	const double Cutoff = RelativeCutoff / FactorValue;
+	const double Center = (NumTaps - 1) / 2.;
+
+	ReversedTaps.SetNumUninitialized(NumTaps);
+	double TapSum = 0;
+
+	for (int64 Index = 0; Index < NumTaps; ++Index)
+	{
+		const double Position = Index - Center;
+		const double Sinc = FMath::IsNearlyZero(Position) ? 1. : FMath::Sin(2. * PI * Cutoff * Position) / (2. * PI * Cutoff * Position);
+		const double Tap = 2. * Cutoff * Sinc * Window[Index];
+
+		ReversedTaps[NumTaps - 1 - Index] = static_cast<float>(Tap);
+		TapSum += Tap;
+	}
+
+	// Unity gain at DC
+	for (float& Tap : ReversedTaps)
+	{
+		Tap = static_cast<float>(Tap / TapSum);
+	}
+
+	History.SetNumZeroed(NumTaps - 1);
+}
+
+void FPolyphaseDecimator::Process(TArrayView64<const float> AudioFrames, TArray64<float>& OutDecimatedFrames)
+{
+	const int32 FactorValue = GetFactorValue();
+	if (FactorValue <= 1)
+	{
+		OutDecimatedFrames = TArray64<float>(AudioFrames.GetData(), AudioFrames.Num());
+		return;
+	}
+
+	const int64 NumTaps = ReversedTaps.Num();
+	const int64 HistorySize = NumTaps - 1;
+
+	// The buffer only grows, so blocks of a constant size do not allocate
+	const int64 NumSamples = HistorySize + AudioFrames.Num();
+	if (History.Num() < NumSamples)
+	{
+		History.SetNumUninitialized(NumSamples);
+	}
+	FMemory::Memcpy(History.GetData() + HistorySize, AudioFrames.GetData(), AudioFrames.Num() * sizeof(float));
+
+	OutDecimatedFrames.Reset();
+
+	const float* Taps = ReversedTaps.GetData();
+	const float* Samples = History.GetData();
+
+	// Each retained sample is filtered over the NumTaps samples ending at it
+	int64 Position = HistorySize + NextOutputOffset;
+	for (; Position < NumSamples; Position += FactorValue)
+	{
+		const float* Start = Samples + Position - HistorySize;
+
+		float Sum = 0.f;
+		for (int64 TapIndex = 0; TapIndex < NumTaps; ++TapIndex)
+		{
+			Sum += Taps[TapIndex] * Start[TapIndex];
+		}
+
+		OutDecimatedFrames.Add(Sum);
+	}
+
+	NextOutputOffset = Position - NumSamples;
+
+	// Keep the last samples as the history of the next block
+	FMemory::Memmove(History.GetData(), History.GetData() + AudioFrames.Num(), HistorySize * sizeof(float));
+}
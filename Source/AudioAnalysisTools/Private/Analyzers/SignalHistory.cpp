@@ -0,0 +1,173 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/SignalHistory.h"
+
+FSignalHistory::FSignalHistory()
+	: MaxCandidatesFront(0),
+	  NumMaxCandidates(0),
+	  FirstIndex(0),
+	  NumValues(0),
+	  WindowStart(0),
+	  WindowSum(0),
+	  WindowCountAboveThreshold(0),
+	  WindowDuration(0),
+	  Threshold(0)
+{
+}
+
+void FSignalHistory::Reset(int64 Capacity, double InWindowDuration, float InThreshold)
+{
+	Capacity = FMath::Max<int64>(Capacity, 0);
+
+	Values.SetNumZeroed(Capacity);
+	Timestamps.SetNumZeroed(Capacity);
+	MaxCandidates.SetNumZeroed(Capacity);
+
+	WindowDuration = FMath::Max(InWindowDuration, 0.);
+	Threshold = InThreshold;
+
+	Clear();
+}
+
+void FSignalHistory::Clear()
+{
+	MaxCandidatesFront = 0;
+	NumMaxCandidates = 0;
+	FirstIndex = 0;
+	NumValues = 0;
+	WindowStart = 0;
+	WindowSum = 0;
+	WindowCountAboveThreshold = 0;
+}
+
+void FSignalHistory::Add(float Value, double Timestamp)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	if (NumValues > 0 && Timestamp < GetTimestamp(0))
+	{
+		Clear();
+	}
+
+	const int64 Capacity = Values.Num();
+
+	// Evict the oldest value if the history is full. It may have already left the aggregate window
+	if (NumValues == Capacity)
+	{
+		if (WindowStart == FirstIndex)
+		{
+			PopWindowFront();
+		}
+
+		++FirstIndex;
+		--NumValues;
+	}
+
+	const int64 Index = FirstIndex + NumValues;
+	const int64 Slot = ToSlot(Index);
+
+	Values[Slot] = Value;
+	Timestamps[Slot] = Timestamp;
+	++NumValues;
+
+	// Enter the aggregate window
+	WindowSum += Value;
+	WindowCountAboveThreshold += Value > Threshold ? 1 : 0;
+
+	// Values not larger than the new one can never be the window maximum again
+	while (NumMaxCandidates > 0 && Values[ToSlot(MaxCandidates[(MaxCandidatesFront + NumMaxCandidates - 1) % Capacity])] <= Value)
+	{
+		--NumMaxCandidates;
+	}
+	MaxCandidates[(MaxCandidatesFront + NumMaxCandidates) % Capacity] = Index;
+	++NumMaxCandidates;
+
+	// Leave the aggregate window once older than the window duration
+	while (WindowStart < Index && Timestamps[ToSlot(WindowStart)] <= Timestamp - WindowDuration)
+	{
+		PopWindowFront();
+	}
+}
+
+void FSignalHistory::PopWindowFront()
+{
+	const float Value = Values[ToSlot(WindowStart)];
+
+	WindowSum -= Value;
+	WindowCountAboveThreshold -= Value > Threshold ? 1 : 0;
+
+	if (NumMaxCandidates > 0 && MaxCandidates[MaxCandidatesFront] == WindowStart)
+	{
+		MaxCandidatesFront = (MaxCandidatesFront + 1) % Values.Num();
+		--NumMaxCandidates;
+	}
+
+	++WindowStart;
+
+	// Drop the accumulated rounding error whenever the window becomes empty
+	if (WindowStart == FirstIndex + NumValues)
+	{
+		WindowSum = 0;
+	}
+}
+
+float FSignalHistory::GetWindowMax() const
+{
+	return NumMaxCandidates > 0 ? Values[ToSlot(MaxCandidates[MaxCandidatesFront])] : 0;
+}
+
+float FSignalHistory::GetWindowMean() const
+{
+	const int64 WindowNum = GetWindowNum();
+	return WindowNum > 0 ? static_cast<float>(WindowSum / WindowNum) : 0;
+}
+
+int64 FSignalHistory::GetLookback(double Duration, TArrayView64<const float> OutValues[2], TArrayView64<const double> OutTimestamps[2]) const
+{
+	OutValues[0] = OutValues[1] = TArrayView64<const float>();
+	OutTimestamps[0] = OutTimestamps[1] = TArrayView64<const double>();
+
+	if (NumValues <= 0)
+	{
+		return 0;
+	}
+
+	const int64 EndIndex = FirstIndex + NumValues;
+	int64 StartIndex = FirstIndex;
+
+	if (Duration >= 0)
+	{
+		// The timestamps are ascending, so the first value within the duration is found with a binary search
+		const double StartTime = GetTimestamp(0) - Duration;
+
+		int64 Low = FirstIndex;
+		int64 High = EndIndex - 1;
+		while (Low < High)
+		{
+			const int64 Middle = Low + (High - Low) / 2;
+			if (Timestamps[ToSlot(Middle)] > StartTime)
+			{
+				High = Middle;
+			}
+			else
+			{
+				Low = Middle + 1;
+			}
+		}
+		StartIndex = Low;
+	}
+
+	const int64 Count = EndIndex - StartIndex;
+	const int64 StartSlot = ToSlot(StartIndex);
+	const int64 FirstCount = FMath::Min(Count, Values.Num() - StartSlot);
+
+	OutValues[0] = TArrayView64<const float>(Values.GetData() + StartSlot, FirstCount);
+	OutValues[1] = TArrayView64<const float>(Values.GetData(), Count - FirstCount);
+	OutTimestamps[0] = TArrayView64<const double>(Timestamps.GetData() + StartSlot, FirstCount);
+	OutTimestamps[1] = TArrayView64<const double>(Timestamps.GetData(), Count - FirstCount);
+
+	return Count;
+}
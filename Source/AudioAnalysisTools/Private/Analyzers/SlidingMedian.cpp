@@ -0,0 +1,188 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/SlidingMedian.h"
+
+FSlidingMedian::FSlidingMedian()
+	: NextSlot(0),
+	  NumValues(0),
+	  Sum(0)
+{
+	LowerHalf.bMaxHeap = true;
+	UpperHalf.bMaxHeap = false;
+}
+
+void FSlidingMedian::Reset(int64 WindowSize)
+{
+	WindowSize = FMath::Max<int64>(WindowSize, 1);
+
+	Values.SetNumZeroed(WindowSize);
+	HeapPositions.SetNumZeroed(WindowSize);
+	InLowerHalf.SetNumZeroed(WindowSize);
+
+	// Either half may temporarily hold one extra value before rebalancing
+	LowerHalf.Slots.SetNumZeroed(WindowSize / 2 + 2);
+	UpperHalf.Slots.SetNumZeroed(WindowSize / 2 + 2);
+	LowerHalf.Num = 0;
+	UpperHalf.Num = 0;
+
+	NextSlot = 0;
+	NumValues = 0;
+	Sum = 0;
+}
+
+void FSlidingMedian::Add(float Value)
+{
+	if (Values.Num() <= 0)
+	{
+		Reset(1);
+	}
+
+	const int64 Slot = NextSlot;
+
+	if (NumValues == Values.Num())
+	{
+		// Evict the oldest value, which occupies the slot being overwritten
+		Sum -= Values[Slot];
+		RemoveAt(InLowerHalf[Slot] ? LowerHalf : UpperHalf, HeapPositions[Slot]);
+	}
+	else
+	{
+		++NumValues;
+	}
+
+	Values[Slot] = Value;
+	Sum += Value;
+
+	if (LowerHalf.Num <= 0 || Value <= Values[LowerHalf.Slots[0]])
+	{
+		Push(LowerHalf, Slot);
+	}
+	else
+	{
+		Push(UpperHalf, Slot);
+	}
+
+	Rebalance();
+
+	NextSlot = (Slot + 1) % Values.Num();
+}
+
+float FSlidingMedian::GetMedian() const
+{
+	if (NumValues <= 0)
+	{
+		return 0;
+	}
+
+	if (LowerHalf.Num > UpperHalf.Num)
+	{
+		return Values[LowerHalf.Slots[0]];
+	}
+
+	return 0.5f * (Values[LowerHalf.Slots[0]] + Values[UpperHalf.Slots[0]]);
+}
+
+float FSlidingMedian::GetMean() const
+{
+	return NumValues > 0 ? static_cast<float>(Sum / NumValues) : 0;
+}
+
+bool FSlidingMedian::IsAbove(const FHeap& Heap, int64 FirstSlot, int64 SecondSlot) const
+{
+	return Heap.bMaxHeap ? Values[FirstSlot] > Values[SecondSlot] : Values[FirstSlot] < Values[SecondSlot];
+}
+
+void FSlidingMedian::SetHeapSlot(FHeap& Heap, int64 Position, int64 Slot)
+{
+	Heap.Slots[Position] = Slot;
+	HeapPositions[Slot] = Position;
+	InLowerHalf[Slot] = &Heap == &LowerHalf;
+}
+
+void FSlidingMedian::SiftUp(FHeap& Heap, int64 Position)
+{
+	const int64 Slot = Heap.Slots[Position];
+
+	while (Position > 0)
+	{
+		const int64 ParentPosition = (Position - 1) / 2;
+		const int64 ParentSlot = Heap.Slots[ParentPosition];
+
+		if (!IsAbove(Heap, Slot, ParentSlot))
+		{
+			break;
+		}
+
+		SetHeapSlot(Heap, Position, ParentSlot);
+		Position = ParentPosition;
+	}
+
+	SetHeapSlot(Heap, Position, Slot);
+}
+
+void FSlidingMedian::SiftDown(FHeap& Heap, int64 Position)
+{
+	const int64 Slot = Heap.Slots[Position];
+	const int64 HeapSize = Heap.Num;
+
+	while (true)
+	{
+		int64 ChildPosition = 2 * Position + 1;
+		if (ChildPosition >= HeapSize)
+		{
+			break;
+		}
+
+		if (ChildPosition + 1 < HeapSize && IsAbove(Heap, Heap.Slots[ChildPosition + 1], Heap.Slots[ChildPosition]))
+		{
+			++ChildPosition;
+		}
+
+		const int64 ChildSlot = Heap.Slots[ChildPosition];
+		if (!IsAbove(Heap, ChildSlot, Slot))
+		{
+			break;
+		}
+
+		SetHeapSlot(Heap, Position, ChildSlot);
+		Position = ChildPosition;
+	}
+
+	SetHeapSlot(Heap, Position, Slot);
+}
+
+void FSlidingMedian::Push(FHeap& Heap, int64 Slot)
+{
+	Heap.Slots[Heap.Num++] = Slot;
+	SiftUp(Heap, Heap.Num - 1);
+}
+
+void FSlidingMedian::RemoveAt(FHeap& Heap, int64 Position)
+{
+	const int64 LastSlot = Heap.Slots[--Heap.Num];
+
+	if (Position < Heap.Num)
+	{
+		// Fill the gap with the last slot, which may need to move either way
+		SetHeapSlot(Heap, Position, LastSlot);
+		SiftUp(Heap, Position);
+		SiftDown(Heap, HeapPositions[LastSlot]);
+	}
+}
+
+void FSlidingMedian::Rebalance()
+{
+	while (LowerHalf.Num > UpperHalf.Num + 1)
+	{
+		const int64 Slot = LowerHalf.Slots[0];
+		RemoveAt(LowerHalf, 0);
+		Push(UpperHalf, Slot);
+	}
+
+	while (UpperHalf.Num > LowerHalf.Num)
+	{
+		const int64 Slot = UpperHalf.Slots[0];
+		RemoveAt(UpperHalf, 0);
+		Push(LowerHalf, Slot);
+	}
+}
@@ -0,0 +1,192 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/SpectrumBandMap.h"
+#include "Math/UnrealMathUtility.h"
+
+namespace
+{
+	/** Sum a contiguous range using independent accumulators, so that the compiler can keep the additions in vector registers */
+	FORCEINLINE float SumRange(const float* Values, int64 Num)
+	{
+		float Sum0 = 0, Sum1 = 0, Sum2 = 0, Sum3 = 0;
+
+		int64 Index = 0;
+		for (; Index + 4 <= Num; Index += 4)
+		{
+			Sum0 += Values[Index];
+			Sum1 += Values[Index + 1];
+			Sum2 += Values[Index + 2];
+			Sum3 += Values[Index + 3];
+		}
+		for (; Index < Num; ++Index)
+		{
+			Sum0 += Values[Index];
+		}
+
+		return (Sum0 + Sum1) + (Sum2 + Sum3);
+	}
+
+	/** Sum the squares of a contiguous range using independent accumulators */
+	FORCEINLINE float SumSquaresRange(const float* Values, int64 Num)
+	{
+		float Sum0 = 0, Sum1 = 0, Sum2 = 0, Sum3 = 0;
+
+		int64 Index = 0;
+		for (; Index + 4 <= Num; Index += 4)
+		{
+			Sum0 += Values[Index] * Values[Index];
+			Sum1 += Values[Index + 1] * Values[Index + 1];
+			Sum2 += Values[Index + 2] * Values[Index + 2];
+			Sum3 += Values[Index + 3] * Values[Index + 3];
+		}
+		for (; Index < Num; ++Index)
+		{
+			Sum0 += Values[Index] * Values[Index];
+		}
+
+		return (Sum0 + Sum1) + (Sum2 + Sum3);
+	}
+}
+
+FSpectrumBandMap::FSpectrumBandMap()
+	: SpectrumSize(0),
+	  SampleRate(0)
+{
+}
+
+void FSpectrumBandMap::Build(const TArray64<float>& LowEdges, const TArray64<float>& HighEdges, int64 InSpectrumSize, int32 InSampleRate)
+{
+	check(LowEdges.Num() == HighEdges.Num());
+
+	SpectrumSize = InSpectrumSize;
+	SampleRate = InSampleRate;
+
+	Bands.SetNum(LowEdges.Num());
+
+	if (SpectrumSize <= 0 || SampleRate <= 0)
+	{
+		for (FBand& Band : Bands)
+		{
+			Band = FBand();
+		}
+		return;
+	}
+
+	// The magnitude spectrum holds half of the FFT bins, so each bin is SampleRate / (2 * SpectrumSize) Hz wide
+	const double BinWidth = static_cast<double>(SampleRate) / (2. * SpectrumSize);
+
+	for (int64 BandIndex = 0; BandIndex < Bands.Num(); ++BandIndex)
+	{
+		FBand& Band = Bands[BandIndex];
+		Band = FBand();
+
+		// Continuous bin positions, where bin K covers [K, K + 1) since it is centered at K * BinWidth
+		const double LowPosition = FMath::Clamp(LowEdges[BandIndex] / BinWidth + 0.5, 0., static_cast<double>(SpectrumSize));
+		const double HighPosition = FMath::Clamp(HighEdges[BandIndex] / BinWidth + 0.5, 0., static_cast<double>(SpectrumSize));
+
+		if (HighPosition <= LowPosition)
+		{
+			// The band is empty or lies entirely above the Nyquist frequency
+			continue;
+		}
+
+		Band.FirstBin = FMath::Min(static_cast<int64>(LowPosition), SpectrumSize - 1);
+		Band.LastBin = FMath::Min(static_cast<int64>(FMath::CeilToDouble(HighPosition)) - 1, SpectrumSize - 1);
+
+		if (Band.FirstBin == Band.LastBin)
+		{
+			Band.FirstWeight = static_cast<float>(HighPosition - LowPosition);
+			Band.LastWeight = 0;
+			Band.TotalWeight = Band.FirstWeight;
+		}
+		else
+		{
+			Band.FirstWeight = static_cast<float>(Band.FirstBin + 1 - LowPosition);
+			Band.LastWeight = static_cast<float>(HighPosition - Band.LastBin);
+			Band.TotalWeight = Band.FirstWeight + Band.LastWeight + static_cast<float>(Band.LastBin - Band.FirstBin - 1);
+		}
+	}
+}
+
+void FSpectrumBandMap::ComputeMean(const float* Spectrum, float* OutBands) const
+{
+	for (int64 BandIndex = 0; BandIndex < Bands.Num(); ++BandIndex)
+	{
+		const FBand& Band = Bands[BandIndex];
+
+		if (Band.TotalWeight <= 0)
+		{
+			OutBands[BandIndex] = 0;
+			continue;
+		}
+
+		float Sum = Spectrum[Band.FirstBin] * Band.FirstWeight;
+
+		if (Band.LastBin > Band.FirstBin)
+		{
+			Sum += SumRange(Spectrum + Band.FirstBin + 1, Band.LastBin - Band.FirstBin - 1);
+			Sum += Spectrum[Band.LastBin] * Band.LastWeight;
+		}
+
+		OutBands[BandIndex] = Sum / Band.TotalWeight;
+	}
+}
+
+void FSpectrumBandMap::ComputeRootMeanSquare(const float* Spectrum, float* OutBands) const
+{
+	for (int64 BandIndex = 0; BandIndex < Bands.Num(); ++BandIndex)
+	{
+		const FBand& Band = Bands[BandIndex];
+
+		if (Band.TotalWeight <= 0)
+		{
+			OutBands[BandIndex] = 0;
+			continue;
+		}
+
+		float Sum = Spectrum[Band.FirstBin] * Spectrum[Band.FirstBin] * Band.FirstWeight;
+
+		if (Band.LastBin > Band.FirstBin)
+		{
+			Sum += SumSquaresRange(Spectrum + Band.FirstBin + 1, Band.LastBin - Band.FirstBin - 1);
+			Sum += Spectrum[Band.LastBin] * Spectrum[Band.LastBin] * Band.LastWeight;
+		}
+
+		OutBands[BandIndex] = FMath::Sqrt(Sum / Band.TotalWeight);
+	}
+}
+
+void FSpectrumBandMap::ComputeMeanAndVariance(const float* Spectrum, float* OutMeans, float* OutVariances) const
+{
+	ComputeMean(Spectrum, OutMeans);
+
+	for (int64 BandIndex = 0; BandIndex < Bands.Num(); ++BandIndex)
+	{
+		const FBand& Band = Bands[BandIndex];
+
+		if (Band.TotalWeight <= 0)
+		{
+			OutVariances[BandIndex] = 0;
+			continue;
+		}
+
+		const float Mean = OutMeans[BandIndex];
+
+		float Deviation = Spectrum[Band.FirstBin] - Mean;
+		float Sum = Deviation * Deviation * Band.FirstWeight;
+
+		if (Band.LastBin > Band.FirstBin)
+		{
+			for (int64 Bin = Band.FirstBin + 1; Bin < Band.LastBin; ++Bin)
+			{
+				Deviation = Spectrum[Bin] - Mean;
+				Sum += Deviation * Deviation;
+			}
+
+			Deviation = Spectrum[Band.LastBin] - Mean;
+			Sum += Deviation * Deviation * Band.LastWeight;
+		}
+
+		OutVariances[BandIndex] = Sum / Band.TotalWeight;
+	}
+}
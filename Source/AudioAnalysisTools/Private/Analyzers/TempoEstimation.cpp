@@ -0,0 +1,245 @@
+// Georgy Treshchev 2024.
+
+#include "Analyzers/TempoEstimation.h"
+#include "AudioAnalysisToolsDefines.h"
+#include "Math/UnrealMathUtility.h"
+
+namespace
+{
+	/** The tempo preferred when several periods score similarly (center of the log-Gaussian tempo prior) */
+	constexpr float PreferredBPM = 120.f;
+
+	/** The width of the tempo prior, in octaves */
+	constexpr float TempoPriorWidth = 1.f;
+
+	/** The smoothing applied to the measured onset detection function rate */
+	constexpr float FrameRateSmoothing = 0.9f;
+}
+
+UTempoEstimation::UTempoEstimation()
+	: HistoryPosition(0),
+	  NumValues(0),
+	  ValuesSinceUpdate(0),
+	  UpdateInterval(0),
+	  MinBPM(0),
+	  MaxBPM(0),
+	  FrameRate(0),
+	  BPM(0),
+	  Confidence(0),
+	  BeatPeriod(0),
+	  PaddedSize(0),
+	  ForwardFFT(nullptr),
+	  InverseFFT(nullptr)
+{
+}
+
+void UTempoEstimation::BeginDestroy()
+{
+	FreeFFT();
+
+	Super::BeginDestroy();
+}
+
+UTempoEstimation* UTempoEstimation::CreateTempoEstimation(int64 InHistorySize, int64 InUpdateInterval, float InMinBPM, float InMaxBPM)
+{
+	UTempoEstimation* TempoEstimation = NewObject<UTempoEstimation>();
+	TempoEstimation->UpdateParameters(InHistorySize, InUpdateInterval, InMinBPM, InMaxBPM);
+	return TempoEstimation;
+}
+
+void UTempoEstimation::UpdateParameters(int64 InHistorySize, int64 InUpdateInterval, float InMinBPM, float InMaxBPM)
+{
+	if (InHistorySize <= 1 || InUpdateInterval <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update tempo estimation parameters: history size is '%lld' and update interval is '%lld', expected > '1' and > '0'"), InHistorySize, InUpdateInterval);
+		return;
+	}
+
+	if (!(InMinBPM > 0 && InMaxBPM > InMinBPM))
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update tempo estimation parameters: min BPM is '%f' and max BPM is '%f', expected 0 < min < max"), InMinBPM, InMaxBPM);
+		return;
+	}
+
+	UE_LOG(LogAudioAnalysis, Log, TEXT("Updating Tempo Estimation history size from '%lld' to '%lld'"), OnsetHistory.Num(), InHistorySize);
+
+	UpdateInterval = InUpdateInterval;
+	MinBPM = InMinBPM;
+	MaxBPM = InMaxBPM;
+
+	OnsetHistory.Init(0, InHistorySize);
+	Autocorrelation.SetNumZeroed(InHistorySize);
+	HistoryPosition = 0;
+	NumValues = 0;
+	ValuesSinceUpdate = 0;
+
+	BPM = 0;
+	Confidence = 0;
+	BeatPeriod = 0;
+
+	// Zero-pad to at least 2N - 1 so the circular correlation equals the linear one for all lags
+	const int64 NewPaddedSize = UFFTAudioAnalyzer::GetNextFastSize(2 * InHistorySize - 1);
+
+	if (NewPaddedSize != PaddedSize || !ForwardFFT || !InverseFFT)
+	{
+		FreeFFT();
+
+		PaddedSize = NewPaddedSize;
+		ForwardFFT = UFFTAudioAnalyzer::PerformFFTAlloc(PaddedSize, 0, nullptr, nullptr);
+		InverseFFT = UFFTAudioAnalyzer::PerformFFTAlloc(PaddedSize, 1, nullptr, nullptr);
+
+		FFTInput.SetNumUninitialized(PaddedSize);
+		FFTOutput.SetNumUninitialized(PaddedSize);
+	}
+}
+
+void UTempoEstimation::FreeFFT()
+{
+	FMemory::Free(ForwardFFT);
+	FMemory::Free(InverseFFT);
+
+	ForwardFFT = nullptr;
+	InverseFFT = nullptr;
+}
+
+bool UTempoEstimation::ProcessOnsetValue(float OnsetValue, float DeltaTime)
+{
+	if (OnsetHistory.Num() <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot process onset value: the tempo estimation parameters have not been set"));
+		return false;
+	}
+
+	if (DeltaTime > 0)
+	{
+		const float InstantFrameRate = 1.f / DeltaTime;
+		FrameRate = FrameRate > 0 ? FrameRateSmoothing * FrameRate + (1.f - FrameRateSmoothing) * InstantFrameRate : InstantFrameRate;
+	}
+
+	OnsetHistory[HistoryPosition] = OnsetValue;
+	HistoryPosition = (HistoryPosition + 1) % OnsetHistory.Num();
+	NumValues = FMath::Min(NumValues + 1, OnsetHistory.Num());
+
+	if (++ValuesSinceUpdate < UpdateInterval)
+	{
+		return false;
+	}
+
+	ValuesSinceUpdate = 0;
+	UpdateTempo();
+
+	return true;
+}
+
+void UTempoEstimation::UpdateTempo()
+{
+	if (FrameRate <= 0)
+	{
+		return;
+	}
+
+	const int64 HistorySize = OnsetHistory.Num();
+
+	// The lags (in frames) that correspond to the tempo range
+	const int64 MinLag = FMath::Max<int64>(1, FMath::FloorToInt(60.f * FrameRate / MaxBPM));
+	const int64 MaxLag = FMath::Min<int64>(FMath::CeilToInt(60.f * FrameRate / MinBPM), NumValues - 2);
+
+	if (MaxLag <= MinLag)
+	{
+		// Not enough values collected yet
+		return;
+	}
+
+	// Unroll the ring in chronological order, removing the mean so that the autocorrelation is not dominated by the DC offset
+	const int64 OldestPosition = NumValues < HistorySize ? 0 : HistoryPosition;
+
+	float Mean = 0;
+	for (int64 Index = 0; Index < NumValues; ++Index)
+	{
+		Mean += OnsetHistory[(OldestPosition + Index) % HistorySize];
+	}
+	Mean /= NumValues;
+
+	for (int64 Index = 0; Index < NumValues; ++Index)
+	{
+		FFTInput[Index].Real = OnsetHistory[(OldestPosition + Index) % HistorySize] - Mean;
+		FFTInput[Index].Imaginary = 0;
+	}
+	FMemory::Memzero(FFTInput.GetData() + NumValues, sizeof(FFTComplexSamples) * (PaddedSize - NumValues));
+
+	UFFTAudioAnalyzer::PerformFFT(ForwardFFT, FFTInput.GetData(), FFTOutput.GetData());
+
+	// The autocorrelation is the inverse transform of the power spectrum
+	for (int64 Index = 0; Index < PaddedSize; ++Index)
+	{
+		const FFTComplexSamples& Sample = FFTOutput[Index];
+
+		FFTInput[Index].Real = Sample.Real * Sample.Real + Sample.Imaginary * Sample.Imaginary;
+		FFTInput[Index].Imaginary = 0;
+	}
+
+	UFFTAudioAnalyzer::PerformFFT(InverseFFT, FFTInput.GetData(), FFTOutput.GetData());
+
+	// Unbiased autocorrelation: compensate for the smaller overlap at larger lags
+	for (int64 Lag = 0; Lag < NumValues; ++Lag)
+	{
+		Autocorrelation[Lag] = FFTOutput[Lag].Real / (PaddedSize * static_cast<float>(NumValues - Lag));
+	}
+
+	if (Autocorrelation[0] <= 0)
+	{
+		BPM = 0;
+		Confidence = 0;
+		BeatPeriod = 0;
+		return;
+	}
+
+	// Comb-like score: the period and its double should both correlate, weighted by a log-Gaussian tempo prior
+	int64 BestLag = -1;
+	float BestScore = 0;
+
+	for (int64 Lag = MinLag; Lag <= MaxLag; ++Lag)
+	{
+		const float Octaves = FMath::Log2((60.f * FrameRate / Lag) / PreferredBPM) / TempoPriorWidth;
+		const float Prior = FMath::Exp(-0.5f * Octaves * Octaves);
+
+		float Score = Autocorrelation[Lag];
+		if (2 * Lag < NumValues)
+		{
+			Score += 0.5f * Autocorrelation[2 * Lag];
+		}
+		Score *= Prior;
+
+		if (Score > BestScore)
+		{
+			BestScore = Score;
+			BestLag = Lag;
+		}
+	}
+
+	if (BestLag < 0)
+	{
+		BPM = 0;
+		Confidence = 0;
+		BeatPeriod = 0;
+		return;
+	}
+
+	// Refine the period with parabolic interpolation of the autocorrelation
+	float Period = static_cast<float>(BestLag);
+	{
+		const float Previous = Autocorrelation[BestLag - 1];
+		const float Current = Autocorrelation[BestLag];
+		const float Next = Autocorrelation[BestLag + 1];
+		const float Denominator = Previous - 2 * Current + Next;
+
+		if (!FMath::IsNearlyZero(Denominator))
+		{
+			Period += FMath::Clamp(0.5f * (Previous - Next) / Denominator, -0.5f, 0.5f);
+		}
+	}
+
+	BeatPeriod = Period;
+	BPM = 60.f * FrameRate / Period;
+	Confidence = FMath::Clamp(Autocorrelation[BestLag] / Autocorrelation[0], 0.f, 1.f);
+}
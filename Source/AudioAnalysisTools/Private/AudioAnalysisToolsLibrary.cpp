@@ -5,8 +5,16 @@
 
 #include "Analyzers/CoreFrequencyDomainFeatures.h"
 #include "Analyzers/CoreTimeDomainFeatures.h"
+#include "Analyzers/BandAnalysis.h"
 #include "Analyzers/BeatDetection.h"
+#include "Analyzers/BeatTracker.h"
+#include "Analyzers/ConstantQAnalysis.h"
+#include "Analyzers/EnvelopeAnalysis.h"
+#include "Analyzers/LoudnessAnalysis.h"
 #include "Analyzers/OnsetDetection.h"
+#include "Analyzers/OnsetPeakPicker.h"
+#include "Analyzers/PitchDetection.h"
+#include "Analyzers/TempoEstimation.h"
 
 #include "Analyzers/FFTAudioAnalyzer.h"
 
@@ -14,7 +22,30 @@
 #include "Misc/ScopeLock.h"
 
 UAudioAnalysisToolsLibrary::UAudioAnalysisToolsLibrary()
-	: FFTConfigured(false)
+	: FFTSize(0),
+	  FFTConfigured(false),
+	  MaterializedFFTOutputs(EFFTOutputs::None),
+	  bConstantQProcessed(false),
+	  ConstantQParametersRevision(0),
+	  SampleRate(44100),
+	  NumChannels(1),
+	  CurrentTimestamp(0),
+	  NextTimestamp(0),
+	  FrameDeltaTime(0),
+	  CurrentOnsetValue(0),
+	  DecimatedFFT_Configuration(nullptr),
+	  bProcessToOnsetDetection(false),
+	  bProcessToBandAnalysis(false),
+	  bProcessToPitchDetection(false),
+	  bProcessToTempoEstimation(false),
+	  bProcessToBeatTracker(false),
+	  bProcessToOnsetPeakPicker(false),
+	  bProcessToEnvelopeAnalysis(false),
+	  bProcessToLoudnessAnalysis(false),
+	  bBroadcastEvents(false),
+	  EagerFFTOutputs(static_cast<int32>(EFFTOutputs::Magnitude)),
+	  bZeroPadToFastFFTSize(false),
+	  BeatDetectionDecimation(EAudioDecimationFactor::None)
 {
 }
 
@@ -25,6 +56,8 @@ void UAudioAnalysisToolsLibrary::BeginDestroy()
 		FreeFFT();
 	}
 
+	FreeDecimatedFFT();
+
 	Super::BeginDestroy();
 }
 
@@ -37,7 +70,14 @@ UAudioAnalysisToolsLibrary* UAudioAnalysisToolsLibrary::CreateAudioAnalysisTools
 
 bool UAudioAnalysisToolsLibrary::GetAudioByCurrentTime(UImportedSoundWave* ImportedSoundWave, TArray<float>& AudioFrames)
 {
-	return GetAudioByFrameSize(ImportedSoundWave, CurrentAudioFrames.Num(), AudioFrames);
+	if (!GetAudioByFrameSize(ImportedSoundWave, CurrentAudioFrames.Num() / NumChannels, AudioFrames))
+	{
+		return false;
+	}
+
+	UpdateSampleRate(ImportedSoundWave->GetSampleRate());
+	UpdateNumChannels(ImportedSoundWave->NumChannels);
+	return true;
 }
 
 bool UAudioAnalysisToolsLibrary::GetAudioByFrameSize(UImportedSoundWave* ImportedSoundWave, int64 FrameSize, TArray<float>& AudioFrames)
@@ -177,6 +217,30 @@ void UAudioAnalysisToolsLibrary::Initialize(int64 FrameSize, EAnalysisWindowType
 	OnsetDetection = UOnsetDetection::CreateOnsetDetection(FrameSize);
 	check(OnsetDetection);
 
+	ConstantQAnalysis = UConstantQAnalysis::CreateConstantQAnalysis();
+	check(ConstantQAnalysis);
+
+	BandAnalysis = UBandAnalysis::CreateBandAnalysis();
+	check(BandAnalysis);
+
+	PitchDetection = UPitchDetection::CreatePitchDetection();
+	check(PitchDetection);
+
+	TempoEstimation = UTempoEstimation::CreateTempoEstimation();
+	check(TempoEstimation);
+
+	BeatTracker = UBeatTracker::CreateBeatTracker();
+	check(BeatTracker);
+
+	OnsetPeakPicker = UOnsetPeakPicker::CreateOnsetPeakPicker();
+	check(OnsetPeakPicker);
+
+	EnvelopeAnalysis = UEnvelopeAnalysis::CreateEnvelopeAnalysis();
+	check(EnvelopeAnalysis);
+
+	LoudnessAnalysis = ULoudnessAnalysis::CreateLoudnessAnalysis();
+	check(LoudnessAnalysis);
+
 	WindowType = InWindowType;
 
 	UpdateFrameSize(FrameSize);
@@ -184,6 +248,9 @@ void UAudioAnalysisToolsLibrary::Initialize(int64 FrameSize, EAnalysisWindowType
 
 TArray<float> UAudioAnalysisToolsLibrary::GetMagnitudeSpectrum() const
 {
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Magnitude);
+
 	if (MagnitudeSpectrum.Num() > TNumericLimits<int32>::Max())
 	{
 		UE_LOG(LogAudioAnalysis, Error, TEXT("Failed to get Magnitude Spectrum Real: Array with int32 size (max length: %d) cannot fit int64 size data (retrieved length: %lld)"), TNumericLimits<int32>::Max(), MagnitudeSpectrum.Num());
@@ -193,13 +260,18 @@ TArray<float> UAudioAnalysisToolsLibrary::GetMagnitudeSpectrum() const
 	return TArray<float>(MagnitudeSpectrum);
 }
 
-const TArray64<float>& UAudioAnalysisToolsLibrary::GetMagnitudeSpectrum64() const
+TArray64<float> UAudioAnalysisToolsLibrary::GetMagnitudeSpectrum64() const
 {
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Magnitude);
 	return MagnitudeSpectrum;
 }
 
 TArray<float> UAudioAnalysisToolsLibrary::GetFFTReal() const
 {
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Complex);
+
 	if (FFTReal.Num() > TNumericLimits<int32>::Max())
 	{
 		UE_LOG(LogAudioAnalysis, Error, TEXT("Failed to get FFT Real: Array with int32 size (max length: %d) cannot fit int64 size data (retrieved length: %lld)"), TNumericLimits<int32>::Max(), FFTReal.Num());
@@ -209,13 +281,18 @@ TArray<float> UAudioAnalysisToolsLibrary::GetFFTReal() const
 	return TArray<float>(FFTReal);
 }
 
-const TArray64<float>& UAudioAnalysisToolsLibrary::GetFFTReal64() const
+TArray64<float> UAudioAnalysisToolsLibrary::GetFFTReal64() const
 {
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Complex);
 	return FFTReal;
 }
 
 TArray<float> UAudioAnalysisToolsLibrary::GetFFTImaginary() const
 {
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Complex);
+
 	if (FFTImaginary.Num() > TNumericLimits<int32>::Max())
 	{
 		UE_LOG(LogAudioAnalysis, Error, TEXT("Failed to get FFT Imaginary: Array with int32 size (max length: %d) cannot fit int64 size data (retrieved length: %lld)"), TNumericLimits<int32>::Max(), FFTReal.Num());
@@ -225,20 +302,200 @@ TArray<float> UAudioAnalysisToolsLibrary::GetFFTImaginary() const
 	return TArray<float>(FFTImaginary);
 }
 
-const TArray64<float>& UAudioAnalysisToolsLibrary::GetFFTImaginary64() const
+TArray64<float> UAudioAnalysisToolsLibrary::GetFFTImaginary64() const
 {
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Complex);
 	return FFTImaginary;
 }
 
+TArray<float> UAudioAnalysisToolsLibrary::GetPowerSpectrum() const
+{
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Power);
+
+	if (PowerSpectrum.Num() > TNumericLimits<int32>::Max())
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Failed to get Power Spectrum: Array with int32 size (max length: %d) cannot fit int64 size data (retrieved length: %lld)"), TNumericLimits<int32>::Max(), PowerSpectrum.Num());
+		return TArray<float>();
+	}
+
+	return TArray<float>(PowerSpectrum);
+}
+
+TArray64<float> UAudioAnalysisToolsLibrary::GetPowerSpectrum64() const
+{
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Power);
+	return PowerSpectrum;
+}
+
+TArray<float> UAudioAnalysisToolsLibrary::GetPhaseSpectrum() const
+{
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Phase);
+
+	if (PhaseSpectrum.Num() > TNumericLimits<int32>::Max())
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Failed to get Phase Spectrum: Array with int32 size (max length: %d) cannot fit int64 size data (retrieved length: %lld)"), TNumericLimits<int32>::Max(), PhaseSpectrum.Num());
+		return TArray<float>();
+	}
+
+	return TArray<float>(PhaseSpectrum);
+}
+
+TArray64<float> UAudioAnalysisToolsLibrary::GetPhaseSpectrum64() const
+{
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Phase);
+	return PhaseSpectrum;
+}
+
+TArray<float> UAudioAnalysisToolsLibrary::GetDecibelSpectrum() const
+{
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Decibels);
+
+	if (DecibelSpectrum.Num() > TNumericLimits<int32>::Max())
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Failed to get Decibel Spectrum: Array with int32 size (max length: %d) cannot fit int64 size data (retrieved length: %lld)"), TNumericLimits<int32>::Max(), DecibelSpectrum.Num());
+		return TArray<float>();
+	}
+
+	return TArray<float>(DecibelSpectrum);
+}
+
+TArray64<float> UAudioAnalysisToolsLibrary::GetDecibelSpectrum64() const
+{
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Decibels);
+	return DecibelSpectrum;
+}
+
+bool UAudioAnalysisToolsLibrary::FillMagnitudeSpectrum(TArray<float>& Spectrum) const
+{
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Magnitude);
+	return AudioAnalysisTools::CopyToBlueprintArray(MagnitudeSpectrum, Spectrum, TEXT("magnitude spectrum"));
+}
+
+bool UAudioAnalysisToolsLibrary::FillFFTReal(TArray<float>& Values) const
+{
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Complex);
+	return AudioAnalysisTools::CopyToBlueprintArray(FFTReal, Values, TEXT("FFT real part"));
+}
+
+bool UAudioAnalysisToolsLibrary::FillFFTImaginary(TArray<float>& Values) const
+{
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Complex);
+	return AudioAnalysisTools::CopyToBlueprintArray(FFTImaginary, Values, TEXT("FFT imaginary part"));
+}
+
+bool UAudioAnalysisToolsLibrary::FillPowerSpectrum(TArray<float>& Spectrum) const
+{
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Power);
+	return AudioAnalysisTools::CopyToBlueprintArray(PowerSpectrum, Spectrum, TEXT("power spectrum"));
+}
+
+bool UAudioAnalysisToolsLibrary::FillPhaseSpectrum(TArray<float>& Spectrum) const
+{
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Phase);
+	return AudioAnalysisTools::CopyToBlueprintArray(PhaseSpectrum, Spectrum, TEXT("phase spectrum"));
+}
+
+bool UAudioAnalysisToolsLibrary::FillDecibelSpectrum(TArray<float>& Spectrum) const
+{
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Decibels);
+	return AudioAnalysisTools::CopyToBlueprintArray(DecibelSpectrum, Spectrum, TEXT("decibel spectrum"));
+}
+
+FAudioAnalysisFrameSnapshotRef UAudioAnalysisToolsLibrary::GetFrameSnapshot(EFFTOutputs Outputs) const
+{
+	FScopeLock Lock(&DataGuard);
+
+	if (CurrentFrameSnapshot.IsValid() && EnumHasAllFlags(CurrentFrameSnapshot->Outputs, Outputs))
+	{
+		return CurrentFrameSnapshot.ToSharedRef();
+	}
+
+	// The snapshot may be shared with other readers already, so missing outputs go into a new one
+	Outputs |= CurrentFrameSnapshot.IsValid() ? CurrentFrameSnapshot->Outputs : EFFTOutputs::None;
+	MaterializeFFTOutputs(Outputs);
+
+	constexpr int32 MaxPooledSnapshots = 4;
+
+	TSharedPtr<FAudioAnalysisFrameSnapshot, ESPMode::ThreadSafe> Snapshot;
+	for (const TSharedRef<FAudioAnalysisFrameSnapshot, ESPMode::ThreadSafe>& PooledSnapshot : FrameSnapshotPool)
+	{
+		if (PooledSnapshot.IsUnique())
+		{
+			Snapshot = PooledSnapshot;
+			break;
+		}
+	}
+
+	if (!Snapshot.IsValid())
+	{
+		Snapshot = MakeShared<FAudioAnalysisFrameSnapshot, ESPMode::ThreadSafe>();
+		if (FrameSnapshotPool.Num() < MaxPooledSnapshots)
+		{
+			FrameSnapshotPool.Add(Snapshot.ToSharedRef());
+		}
+	}
+
+	Snapshot->Outputs = Outputs;
+	Snapshot->Timestamp = CurrentTimestamp;
+	Snapshot->SampleRate = SampleRate;
+	Snapshot->FrameStats = CurrentFrameStats;
+
+	// Assigning keeps the allocations of a reused snapshot when the frame size has not changed
+	auto CopyOutput = [Outputs](EFFTOutputs Output, const TArray64<float>& Source, TArray64<float>& Destination)
+	{
+		if (EnumHasAnyFlags(Outputs, Output))
+		{
+			Destination = Source;
+		}
+		else
+		{
+			Destination.Reset();
+		}
+	};
+
+	CopyOutput(EFFTOutputs::Complex, FFTReal, Snapshot->FFTReal);
+	CopyOutput(EFFTOutputs::Complex, FFTImaginary, Snapshot->FFTImaginary);
+	CopyOutput(EFFTOutputs::Magnitude, MagnitudeSpectrum, Snapshot->MagnitudeSpectrum);
+	CopyOutput(EFFTOutputs::Power, PowerSpectrum, Snapshot->PowerSpectrum);
+	CopyOutput(EFFTOutputs::Phase, PhaseSpectrum, Snapshot->PhaseSpectrum);
+	CopyOutput(EFFTOutputs::Decibels, DecibelSpectrum, Snapshot->DecibelSpectrum);
+
+	CurrentFrameSnapshot = Snapshot;
+	return Snapshot.ToSharedRef();
+}
+
 void UAudioAnalysisToolsLibrary::ProcessAudioFrames(TArray<float> AudioFrames, bool bProcessToBeatDetection)
+{
+	ProcessAudioFramesAtTime(MoveTemp(AudioFrames), -1., bProcessToBeatDetection);
+}
+
+void UAudioAnalysisToolsLibrary::ProcessAudioFramesAtTime(TArray<float> AudioFrames, float Timestamp, bool bProcessToBeatDetection)
+{
+	ProcessAudioFramesAtTime(MoveTemp(AudioFrames), static_cast<double>(Timestamp), bProcessToBeatDetection);
+}
+
+void UAudioAnalysisToolsLibrary::ProcessAudioFramesAtTime(TArray<float> AudioFrames, double Timestamp, bool bProcessToBeatDetection)
 {
 	if (IsInGameThread())
 	{
-		AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, [WeakThis = MakeWeakObjectPtr(this), AudioFrames = MoveTemp(AudioFrames), bProcessToBeatDetection]() mutable 
+		AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, [WeakThis = MakeWeakObjectPtr(this), AudioFrames = MoveTemp(AudioFrames), Timestamp, bProcessToBeatDetection]() mutable 
 		{
 			if (WeakThis.IsValid())
 			{
-				WeakThis->ProcessAudioFrames(MoveTemp(AudioFrames), bProcessToBeatDetection);
+				WeakThis->ProcessAudioFramesAtTime(MoveTemp(AudioFrames), Timestamp, bProcessToBeatDetection);
 			}
 			else
 			{
@@ -250,35 +507,408 @@ void UAudioAnalysisToolsLibrary::ProcessAudioFrames(TArray<float> AudioFrames, b
 
 	FScopeLock Lock(&DataGuard);
 
-	if (AudioFrames.Num() != CurrentAudioFrames.Num())
+	if (AudioFrames.Num() % NumChannels != 0)
 	{
-		UpdateFrameSize(AudioFrames.Num());
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to process audio frames: the number of samples '%d' is not a multiple of the number of channels '%d'"), AudioFrames.Num(), NumChannels);
+		return;
+	}
+
+	// The frame size is counted per channel, since the FFT works on the mono mix
+	const int64 FrameSize = AudioFrames.Num() / NumChannels;
+
+	if (AudioFrames.Num() != CurrentAudioFrames.Num() || !WindowFunction.IsValid() || WindowFunction->Values.Num() != FrameSize || CalculateFFTSize(FrameSize) != FFTSize)
+	{
+		UpdateFrameSize(FrameSize);
 	}
 	CurrentAudioFrames = MoveTemp(AudioFrames);
+	MixCurrentAudioFramesToMono();
+	CurrentFrameStats = UCoreTimeDomainFeatures::GetFrameStats(GetMonoAudioFrames());
+
+	if (bProcessToEnvelopeAnalysis)
+	{
+		EnvelopeAnalysis->ProcessAudioFrames(CurrentAudioFrames, NumChannels, SampleRate);
+	}
+
+	if (bProcessToLoudnessAnalysis)
+	{
+		LoudnessAnalysis->ProcessAudioFrames(CurrentAudioFrames, NumChannels, SampleRate);
+	}
+
+	const double FrameDuration = static_cast<double>(FrameSize) / SampleRate;
+	const double PreviousTimestamp = CurrentTimestamp;
+
+	CurrentTimestamp = Timestamp >= 0 ? Timestamp : NextTimestamp;
+	NextTimestamp = CurrentTimestamp + FrameDuration;
+
+	// Fall back to the frame duration if the timestamps do not advance (e.g. the first frame or a seek)
+	FrameDeltaTime = static_cast<float>(CurrentTimestamp > PreviousTimestamp ? CurrentTimestamp - PreviousTimestamp : FrameDuration);
 
 	PerformFFT();
 
-	if (bProcessToBeatDetection)
+	const bool bDecimatedBeatDetection = bProcessToBeatDetection && BeatDetectionDecimation != EAudioDecimationFactor::None;
+
+	if ((bProcessToBeatDetection && !bDecimatedBeatDetection) || bProcessToBandAnalysis)
+	{
+		MaterializeFFTOutputs(EFFTOutputs::Magnitude);
+	}
+
+	if (bDecimatedBeatDetection)
+	{
+		ProcessDecimatedBeatDetection();
+	}
+	else if (bProcessToBeatDetection)
+	{
+		BeatDetection->ProcessMagnitude(MagnitudeSpectrum, SampleRate, CurrentTimestamp);
+	}
+
+	if (bProcessToBandAnalysis)
+	{
+		BandAnalysis->ProcessMagnitude(MagnitudeSpectrum, SampleRate, FrameDeltaTime);
+	}
+
+	if (bProcessToPitchDetection)
+	{
+		// The pitch detection works on the raw (not windowed) mono frames
+		PitchDetection->ProcessAudioFrames(GetMonoAudioFrames(), SampleRate);
+	}
+
+	if (bProcessToOnsetDetection || bProcessToTempoEstimation || bProcessToBeatTracker || bProcessToOnsetPeakPicker)
+	{
+		// One pass for all onset detection functions, cached in the onset detection until the next frame
+		MaterializeFFTOutputs(EFFTOutputs::Complex | EFFTOutputs::Magnitude);
+		CurrentOnsetValue = OnsetDetection->ProcessFrame(CurrentFrameStats, FFTReal, FFTImaginary, MagnitudeSpectrum, true, CurrentTimestamp).SpectralDifferenceHWR;
+	}
+
+	if (bProcessToTempoEstimation)
+	{
+		TempoEstimation->ProcessOnsetValue(CurrentOnsetValue, FrameDeltaTime);
+	}
+
+	if (bProcessToBeatTracker)
+	{
+		BeatTracker->ProcessOnsetValue(CurrentOnsetValue, CurrentTimestamp, FrameDeltaTime, bProcessToTempoEstimation ? TempoEstimation->GetBeatPeriod() : 0.f);
+	}
+
+	if (bProcessToOnsetPeakPicker)
+	{
+		OnsetPeakPicker->ProcessOnsetValue(CurrentOnsetValue, CurrentTimestamp);
+	}
+
+	if (bBroadcastEvents)
+	{
+		BroadcastFrameEvents(bProcessToBeatDetection);
+	}
+
+	if (SpectrogramHistory.IsEnabled())
+	{
+		const bool bBandLevels = SpectrogramHistory.GetScale() == ESpectrogramHistoryScale::BandLevels;
+
+		if (!bBandLevels || bProcessToBandAnalysis)
+		{
+			if (!bBandLevels)
+			{
+				MaterializeFFTOutputs(EFFTOutputs::Magnitude);
+			}
+
+			const TArray64<float>& Row = bBandLevels ? BandAnalysis->GetBandLevels() : MagnitudeSpectrum;
+
+			if (SpectrogramHistory.GetRowSize() != Row.Num())
+			{
+				SpectrogramHistory.Reset(SpectrogramHistory.GetCapacity(), Row.Num(), SpectrogramHistory.GetScale());
+			}
+			SpectrogramHistory.AddRow(Row.GetData(), CurrentTimestamp);
+		}
+	}
+}
+
+void UAudioAnalysisToolsLibrary::ProcessDecimatedBeatDetection()
+{
+	const TArray64<float>& MonoFrames = GetMonoAudioFrames();
+	const int32 Factor = FPolyphaseDecimator::GetFactorValue(BeatDetectionDecimation);
+	const int64 DecimatedFrameSize = MonoFrames.Num() / Factor;
+
+	if (DecimatedFrameSize < 2)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to process decimated beat detection: the frame size '%lld' is too small for the decimation factor '%d'"), MonoFrames.Num(), Factor);
+		return;
+	}
+
+	// Reconfigure when the decimation factor or the frame size change
+	if (BeatDecimator.GetFactor() != BeatDetectionDecimation || DecimatedAudioFrames.Num() != DecimatedFrameSize)
 	{
-		BeatDetection->ProcessMagnitude(MagnitudeSpectrum);
+		FreeDecimatedFFT();
+
+		BeatDecimator.Reset(BeatDetectionDecimation);
+		DecimatedAudioFrames.SetNumZeroed(DecimatedFrameSize);
+		DecimatedWindowFunction = UWindowsLibrary::GetCachedWindow(DecimatedFrameSize, WindowType);
+		DecimatedFFT_InSamples.SetNumZeroed(DecimatedFrameSize);
+		DecimatedFFT_OutSamples.SetNumZeroed(DecimatedFrameSize);
+		// Spans the full rate Nyquist frequency at the decimated bin width, so the beat detection maps bins to the same frequencies as without decimation. The bins above the reduced Nyquist frequency stay zero
+		DecimatedMagnitudeSpectrum.SetNumZeroed(DecimatedFrameSize * Factor / 2);
+		DecimatedFFT_Configuration = UFFTAudioAnalyzer::PerformFFTAlloc(DecimatedFrameSize, 0, nullptr, nullptr);
 	}
+
+	BeatDecimator.Process(MonoFrames, NewDecimatedAudioFrames);
+
+	// Shift in the new decimated frames, so the buffer always spans the latest frame duration even if the frame size is not a multiple of the factor
+	const int64 NumNewFrames = FMath::Min(NewDecimatedAudioFrames.Num(), DecimatedFrameSize);
+	const int64 NumKeptFrames = DecimatedFrameSize - NumNewFrames;
+
+	FMemory::Memmove(DecimatedAudioFrames.GetData(), DecimatedAudioFrames.GetData() + NumNewFrames, NumKeptFrames * sizeof(float));
+	FMemory::Memcpy(DecimatedAudioFrames.GetData() + NumKeptFrames, NewDecimatedAudioFrames.GetData() + NewDecimatedAudioFrames.Num() - NumNewFrames, NumNewFrames * sizeof(float));
+
+	UFFTAudioAnalyzer::WindowAndPack(DecimatedAudioFrames.GetData(), DecimatedWindowFunction->Values.GetData(), DecimatedFrameSize, DecimatedFFT_InSamples.GetData());
+	UFFTAudioAnalyzer::PerformFFT(DecimatedFFT_Configuration, DecimatedFFT_InSamples.GetData(), DecimatedFFT_OutSamples.GetData());
+	UFFTAudioAnalyzer::UnpackSpectrum(DecimatedFFT_OutSamples.GetData(), DecimatedFrameSize, nullptr, nullptr, DecimatedFrameSize / 2, DecimatedMagnitudeSpectrum.GetData(), nullptr, nullptr);
+
+	BeatDetection->ProcessMagnitude(DecimatedMagnitudeSpectrum, SampleRate, CurrentTimestamp);
 }
 
-void UAudioAnalysisToolsLibrary::UpdateFrameSize(int64 FrameSize)
+void UAudioAnalysisToolsLibrary::MixCurrentAudioFramesToMono()
+{
+	if (NumChannels <= 1)
+	{
+		return;
+	}
+
+	const int64 NumFrames = CurrentAudioFrames.Num() / NumChannels;
+	MonoAudioFrames.SetNumUninitialized(NumFrames);
+
+	for (int64 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		const float* Frame = CurrentAudioFrames.GetData() + FrameIndex * NumChannels;
+
+		float Sum = 0.f;
+		for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+		{
+			Sum += Frame[ChannelIndex];
+		}
+
+		MonoAudioFrames[FrameIndex] = Sum / NumChannels;
+	}
+}
+
+const TArray64<float>& UAudioAnalysisToolsLibrary::GetMonoAudioFrames() const
+{
+	return NumChannels > 1 ? MonoAudioFrames : CurrentAudioFrames;
+}
+
+void UAudioAnalysisToolsLibrary::FreeDecimatedFFT()
+{
+	FMemory::Free(DecimatedFFT_Configuration);
+	DecimatedFFT_Configuration = nullptr;
+}
+
+void UAudioAnalysisToolsLibrary::BroadcastFrameEvents(bool bProcessedBeatDetection)
+{
+	bool bKick = false;
+	bool bSnare = false;
+	bool bHiHat = false;
+	TArray<int64> BeatSubbands;
+	TArray<FOnsetEvent> OnsetEvents;
+
+	if (bProcessedBeatDetection)
+	{
+		bKick = BeatDetection->IsKick();
+		bSnare = BeatDetection->IsSnare();
+		bHiHat = BeatDetection->IsHiHat();
+
+		// Visit the set bits of the beat mask only
+		const TArray64<uint64>& BeatMask = BeatDetection->GetBeatMask();
+		for (int64 WordIndex = 0; WordIndex < BeatMask.Num(); ++WordIndex)
+		{
+			for (uint64 Word = BeatMask[WordIndex]; Word != 0; Word &= Word - 1)
+			{
+				BeatSubbands.Add(WordIndex * 64 + FMath::CountTrailingZeros64(Word));
+			}
+		}
+	}
+
+	if (bProcessToOnsetPeakPicker)
+	{
+		OnsetPeakPicker->ConsumeOnsetEvents(OnsetEvents);
+	}
+
+	if (!bKick && !bSnare && !bHiHat && BeatSubbands.Num() <= 0 && OnsetEvents.Num() <= 0)
+	{
+		return;
+	}
+
+	// A single game thread task per audio frame, regardless of the number of events and listeners
+	AsyncTask(ENamedThreads::GameThread, [WeakThis = MakeWeakObjectPtr(this), Timestamp = static_cast<float>(CurrentTimestamp), bKick, bSnare, bHiHat, BeatSubbands = MoveTemp(BeatSubbands), OnsetEvents = MoveTemp(OnsetEvents)]()
+	{
+		if (!WeakThis.IsValid())
+		{
+			return;
+		}
+
+		if (bKick)
+		{
+			WeakThis->OnKick.Broadcast(Timestamp);
+		}
+
+		if (bSnare)
+		{
+			WeakThis->OnSnare.Broadcast(Timestamp);
+		}
+
+		if (bHiHat)
+		{
+			WeakThis->OnHiHat.Broadcast(Timestamp);
+		}
+
+		for (const int64 Subband : BeatSubbands)
+		{
+			WeakThis->OnBandBeat.Broadcast(Subband, Timestamp);
+		}
+
+		for (const FOnsetEvent& OnsetEvent : OnsetEvents)
+		{
+			WeakThis->OnOnset.Broadcast(OnsetEvent.Timestamp, OnsetEvent.Strength);
+		}
+	});
+}
+
+float UAudioAnalysisToolsLibrary::GetCurrentTimestamp() const
+{
+	return static_cast<float>(CurrentTimestamp);
+}
+
+double UAudioAnalysisToolsLibrary::GetPreciseCurrentTimestamp() const
+{
+	return CurrentTimestamp;
+}
+
+void UAudioAnalysisToolsLibrary::EnableSpectrogramHistory(int64 Capacity, ESpectrogramHistoryScale Scale)
+{
+	if (Capacity <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to enable the spectrogram history: the capacity is '%lld', expected > '0'"), Capacity);
+		return;
+	}
+
+	FScopeLock Lock(&DataGuard);
+	SpectrogramHistory.Reset(Capacity, Scale == ESpectrogramHistoryScale::BandLevels ? BandAnalysis->GetNumBands() : FFTSize / 2, Scale);
+}
+
+void UAudioAnalysisToolsLibrary::DisableSpectrogramHistory()
+{
+	FScopeLock Lock(&DataGuard);
+	SpectrogramHistory.Reset(0, 0, SpectrogramHistory.GetScale());
+}
+
+bool UAudioAnalysisToolsLibrary::GetSpectrogramHistory(ESpectrogramHistoryLayout Layout, TArray<float>& Values, TArray<float>& Timestamps, int64& NumRows, int64& RowSize) const
 {
-	const int64 MagnitudeSpectrumSize = FrameSize / 2;
+	FScopeLock Lock(&DataGuard);
+
+	if (!SpectrogramHistory.IsEnabled())
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to get the spectrogram history: the history is not enabled"));
+		return false;
+	}
+
+	NumRows = SpectrogramHistory.Num();
+	RowSize = SpectrogramHistory.GetRowSize();
+
+	if (NumRows * RowSize > TNumericLimits<int32>::Max())
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to get the spectrogram history: array with int32 size (max length: %d) cannot fit int64 size data (retrieved length: %lld)"), TNumericLimits<int32>::Max(), NumRows * RowSize);
+		return false;
+	}
+
+	TArray64<float> Values64;
+	TArray64<double> Timestamps64;
+	SpectrogramHistory.Export(Layout, Values64, Timestamps64);
+
+	Values = TArray<float>(Values64);
 
-	CurrentAudioFrames.SetNum(FrameSize);
+	Timestamps.SetNumUninitialized(NumRows);
+	for (int64 RowIndex = 0; RowIndex < NumRows; ++RowIndex)
+	{
+		Timestamps[RowIndex] = static_cast<float>(Timestamps64[RowIndex]);
+	}
+
+	return true;
+}
 
-	WindowFunction = UWindowsLibrary::CreateWindowByType(FrameSize, WindowType);
+void UAudioAnalysisToolsLibrary::ReadSpectrogramHistory(TFunctionRef<void(const FSpectrogramHistory&)> Reader) const
+{
+	FScopeLock Lock(&DataGuard);
+	Reader(SpectrogramHistory);
+}
 
-	FFTReal.SetNum(FrameSize);
-	FFTImaginary.SetNum(FrameSize);
-	MagnitudeSpectrum.SetNum(MagnitudeSpectrumSize);
+void UAudioAnalysisToolsLibrary::UpdateFrameSize(int64 FrameSize)
+{
+	CurrentAudioFrames.SetNum(FrameSize * NumChannels);
+	MonoAudioFrames.Reset();
+	CurrentFrameStats = FTimeDomainFrameStats();
+	FFTSize = CalculateFFTSize(FrameSize);
+
+	WindowFunction = UWindowsLibrary::GetCachedWindow(FrameSize, WindowType);
+
+	// The FFT outputs are only allocated once they are first calculated
+	FFTReal.Empty();
+	FFTImaginary.Empty();
+	MagnitudeSpectrum.Empty();
+	PowerSpectrum.Empty();
+	PhaseSpectrum.Empty();
+	DecibelSpectrum.Empty();
+	MaterializedFFTOutputs = EFFTOutputs::None;
+	bConstantQProcessed = false;
+	CurrentFrameSnapshot.Reset();
 
 	ConfigureFFT();
 }
 
+void UAudioAnalysisToolsLibrary::UpdateSampleRate(int32 InSampleRate)
+{
+	if (InSampleRate <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update the sample rate: the specified sample rate is '%d', expected > '0'"), InSampleRate);
+		return;
+	}
+
+	FScopeLock Lock(&DataGuard);
+	SampleRate = InSampleRate;
+}
+
+int32 UAudioAnalysisToolsLibrary::GetSampleRate() const
+{
+	return SampleRate;
+}
+
+void UAudioAnalysisToolsLibrary::UpdateNumChannels(int32 InNumChannels)
+{
+	if (InNumChannels <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to update the number of channels: the specified number of channels is '%d', expected > '0'"), InNumChannels);
+		return;
+	}
+
+	FScopeLock Lock(&DataGuard);
+	NumChannels = InNumChannels;
+}
+
+int32 UAudioAnalysisToolsLibrary::GetNumChannels() const
+{
+	return NumChannels;
+}
+
+int64 UAudioAnalysisToolsLibrary::GetFFTSize() const
+{
+	return FFTSize;
+}
+
+float UAudioAnalysisToolsLibrary::GetBinFrequency(int64 Bin) const
+{
+	return UFFTAudioAnalyzer::GetBinFrequency(Bin, FFTSize, SampleRate);
+}
+
+int64 UAudioAnalysisToolsLibrary::CalculateFFTSize(int64 FrameSize) const
+{
+	return bZeroPadToFastFFTSize ? UFFTAudioAnalyzer::GetNextFastSize(FrameSize) : FrameSize;
+}
+
 bool UAudioAnalysisToolsLibrary::IsBeat(int64 Subband) const
 {
 	check(BeatDetection);
@@ -317,74 +947,152 @@ float UAudioAnalysisToolsLibrary::GetBand(int64 Subband) const
 
 float UAudioAnalysisToolsLibrary::GetRootMeanSquare()
 {
-	return UCoreTimeDomainFeatures::GetRootMeanSquare(CurrentAudioFrames);
+	FScopeLock Lock(&DataGuard);
+	return CurrentFrameStats.RootMeanSquare;
 }
 
 float UAudioAnalysisToolsLibrary::GetPeakEnergy()
 {
-	return UCoreTimeDomainFeatures::GetPeakEnergy(CurrentAudioFrames);
+	FScopeLock Lock(&DataGuard);
+	return CurrentFrameStats.PeakEnergy;
 }
 
 float UAudioAnalysisToolsLibrary::GetZeroCrossingRate()
 {
-	return UCoreTimeDomainFeatures::GetZeroCrossingRate(CurrentAudioFrames);
+	FScopeLock Lock(&DataGuard);
+	return CurrentFrameStats.ZeroCrossingRate;
+}
+
+FTimeDomainFrameStats UAudioAnalysisToolsLibrary::GetTimeDomainFrameStats() const
+{
+	FScopeLock Lock(&DataGuard);
+	return CurrentFrameStats;
 }
 
 float UAudioAnalysisToolsLibrary::GetSpectralCentroid()
 {
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Magnitude);
 	return UCoreFrequencyDomainFeatures::GetSpectralCentroid(MagnitudeSpectrum);
 }
 
 float UAudioAnalysisToolsLibrary::GetSpectralFlatness()
 {
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Magnitude);
 	return UCoreFrequencyDomainFeatures::GetSpectralFlatness(MagnitudeSpectrum);
 }
 
 float UAudioAnalysisToolsLibrary::GetSpectralCrest()
 {
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Magnitude);
 	return UCoreFrequencyDomainFeatures::GetSpectralCrest(MagnitudeSpectrum);
 }
 
 float UAudioAnalysisToolsLibrary::GetSpectralRolloff()
 {
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Magnitude);
 	return UCoreFrequencyDomainFeatures::GetSpectralRolloff(MagnitudeSpectrum);
 }
 
 float UAudioAnalysisToolsLibrary::GetSpectralKurtosis()
 {
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Magnitude);
 	return UCoreFrequencyDomainFeatures::GetSpectralKurtosis(MagnitudeSpectrum);
 }
 
 float UAudioAnalysisToolsLibrary::GetEnergyDifference()
 {
 	check(OnsetDetection);
-	return OnsetDetection->GetEnergyDifference(CurrentAudioFrames);
+	FScopeLock Lock(&DataGuard);
+	return OnsetDetection->GetEnergyDifference(CurrentFrameStats);
 }
 
 float UAudioAnalysisToolsLibrary::GetSpectralDifference()
 {
 	check(OnsetDetection);
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Magnitude);
 	return OnsetDetection->GetSpectralDifference(MagnitudeSpectrum);
 }
 
 float UAudioAnalysisToolsLibrary::GetSpectralDifferenceHWR()
 {
 	check(OnsetDetection);
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Magnitude);
 	return OnsetDetection->GetSpectralDifferenceHWR(MagnitudeSpectrum);
 }
 
 float UAudioAnalysisToolsLibrary::GetComplexSpectralDifference()
 {
 	check(OnsetDetection);
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Complex);
 	return OnsetDetection->GetComplexSpectralDifference(FFTReal, FFTImaginary);
 }
 
+float UAudioAnalysisToolsLibrary::GetComplexSpectralDifferenceFast()
+{
+	check(OnsetDetection);
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Complex | EFFTOutputs::Magnitude);
+	return OnsetDetection->GetComplexSpectralDifferenceFast(FFTReal, FFTImaginary, MagnitudeSpectrum);
+}
+
 float UAudioAnalysisToolsLibrary::GetHighFrequencyContent()
 {
 	check(OnsetDetection);
+	FScopeLock Lock(&DataGuard);
+	MaterializeFFTOutputs(EFFTOutputs::Magnitude);
 	return OnsetDetection->GetHighFrequencyContent(MagnitudeSpectrum);
 }
 
+FOnsetDetectionValues UAudioAnalysisToolsLibrary::GetOnsetDetectionValues() const
+{
+	FScopeLock Lock(&DataGuard);
+	check(OnsetDetection);
+	return OnsetDetection->GetFrameValues();
+}
+
+bool UAudioAnalysisToolsLibrary::ProcessConstantQ()
+{
+	check(ConstantQAnalysis);
+
+	// Updating the parameters resets the spectrum, so the transform is recalculated for the current frame
+	if (!bConstantQProcessed || ConstantQParametersRevision != ConstantQAnalysis->GetParametersRevision())
+	{
+		MaterializeFFTOutputs(EFFTOutputs::Complex);
+		bConstantQProcessed = ConstantQAnalysis->ProcessFFT(FFTReal, FFTImaginary, SampleRate);
+		ConstantQParametersRevision = ConstantQAnalysis->GetParametersRevision();
+	}
+
+	return bConstantQProcessed;
+}
+
+TArray<float> UAudioAnalysisToolsLibrary::GetConstantQSpectrum()
+{
+	FScopeLock Lock(&DataGuard);
+	if (!ProcessConstantQ())
+	{
+		return TArray<float>();
+	}
+	return ConstantQAnalysis->GetConstantQSpectrum_BP();
+}
+
+TArray<float> UAudioAnalysisToolsLibrary::GetChroma()
+{
+	FScopeLock Lock(&DataGuard);
+	if (!ProcessConstantQ())
+	{
+		return TArray<float>();
+	}
+	return ConstantQAnalysis->GetChroma_BP();
+}
+
 void UAudioAnalysisToolsLibrary::ConfigureFFT()
 {
 	if (FFTConfigured)
@@ -392,11 +1100,13 @@ void UAudioAnalysisToolsLibrary::ConfigureFFT()
 		FreeFFT();
 	}
 
-	const int64 FrameSize = CurrentAudioFrames.Num();
+	FFT_InSamples = new FFTComplexSamples[FFTSize];
+	FFT_OutSamples = new FFTComplexSamples[FFTSize];
 
-	FFT_InSamples = new FFTComplexSamples[FrameSize];
-	FFT_OutSamples = new FFTComplexSamples[FrameSize];
-	FFT_Configuration = UFFTAudioAnalyzer::PerformFFTAlloc(FrameSize, 0, nullptr, nullptr);
+	// The zero-padding of the input is never overwritten, and the outputs may be calculated before the first audio frame is processed
+	FMemory::Memzero(FFT_InSamples, FFTSize * sizeof(FFTComplexSamples));
+	FMemory::Memzero(FFT_OutSamples, FFTSize * sizeof(FFTComplexSamples));
+	FFT_Configuration = UFFTAudioAnalyzer::PerformFFTAlloc(FFTSize, 0, nullptr, nullptr);
 
 	FFTConfigured = true;
 }
@@ -422,27 +1132,59 @@ void UAudioAnalysisToolsLibrary::PerformFFT()
 		return;
 	}
 
-	const int64 FrameSize = CurrentAudioFrames.Num();
+	const TArray64<float>& MonoFrames = GetMonoAudioFrames();
 
-	for (int64 Index = 0; Index < FrameSize; ++Index)
-	{
-		FFT_InSamples[Index].Real = CurrentAudioFrames[Index] * WindowFunction[Index];
-		FFT_InSamples[Index].Imaginary = 0.0;
-	}
+	UFFTAudioAnalyzer::WindowAndPack(MonoFrames.GetData(), WindowFunction->Values.GetData(), MonoFrames.Num(), FFT_InSamples);
 
 	// Execute kiss fft
 	UFFTAudioAnalyzer::PerformFFT(FFT_Configuration, FFT_InSamples, FFT_OutSamples);
 
-	// Store real and imaginary parts of FFT
-	for (int64 Index = 0; Index < FrameSize; ++Index)
+	MaterializedFFTOutputs = EFFTOutputs::None;
+	bConstantQProcessed = false;
+	CurrentFrameSnapshot.Reset();
+	MaterializeFFTOutputs(static_cast<EFFTOutputs>(EagerFFTOutputs));
+}
+
+void UAudioAnalysisToolsLibrary::MaterializeFFTOutputs(EFFTOutputs Outputs) const
+{
+	const EFFTOutputs MissingOutputs = Outputs & ~MaterializedFFTOutputs;
+
+	if (MissingOutputs == EFFTOutputs::None || !FFT_OutSamples)
+	{
+		return;
+	}
+
+	const int64 NumBins = FFTSize / 2;
+
+	auto PrepareOutput = [MissingOutputs](EFFTOutputs Output, TArray64<float>& Array, int64 Size) -> float*
+	{
+		if (!EnumHasAnyFlags(MissingOutputs, Output))
+		{
+			return nullptr;
+		}
+		Array.SetNumUninitialized(Size);
+		return Array.GetData();
+	};
+
+	float* Real = PrepareOutput(EFFTOutputs::Complex, FFTReal, FFTSize);
+	float* Imaginary = PrepareOutput(EFFTOutputs::Complex, FFTImaginary, FFTSize);
+	float* Magnitude = PrepareOutput(EFFTOutputs::Magnitude, MagnitudeSpectrum, NumBins);
+	float* Power = PrepareOutput(EFFTOutputs::Power, PowerSpectrum, NumBins);
+	float* Decibels = PrepareOutput(EFFTOutputs::Decibels, DecibelSpectrum, NumBins);
+
+	if (Real || Magnitude || Power || Decibels)
 	{
-		FFTReal[Index] = FFT_OutSamples[Index].Real;
-		FFTImaginary[Index] = FFT_OutSamples[Index].Imaginary;
+		// Unpack all requested outputs of the stored FFT output in a single pass
+		UFFTAudioAnalyzer::UnpackSpectrum(FFT_OutSamples, FFTSize, Real, Imaginary, NumBins, Magnitude, Power, Decibels);
 	}
 
-	// Calculate the magnitude spectrum
-	for (int64 Index = 0; Index < FrameSize / 2; ++Index)
+	if (float* Phase = PrepareOutput(EFFTOutputs::Phase, PhaseSpectrum, NumBins))
 	{
-		MagnitudeSpectrum[Index] = FMath::Sqrt(FMath::Pow(FFTReal[Index], 2) + FMath::Pow(FFTImaginary[Index], 2));
+		for (int64 Index = 0; Index < NumBins; ++Index)
+		{
+			Phase[Index] = FMath::Atan2(FFT_OutSamples[Index].Imaginary, FFT_OutSamples[Index].Real);
+		}
 	}
+
+	MaterializedFFTOutputs |= MissingOutputs;
 }
@@ -0,0 +1,165 @@
+// Georgy Treshchev 2024.
+
+#include "ImportedSoundWaveAnalysisHook.h"
+#include "AudioAnalysisToolsDefines.h"
+#include "Analyzers/EnvelopeAnalysis.h"
+#include "Analyzers/LoudnessAnalysis.h"
+#include "Analyzers/MultiResolutionAnalysis.h"
+#include "Sound/ImportedSoundWave.h"
+#include "Misc/ScopeLock.h"
+
+UImportedSoundWaveAnalysisHook::UImportedSoundWaveAnalysisHook()
+	: LoudnessAnalysis(nullptr),
+	  EnvelopeAnalysis(nullptr),
+	  MultiResolutionAnalysis(nullptr),
+	  NumProcessedFrames(0),
+	  SampleRate(0)
+{
+}
+
+void UImportedSoundWaveAnalysisHook::BeginDestroy()
+{
+	Unbind();
+
+	Super::BeginDestroy();
+}
+
+UImportedSoundWaveAnalysisHook* UImportedSoundWaveAnalysisHook::CreateImportedSoundWaveAnalysisHook(UImportedSoundWave* ImportedSoundWave)
+{
+	if (!ImportedSoundWave)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to create the imported sound wave analysis hook: the sound wave is invalid"));
+		return nullptr;
+	}
+
+	UImportedSoundWaveAnalysisHook* AnalysisHook = NewObject<UImportedSoundWaveAnalysisHook>();
+	AnalysisHook->ImportedSoundWave = ImportedSoundWave;
+	AnalysisHook->PopulateAudioDataHandle = ImportedSoundWave->OnPopulateAudioDataNative.AddUObject(AnalysisHook, &UImportedSoundWaveAnalysisHook::HandlePopulatedAudioData);
+	return AnalysisHook;
+}
+
+void UImportedSoundWaveAnalysisHook::Unbind()
+{
+	if (ImportedSoundWave.IsValid() && PopulateAudioDataHandle.IsValid())
+	{
+		ImportedSoundWave->OnPopulateAudioDataNative.Remove(PopulateAudioDataHandle);
+	}
+
+	PopulateAudioDataHandle.Reset();
+	ImportedSoundWave.Reset();
+}
+
+void UImportedSoundWaveAnalysisHook::SetLoudnessAnalysis(ULoudnessAnalysis* InLoudnessAnalysis)
+{
+	FScopeLock Lock(&DataGuard);
+	LoudnessAnalysis = InLoudnessAnalysis;
+}
+
+void UImportedSoundWaveAnalysisHook::SetEnvelopeAnalysis(UEnvelopeAnalysis* InEnvelopeAnalysis)
+{
+	FScopeLock Lock(&DataGuard);
+	EnvelopeAnalysis = InEnvelopeAnalysis;
+}
+
+void UImportedSoundWaveAnalysisHook::SetMultiResolutionAnalysis(UMultiResolutionAnalysis* InMultiResolutionAnalysis)
+{
+	FScopeLock Lock(&DataGuard);
+	MultiResolutionAnalysis = InMultiResolutionAnalysis;
+}
+
+float UImportedSoundWaveAnalysisHook::GetProcessedDuration() const
+{
+	FScopeLock Lock(&DataGuard);
+	return SampleRate > 0 ? static_cast<float>(static_cast<double>(NumProcessedFrames) / SampleRate) : 0.f;
+}
+
+void UImportedSoundWaveAnalysisHook::HandlePopulatedAudioData(const TArray<float>& PopulatedAudioData)
+{
+	if (!ImportedSoundWave.IsValid())
+	{
+		return;
+	}
+
+	const int32 NumChannels = ImportedSoundWave->NumChannels;
+	const int32 InSampleRate = ImportedSoundWave->GetSampleRate();
+
+	if (NumChannels <= 0 || InSampleRate <= 0)
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to analyze the populated audio data: the number of channels is '%d' and the sample rate is '%d', expected > '0'"), NumChannels, InSampleRate);
+		return;
+	}
+
+	const TArrayView64<const float> AudioFrames(PopulatedAudioData.GetData(), PopulatedAudioData.Num());
+	const int64 NumFrames = AudioFrames.Num() / NumChannels;
+
+	{
+		FScopeLock Lock(&DataGuard);
+
+		if (InSampleRate != SampleRate)
+		{
+			// The measurements so far belong to the previous sample rate
+			if (SampleRate > 0)
+			{
+				if (LoudnessAnalysis)
+				{
+					LoudnessAnalysis->Reset();
+				}
+
+				if (EnvelopeAnalysis)
+				{
+					EnvelopeAnalysis->Reset();
+				}
+
+				if (MultiResolutionAnalysis)
+				{
+					MultiResolutionAnalysis->Reset();
+				}
+			}
+
+			SampleRate = InSampleRate;
+			NumProcessedFrames = 0;
+		}
+
+		if (LoudnessAnalysis)
+		{
+			LoudnessAnalysis->ProcessAudioFrames(AudioFrames, NumChannels, SampleRate);
+		}
+
+		if (EnvelopeAnalysis)
+		{
+			EnvelopeAnalysis->ProcessAudioFrames(AudioFrames, NumChannels, SampleRate);
+		}
+
+		if (MultiResolutionAnalysis)
+		{
+			if (NumChannels == 1)
+			{
+				MultiResolutionAnalysis->ProcessAudioFrames(AudioFrames, SampleRate);
+			}
+			else
+			{
+				MonoAudioFrames.SetNumUninitialized(NumFrames);
+
+				for (int64 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+				{
+					const float* Frame = AudioFrames.GetData() + FrameIndex * NumChannels;
+
+					float Sum = 0.f;
+					for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+					{
+						Sum += Frame[ChannelIndex];
+					}
+
+					MonoAudioFrames[FrameIndex] = Sum / NumChannels;
+				}
+
+				MultiResolutionAnalysis->ProcessAudioFrames(MonoAudioFrames, SampleRate);
+			}
+		}
+
+		NumProcessedFrames += NumFrames;
+	}
+
+	// Listeners may query the hook or take their own locks, so they are not called with the hook locked
+	OnImportedAudioChunkNative.Broadcast(AudioFrames, NumChannels, InSampleRate);
+}
@@ -0,0 +1,121 @@
+// Georgy Treshchev 2024.
+
+#include "SpectrogramHistory.h"
+#include "AudioAnalysisToolsDefines.h"
+#include "Math/UnrealMathUtility.h"
+
+FSpectrogramHistory::FSpectrogramHistory()
+	: Capacity(0),
+	  RowSize(0),
+	  WritePosition(0),
+	  NumRows(0),
+	  Scale(ESpectrogramHistoryScale::Magnitude)
+{
+}
+
+void FSpectrogramHistory::Reset(int64 InCapacity, int64 InRowSize, ESpectrogramHistoryScale InScale)
+{
+	Capacity = FMath::Max<int64>(InCapacity, 0);
+	RowSize = FMath::Max<int64>(InRowSize, 0);
+	Scale = InScale;
+
+	Rows.SetNumZeroed(Capacity * RowSize);
+	Timestamps.SetNumZeroed(Capacity);
+
+	Clear();
+}
+
+void FSpectrogramHistory::Clear()
+{
+	WritePosition = 0;
+	NumRows = 0;
+}
+
+void FSpectrogramHistory::AddRow(const float* Values, double Timestamp)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	float* Row = Rows.GetData() + WritePosition * RowSize;
+
+	switch (Scale)
+	{
+	case ESpectrogramHistoryScale::Decibels:
+		{
+			// 20 / ln(10), so that the conversion is a single natural logarithm
+			constexpr float DecibelsPerNeper = 8.6858896f;
+			constexpr float MinMagnitude = 1e-10f;
+
+			for (int64 Index = 0; Index < RowSize; ++Index)
+			{
+				Row[Index] = DecibelsPerNeper * FMath::Loge(FMath::Max(Values[Index], MinMagnitude));
+			}
+			break;
+		}
+	case ESpectrogramHistoryScale::Magnitude:
+	case ESpectrogramHistoryScale::BandLevels:
+	default:
+		FMemory::Memcpy(Row, Values, sizeof(float) * RowSize);
+		break;
+	}
+
+	Timestamps[WritePosition] = Timestamp;
+
+	WritePosition = (WritePosition + 1) % Capacity;
+	NumRows = FMath::Min(NumRows + 1, Capacity);
+}
+
+int64 FSpectrogramHistory::GetSlotIndex(int64 Index) const
+{
+	// The oldest row is at the write position once the ring has wrapped around
+	const int64 OldestSlot = NumRows < Capacity ? 0 : WritePosition;
+	return (OldestSlot + Index) % Capacity;
+}
+
+TArrayView64<const float> FSpectrogramHistory::GetRow(int64 Index) const
+{
+	if (!(Index >= 0 && Index < NumRows))
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot obtain spectrogram history row: the specified row is '%lld', but it is expected to be >= '0' and < '%lld'"), Index, NumRows);
+		return TArrayView64<const float>();
+	}
+	return TArrayView64<const float>(Rows.GetData() + GetSlotIndex(Index) * RowSize, RowSize);
+}
+
+double FSpectrogramHistory::GetRowTimestamp(int64 Index) const
+{
+	if (!(Index >= 0 && Index < NumRows))
+	{
+		UE_LOG(LogAudioAnalysis, Error, TEXT("Cannot obtain spectrogram history timestamp: the specified row is '%lld', but it is expected to be >= '0' and < '%lld'"), Index, NumRows);
+		return -1;
+	}
+	return Timestamps[GetSlotIndex(Index)];
+}
+
+void FSpectrogramHistory::Export(ESpectrogramHistoryLayout Layout, TArray64<float>& OutValues, TArray64<double>& OutTimestamps) const
+{
+	OutValues.SetNumUninitialized(NumRows * RowSize);
+	OutTimestamps.SetNumUninitialized(NumRows);
+
+	for (int64 RowIndex = 0; RowIndex < NumRows; ++RowIndex)
+	{
+		const int64 Slot = GetSlotIndex(RowIndex);
+		const float* Row = Rows.GetData() + Slot * RowSize;
+
+		OutTimestamps[RowIndex] = Timestamps[Slot];
+
+		if (Layout == ESpectrogramHistoryLayout::TimeMajor)
+		{
+			FMemory::Memcpy(OutValues.GetData() + RowIndex * RowSize, Row, sizeof(float) * RowSize);
+		}
+		else
+		{
+			for (int64 BinIndex = 0; BinIndex < RowSize; ++BinIndex)
+			{
+				OutValues[BinIndex * NumRows + RowIndex] = Row[BinIndex];
+			}
+		}
+	}
+}
@@ -1,43 +1,184 @@
 // Georgy Treshchev 2024.
 
 #include "WindowsLibrary.h"
+#include "Containers/Map.h"
+#include "Misc/ScopeLock.h"
 
-TArray<float> UWindowsLibrary::CreateWindowByType(int32 FrameSize, EAnalysisWindowType WindowType)
+namespace
 {
-	return TArray<float>(CreateWindowByType(static_cast<int64>(FrameSize), WindowType));
-}
+	/** The maximum number of cached windows. Beyond it, windows no longer in use are evicted */
+	constexpr int32 MaxCachedWindows = 64;
 
-TArray64<float> UWindowsLibrary::CreateWindowByType(int64 FrameSize, EAnalysisWindowType WindowType)
-{
-	switch (WindowType)
+	/** Key of a cached window */
+	struct FWindowCacheKey
+	{
+		int64 FrameSize;
+		EAnalysisWindowType WindowType;
+		float Parameter;
+
+		bool operator==(const FWindowCacheKey& Other) const
+		{
+			return FrameSize == Other.FrameSize && WindowType == Other.WindowType && Parameter == Other.Parameter;
+		}
+
+		friend uint32 GetTypeHash(const FWindowCacheKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.FrameSize), GetTypeHash(static_cast<uint8>(Key.WindowType))), GetTypeHash(Key.Parameter));
+		}
+	};
+
+	/** Resolve the parameter of the window type, so equal windows share the cache key */
+	float ResolveWindowParameter(EAnalysisWindowType WindowType, float Parameter)
+	{
+		switch (WindowType)
+		{
+		case EAnalysisWindowType::TukeyWindow: return Parameter >= 0 ? Parameter : 0.5f;
+		case EAnalysisWindowType::KaiserWindow: return Parameter >= 0 ? Parameter : 8.6f;
+		default: return 0;
+		}
+	}
+
+	/**
+	 * Create a symmetric generalized cosine window, w(n) = a0 - a1 * cos(2 pi n / (N - 1)) + a2 * cos(4 pi n / (N - 1)) - ...
+	 * Only the first half is evaluated and mirrored into the second one
+	 */
+	TArray64<float> CreateCosineSumWindow(int64 FrameSize, std::initializer_list<double> Coefficients)
 	{
-	case EAnalysisWindowType::RectangularWindow: return CreateRectangularWindow(FrameSize);
-	case EAnalysisWindowType::HanningWindow: return CreateHanningWindow(FrameSize);
-	case EAnalysisWindowType::HammingWindow: return CreateHammingWindow(FrameSize);
-	case EAnalysisWindowType::BlackmanWindow: return CreateBlackmanWindow(FrameSize);
-	case EAnalysisWindowType::TukeyWindow: return CreateTukeyWindow(FrameSize);
-	default: return CreateRectangularWindow(FrameSize);
+		TArray64<float> Window;
+		Window.SetNumUninitialized(FMath::Max<int64>(FrameSize, 0));
+
+		if (FrameSize == 1)
+		{
+			Window[0] = 1.f;
+			return Window;
+		}
+
+		const double Step = 2. * PI / static_cast<double>(FrameSize - 1);
+
+		for (int64 Index = 0; Index < (FrameSize + 1) / 2; ++Index)
+		{
+			double Value = 0;
+			double Sign = 1;
+			int32 Harmonic = 0;
+
+			for (const double Coefficient : Coefficients)
+			{
+				Value += Sign * Coefficient * FMath::Cos(Harmonic * Step * Index);
+				Sign = -Sign;
+				++Harmonic;
+			}
+
+			Window[Index] = static_cast<float>(Value);
+			Window[FrameSize - 1 - Index] = static_cast<float>(Value);
+		}
+
+		return Window;
+	}
+
+	/** Zeroth-order modified Bessel function of the first kind, from its power series */
+	double BesselI0(double Value)
+	{
+		const double HalfValueSquared = Value * Value / 4.;
+
+		double Sum = 1;
+		double Term = 1;
+
+		for (int32 Order = 1; Order < 64 && Term > Sum * 1e-12; ++Order)
+		{
+			Term *= HalfValueSquared / (Order * Order);
+			Sum += Term;
+		}
+
+		return Sum;
 	}
 }
 
-TArray<float> UWindowsLibrary::CreateHanningWindow(int32 FrameSize)
+TArray<float> UWindowsLibrary::CreateWindowByType(int32 FrameSize, EAnalysisWindowType WindowType, float Parameter)
 {
-	return TArray<float>(CreateHanningWindow(static_cast<int64>(FrameSize)));
+	return TArray<float>(GetCachedWindow(FrameSize, WindowType, Parameter)->Values);
 }
 
-TArray64<float> UWindowsLibrary::CreateHanningWindow(int64 FrameSize)
+TArray64<float> UWindowsLibrary::CreateWindowByType(int64 FrameSize, EAnalysisWindowType WindowType, float Parameter)
 {
-	TArray64<float> Window;
-	Window.Init(0, FrameSize);
+	return GetCachedWindow(FrameSize, WindowType, Parameter)->Values;
+}
 
-	for (TArray64<float>::SizeType Index = 0; Index < Window.Num(); ++Index)
+FAnalysisWindowRef UWindowsLibrary::GetCachedWindow(int64 FrameSize, EAnalysisWindowType WindowType, float Parameter)
+{
+	static FCriticalSection CacheGuard;
+	static TMap<FWindowCacheKey, FAnalysisWindowRef> Cache;
+
+	const FWindowCacheKey Key{FMath::Max<int64>(FrameSize, 0), WindowType, ResolveWindowParameter(WindowType, Parameter)};
+
+	FScopeLock Lock(&CacheGuard);
+
+	if (const FAnalysisWindowRef* CachedWindow = Cache.Find(Key))
 	{
-		Window[Index] = 0.5 * (1 - FMath::Cos(2. * PI * (Index / static_cast<float>(FrameSize - 1))));
+		return *CachedWindow;
 	}
 
+	TSharedRef<FAnalysisWindow, ESPMode::ThreadSafe> Window = MakeShared<FAnalysisWindow, ESPMode::ThreadSafe>();
+
+	switch (Key.WindowType)
+	{
+	case EAnalysisWindowType::RectangularWindow: Window->Values = CreateRectangularWindow(Key.FrameSize); break;
+	case EAnalysisWindowType::HanningWindow: Window->Values = CreateHanningWindow(Key.FrameSize); break;
+	case EAnalysisWindowType::HammingWindow: Window->Values = CreateHammingWindow(Key.FrameSize); break;
+	case EAnalysisWindowType::BlackmanWindow: Window->Values = CreateBlackmanWindow(Key.FrameSize); break;
+	case EAnalysisWindowType::TukeyWindow: Window->Values = CreateTukeyWindow(Key.FrameSize, Key.Parameter); break;
+	case EAnalysisWindowType::KaiserWindow: Window->Values = CreateKaiserWindow(Key.FrameSize, Key.Parameter); break;
+	case EAnalysisWindowType::BlackmanHarrisWindow: Window->Values = CreateBlackmanHarrisWindow(Key.FrameSize); break;
+	case EAnalysisWindowType::FlatTopWindow: Window->Values = CreateFlatTopWindow(Key.FrameSize); break;
+	default: Window->Values = CreateRectangularWindow(Key.FrameSize); break;
+	}
+
+	double Sum = 0;
+	double SumOfSquares = 0;
+	for (const float Value : Window->Values)
+	{
+		Sum += Value;
+		SumOfSquares += static_cast<double>(Value) * Value;
+	}
+
+	Window->CoherentGain = Window->Values.Num() > 0 ? static_cast<float>(Sum / Window->Values.Num()) : 0;
+	Window->Energy = static_cast<float>(SumOfSquares);
+
+	if (Cache.Num() >= MaxCachedWindows)
+	{
+		// Windows referenced only by the cache are not used by any analyzer
+		for (auto It = Cache.CreateIterator(); It; ++It)
+		{
+			if (It.Value().IsUnique())
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	Cache.Add(Key, Window);
 	return Window;
 }
 
+float UWindowsLibrary::GetWindowCoherentGain(int32 FrameSize, EAnalysisWindowType WindowType, float Parameter)
+{
+	return GetCachedWindow(FrameSize, WindowType, Parameter)->CoherentGain;
+}
+
+float UWindowsLibrary::GetWindowEnergy(int32 FrameSize, EAnalysisWindowType WindowType, float Parameter)
+{
+	return GetCachedWindow(FrameSize, WindowType, Parameter)->Energy;
+}
+
+TArray<float> UWindowsLibrary::CreateHanningWindow(int32 FrameSize)
+{
+	return TArray<float>(CreateHanningWindow(static_cast<int64>(FrameSize)));
+}
+
+TArray64<float> UWindowsLibrary::CreateHanningWindow(int64 FrameSize)
+{
+	return CreateCosineSumWindow(FrameSize, {0.5, 0.5});
+}
+
 TArray<float> UWindowsLibrary::CreateHammingWindow(int32 FrameSize)
 {
 	return TArray<float>(CreateHammingWindow(static_cast<int64>(FrameSize)));
@@ -45,15 +186,7 @@ TArray<float> UWindowsLibrary::CreateHammingWindow(int32 FrameSize)
 
 TArray64<float> UWindowsLibrary::CreateHammingWindow(int64 FrameSize)
 {
-	TArray64<float> Window;
-	Window.Init(0, FrameSize);
-
-	for (TArray64<float>::SizeType Index = 0; Index < Window.Num(); ++Index)
-	{
-		Window[Index] = 0.54 - (0.46 * FMath::Cos(2. * PI * (static_cast<float>(Index) / static_cast<float>(FrameSize - 1))));
-	}
-
-	return Window;
+	return CreateCosineSumWindow(FrameSize, {0.54, 0.46});
 }
 
 TArray<float> UWindowsLibrary::CreateBlackmanWindow(int32 FrameSize)
@@ -63,17 +196,7 @@ TArray<float> UWindowsLibrary::CreateBlackmanWindow(int32 FrameSize)
 
 TArray64<float> UWindowsLibrary::CreateBlackmanWindow(int64 FrameSize)
 {
-	TArray64<float> Window;
-	Window.Init(0, FrameSize);
-
-	const int64 FrameSizeMinusOne = FrameSize - 1;
-
-	for (TArray64<float>::SizeType Index = 0; Index < Window.Num(); ++Index)
-	{
-		Window[Index] = 0.42 - (0.5 * FMath::Cos(2. * PI * (static_cast<float>(Index) / FrameSizeMinusOne))) + (0.08 * FMath::Cos(4. * PI * (static_cast<float>(Index) / FrameSizeMinusOne)));
-	}
-
-	return Window;
+	return CreateCosineSumWindow(FrameSize, {0.42, 0.5, 0.08});
 }
 
 TArray<float> UWindowsLibrary::CreateTukeyWindow(int32 FrameSize, float CosineFraction)
@@ -119,12 +242,57 @@ TArray<float> UWindowsLibrary::CreateRectangularWindow(int32 FrameSize)
 TArray64<float> UWindowsLibrary::CreateRectangularWindow(int64 FrameSize)
 {
 	TArray64<float> Window;
-	Window.Init(0, FrameSize);
+	Window.Init(1.f, FrameSize);
 
-	for (TArray64<float>::SizeType Index = 0; Index < Window.Num(); ++Index)
+	return Window;
+}
+
+TArray<float> UWindowsLibrary::CreateKaiserWindow(int32 FrameSize, float Beta)
+{
+	return TArray<float>(CreateKaiserWindow(static_cast<int64>(FrameSize), Beta));
+}
+
+TArray64<float> UWindowsLibrary::CreateKaiserWindow(int64 FrameSize, float Beta)
+{
+	TArray64<float> Window;
+	Window.SetNumUninitialized(FMath::Max<int64>(FrameSize, 0));
+
+	if (FrameSize == 1)
 	{
-		Window[Index] = 1.f;
+		Window[0] = 1.f;
+		return Window;
+	}
+
+	const double Denominator = BesselI0(Beta);
+
+	for (int64 Index = 0; Index < (FrameSize + 1) / 2; ++Index)
+	{
+		const double Position = 2. * Index / static_cast<double>(FrameSize - 1) - 1.;
+		const float Value = static_cast<float>(BesselI0(Beta * FMath::Sqrt(FMath::Max(1. - Position * Position, 0.))) / Denominator);
+
+		Window[Index] = Value;
+		Window[FrameSize - 1 - Index] = Value;
 	}
 
 	return Window;
 }
+
+TArray<float> UWindowsLibrary::CreateBlackmanHarrisWindow(int32 FrameSize)
+{
+	return TArray<float>(CreateBlackmanHarrisWindow(static_cast<int64>(FrameSize)));
+}
+
+TArray64<float> UWindowsLibrary::CreateBlackmanHarrisWindow(int64 FrameSize)
+{
+	return CreateCosineSumWindow(FrameSize, {0.35875, 0.48829, 0.14128, 0.01168});
+}
+
+TArray<float> UWindowsLibrary::CreateFlatTopWindow(int32 FrameSize)
+{
+	return TArray<float>(CreateFlatTopWindow(static_cast<int64>(FrameSize)));
+}
+
+TArray64<float> UWindowsLibrary::CreateFlatTopWindow(int64 FrameSize)
+{
+	return CreateCosineSumWindow(FrameSize, {0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368});
+}
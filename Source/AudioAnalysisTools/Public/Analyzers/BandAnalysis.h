@@ -0,0 +1,187 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "UObject/Object.h"
+#include "Analyzers/SpectrumBandMap.h"
+#include "BandAnalysis.generated.h"
+
+/**
+ * Layout of the log-spaced frequency bands
+ */
+UENUM(BlueprintType, Category = "Band Analysis")
+enum class EFrequencyBandLayout : uint8
+{
+	/** 10 octave bands centered at 31.5 Hz - 16 kHz */
+	Octave,
+
+	/** 31 third-octave bands centered at 20 Hz - 20 kHz */
+	ThirdOctave
+};
+
+/**
+ * Aggregates the magnitude spectrum into octave or third-octave band levels
+ * The bin-to-band mapping is precomputed per frame size, sample rate and band layout, so each frame takes a single pass over the spectrum
+ */
+UCLASS(BlueprintType, Category = "Band Analysis")
+class AUDIOANALYSISTOOLS_API UBandAnalysis : public UObject
+{
+	GENERATED_BODY()
+
+	UBandAnalysis();
+
+public:
+	/**
+	 * Instantiates a Band Analysis object
+	 *
+	 * @param BandLayout The layout of the frequency bands
+	 * @param AttackTime The time constant of the smoothed levels when they rise, in seconds. 0 disables smoothing
+	 * @param ReleaseTime The time constant of the smoothed levels when they fall, in seconds. 0 disables smoothing
+	 * @param PeakHoldTime The time the peak levels are held before they start to fall, in seconds
+	 * @return The BandAnalysis object
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Band Analysis|Main")
+	static UBandAnalysis* CreateBandAnalysis(EFrequencyBandLayout BandLayout = EFrequencyBandLayout::ThirdOctave, float AttackTime = 0.01f, float ReleaseTime = 0.3f, float PeakHoldTime = 1.f);
+
+	/**
+	 * Update the layout of the frequency bands. Resets the smoothed and peak levels
+	 *
+	 * @param BandLayout The layout of the frequency bands
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Band Analysis|Update")
+	void UpdateBandLayout(EFrequencyBandLayout BandLayout = EFrequencyBandLayout::ThirdOctave);
+
+	/**
+	 * Update the attack/release smoothing of the band levels
+	 *
+	 * @param AttackTime The time constant of the smoothed levels when they rise, in seconds. 0 disables smoothing
+	 * @param ReleaseTime The time constant of the smoothed levels when they fall, in seconds. 0 disables smoothing
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Band Analysis|Update")
+	void UpdateSmoothing(float AttackTime = 0.01f, float ReleaseTime = 0.3f);
+
+	/**
+	 * Update the peak hold of the band levels
+	 *
+	 * @param PeakHoldTime The time the peak levels are held before they start to fall, in seconds
+	 * @param PeakReleaseTime The time constant of the peak levels when they fall after the hold time, in seconds
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Band Analysis|Update")
+	void UpdatePeakHold(float PeakHoldTime = 1.f, float PeakReleaseTime = 0.5f);
+
+	/**
+	 * Process magnitude spectrum
+	 *
+	 * @param MagnitudeSpectrum An array containing the magnitude spectrum (first half of the FFT)
+	 * @param SampleRate The sample rate of the analyzed audio
+	 * @param DeltaTime The time elapsed since the previously processed magnitude spectrum, in seconds. Used by the smoothing and peak hold
+	 * @return Whether the magnitude spectrum was processed successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Band Analysis|Main")
+	bool ProcessMagnitude(const TArray<float>& MagnitudeSpectrum, int32 SampleRate = 44100, float DeltaTime = 0.0929f);
+
+	/**
+	 * Process magnitude spectrum. Suitable for use with 64-bit data size
+	 *
+	 * @param MagnitudeSpectrum An array containing the magnitude spectrum (first half of the FFT)
+	 * @param SampleRate The sample rate of the analyzed audio
+	 * @param DeltaTime The time elapsed since the previously processed magnitude spectrum, in seconds. Used by the smoothing and peak hold
+	 * @return Whether the magnitude spectrum was processed successfully or not
+	 */
+	bool ProcessMagnitude(const TArray64<float>& MagnitudeSpectrum, int32 SampleRate = 44100, float DeltaTime = 0.0929f);
+
+	/**
+	 * Get the number of bands in the current layout
+	 * @return The number of bands
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Band Analysis|Main")
+	int64 GetNumBands() const;
+
+	/**
+	 * Get the nominal center frequency of the band
+	 *
+	 * @param Band Band index
+	 * @return The center frequency in Hz
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Band Analysis|Main")
+	float GetBandCenterFrequency(int64 Band) const;
+
+	/**
+	 * Get the band levels (root mean square magnitude of each band) of the last processed frame
+	 * @return Band levels
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Band Levels"), Category = "Band Analysis|Main")
+	TArray<float> GetBandLevels_BP() const;
+
+	/**
+	 * Get the band levels (root mean square magnitude of each band) of the last processed frame. Suitable for use with 64-bit data size
+	 * @return Band levels
+	 */
+	const TArray64<float>& GetBandLevels() const { return BandLevels; }
+
+	/**
+	 * Get the band levels after attack/release smoothing
+	 * @return Smoothed band levels
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Smoothed Band Levels"), Category = "Band Analysis|Main")
+	TArray<float> GetSmoothedBandLevels_BP() const;
+
+	/**
+	 * Get the band levels after attack/release smoothing. Suitable for use with 64-bit data size
+	 * @return Smoothed band levels
+	 */
+	const TArray64<float>& GetSmoothedBandLevels() const { return SmoothedBandLevels; }
+
+	/**
+	 * Get the held peaks of the smoothed band levels
+	 * @return Peak band levels
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Peak Band Levels"), Category = "Band Analysis|Main")
+	TArray<float> GetPeakBandLevels_BP() const;
+
+	/**
+	 * Get the held peaks of the smoothed band levels. Suitable for use with 64-bit data size
+	 * @return Peak band levels
+	 */
+	const TArray64<float>& GetPeakBandLevels() const { return PeakBandLevels; }
+
+protected:
+	/** The layout of the frequency bands */
+	EFrequencyBandLayout BandLayout;
+
+	/** Nominal center frequency of each band */
+	TArray64<float> CenterFrequencies;
+
+	/** Lower edge of each band, in Hz */
+	TArray64<float> LowEdges;
+
+	/** Upper edge of each band, in Hz */
+	TArray64<float> HighEdges;
+
+	/** Precomputed bin ranges of the bands for the last frame size and sample rate */
+	FSpectrumBandMap BandMap;
+
+	/** Band levels of the last processed frame */
+	TArray64<float> BandLevels;
+
+	/** Band levels after attack/release smoothing */
+	TArray64<float> SmoothedBandLevels;
+
+	/** Held peaks of the smoothed band levels */
+	TArray64<float> PeakBandLevels;
+
+	/** Remaining hold time of each peak, in seconds */
+	TArray64<float> PeakHoldTimers;
+
+	/** The time constant of the smoothed levels when they rise, in seconds */
+	float AttackTime;
+
+	/** The time constant of the smoothed levels when they fall, in seconds */
+	float ReleaseTime;
+
+	/** The time the peak levels are held before they start to fall, in seconds */
+	float PeakHoldTime;
+
+	/** The time constant of the peak levels when they fall after the hold time, in seconds */
+	float PeakReleaseTime;
+};
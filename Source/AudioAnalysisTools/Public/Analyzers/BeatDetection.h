@@ -3,12 +3,54 @@
 #pragma once
 
 #include "UObject/Object.h"
+#include "Analyzers/SpectrumBandMap.h"
+#include "Analyzers/SignalHistory.h"
 #include "BeatDetection.generated.h"
 
 #define KICK_BAND 0
 #define SNARE_BAND 1
 #define HIHAT_BAND 2
 
+/**
+ * How the magnitude spectrum is split into beat detection sub-bands
+ */
+UENUM(BlueprintType, Category = "Beat Detection")
+enum class EBeatDetectionBandLayout : uint8
+{
+	/** Equal-width slices of the magnitude spectrum, regardless of the sample rate. Bins that do not fill a whole slice are ignored */
+	Linear,
+
+	/** Bands with equal width in octaves between the min and max frequencies */
+	Logarithmic,
+
+	/** Bands with equal width on the mel scale between the min and max frequencies */
+	Mel,
+
+	/** Bands between explicitly specified edge frequencies */
+	Custom
+};
+
+/**
+ * Beat signals kept in the beat detection history
+ */
+UENUM(BlueprintType, Category = "Beat Detection")
+enum class EBeatDetectionSignal : uint8
+{
+	/** 1 if there was a kick beat, 0 otherwise */
+	Kick,
+
+	/** 1 if there was a snare drum beat, 0 otherwise */
+	Snare,
+
+	/** 1 if there was a hi-hat beat, 0 otherwise */
+	HiHat,
+
+	/** The number of sub-bands with a beat */
+	NumBeats,
+
+	Count UMETA(Hidden)
+};
+
 /**
  * Beat detection
  */
@@ -30,7 +72,7 @@ public:
 
 public:
 	/**
-	 * Update FFT sub-band size
+	 * Update FFT sub-band size. With the custom band layout, the size is given by the custom band edges and cannot be changed here
 	 *
 	 * @param FFTSubbandSize FFT sub-band size
 	 * @note Commonly used 32
@@ -47,20 +89,49 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Beat Detection|Update")
 	void UpdateEnergyHistorySize(int64 EnergyHistorySize = 41);
 
+	/**
+	 * Update the sub-band layout. Uses the current FFT sub-band size as the number of bands and resets the energy history
+	 *
+	 * @param Layout How the magnitude spectrum is split into sub-bands. Custom edges must be set with UpdateCustomBandEdges instead
+	 * @param MinFrequency The lower edge of the first sub-band, in Hz. Not used by the linear layout
+	 * @param MaxFrequency The upper edge of the last sub-band, in Hz. Not used by the linear layout
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Detection|Update")
+	void UpdateBandLayout(EBeatDetectionBandLayout Layout = EBeatDetectionBandLayout::Logarithmic, float MinFrequency = 30.f, float MaxFrequency = 16000.f);
+
+	/**
+	 * Use sub-bands between explicitly specified edge frequencies. Updates the FFT sub-band size to the number of edges minus one
+	 *
+	 * @param EdgeFrequencies Ascending band edge frequencies, in Hz. Sub-band N spans from edge N to edge N + 1
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Detection|Update")
+	void UpdateCustomBandEdges(const TArray<float>& EdgeFrequencies);
+
+	/**
+	 * Get the current sub-band layout
+	 * @return The sub-band layout
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Detection|Main")
+	EBeatDetectionBandLayout GetBandLayout() const { return BandLayout; }
+
 	/**
 	 * Process magnitude spectrum
 	 * 
 	 * @param MagnitudeSpectrum An array containing the magnitude spectrum
+	 * @param SampleRate The sample rate of the analyzed audio. Not used by the linear layout
+	 * @param Timestamp The time of the spectrum in seconds, stored in the history. Negative values use the number of processed spectrums instead
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Beat Detection|Main")
-	void ProcessMagnitude(const TArray<float>& MagnitudeSpectrum);
+	void ProcessMagnitude(const TArray<float>& MagnitudeSpectrum, int32 SampleRate = 44100, float Timestamp = -1);
 
 	/**
 	 * Process magnitude spectrum. Suitable for use with 64-bit data size
 	 * 
 	 * @param MagnitudeSpectrum An array containing the magnitude spectrum
+	 * @param SampleRate The sample rate of the analyzed audio. Not used by the linear layout
+	 * @param Timestamp The time of the spectrum in seconds, stored in the history. Negative values use the number of processed spectrums instead
 	 */
-	void ProcessMagnitude(const TArray64<float>& MagnitudeSpectrum);
+	void ProcessMagnitude(const TArray64<float>& MagnitudeSpectrum, int32 SampleRate = 44100, double Timestamp = -1);
 
 	/**
 	 * Calculate if there was beat in the processed magnitude spectrum
@@ -106,6 +177,81 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Beat Detection|Main")
 	bool IsBeatRange(int64 Low, int64 High, int64 Threshold) const;
 
+	/**
+	 * Count the sub-bands with a beat within the given sub-bands span
+	 *
+	 * @param Low Start FFT sub-band index
+	 * @param High End FFT sub-band index (inclusive)
+	 * @return The number of sub-bands with a beat, or 0 if the span is invalid
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Detection|Main")
+	int64 CountBeatsInRange(int64 Low, int64 High) const;
+
+	/**
+	 * Get the beat bitmask of the processed magnitude spectrum, where bit (Subband % 64) of word (Subband / 64) is set if there was a beat in the sub-band
+	 * @return The beat bitmask
+	 */
+	const TArray64<uint64>& GetBeatMask() const { return BeatMask; }
+
+	/**
+	 * Keep a timestamped history of each beat signal calculated by ProcessMagnitude. Clears the existing history
+	 *
+	 * @param Capacity The maximum number of spectrums kept per signal
+	 * @param WindowDuration The duration the history aggregates (max, mean, count above threshold) are calculated over, in seconds
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Detection|History")
+	void EnableHistory(int64 Capacity = 512, float WindowDuration = 1.f);
+
+	/**
+	 * Stop keeping the history and free it
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Detection|History")
+	void DisableHistory();
+
+	/**
+	 * Update the threshold the values of the beat signal are counted above. Clears the history of the signal
+	 *
+	 * @param Signal The beat signal
+	 * @param Threshold The threshold. Defaults to 0.5, which counts the beats
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Detection|History")
+	void UpdateHistoryThreshold(EBeatDetectionSignal Signal, float Threshold);
+
+	/**
+	 * Get the maximum value of the beat signal over the history window
+	 *
+	 * @param Signal The beat signal
+	 * @return The maximum value, or 0 if the history is empty
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Detection|History")
+	float GetHistoryMax(EBeatDetectionSignal Signal) const;
+
+	/**
+	 * Get the mean value of the beat signal over the history window (e.g. the fraction of spectrums with a kick beat)
+	 *
+	 * @param Signal The beat signal
+	 * @return The mean value, or 0 if the history is empty
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Detection|History")
+	float GetHistoryMean(EBeatDetectionSignal Signal) const;
+
+	/**
+	 * Get the number of values of the beat signal above its threshold over the history window (e.g. the number of kick beats)
+	 *
+	 * @param Signal The beat signal
+	 * @return The number of values above the threshold
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Detection|History")
+	int64 GetHistoryCountAboveThreshold(EBeatDetectionSignal Signal) const;
+
+	/**
+	 * Get the history of the beat signal, for zero-copy lookback reads
+	 *
+	 * @param Signal The beat signal
+	 * @return The history
+	 */
+	const FSignalHistory& GetHistory(EBeatDetectionSignal Signal) const { return BeatHistories[static_cast<int32>(Signal)]; }
+
 	/**
 	 * Get the value of the specified sub-band
 	 * 
@@ -128,6 +274,15 @@ public:
 	 */
 	const TArray64<float>& GetFFTSubbands() const { return FFTSubbands; }
 
+	/**
+	 * Copy FFT Sub-bands values into the given array without reallocating it when its size already matches. Suitable for calling every tick
+	 *
+	 * @param Values The array to fill
+	 * @return Whether the array was filled successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Fill FFT Subbands"), Category = "Beat Detection|Main")
+	bool FillFFTSubbands(UPARAM(ref) TArray<float>& Values) const;
+
 	/**
 	 * Get FFT Average Energy values
 	 * @return FFT Average Energy values
@@ -141,6 +296,15 @@ public:
 	 */
 	const TArray64<float>& GetFFTAverageEnergy() const { return FFTAverageEnergy; }
 
+	/**
+	 * Copy FFT Average Energy values into the given array without reallocating it when its size already matches. Suitable for calling every tick
+	 *
+	 * @param Values The array to fill
+	 * @return Whether the array was filled successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Fill FFT Average Energy"), Category = "Beat Detection|Main")
+	bool FillFFTAverageEnergy(UPARAM(ref) TArray<float>& Values) const;
+
 	/**
 	 * Get FFT Variance values
 	 * @return FFT Variance values
@@ -154,6 +318,15 @@ public:
 	 */
 	const TArray64<float>& GetFFTVariance() const { return FFTVariance; }
 
+	/**
+	 * Copy FFT Variance values into the given array without reallocating it when its size already matches. Suitable for calling every tick
+	 *
+	 * @param Values The array to fill
+	 * @return Whether the array was filled successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Fill FFT Variance"), Category = "Beat Detection|Main")
+	bool FillFFTVariance(UPARAM(ref) TArray<float>& Values) const;
+
 	/**
 	 * Get FFT Beat values
 	 * @return FFT Beat values
@@ -167,13 +340,58 @@ public:
 	 */
 	const TArray64<float>& GetFFTBeatValues() const { return FFTBeatValues; }
 
+	/**
+	 * Copy FFT Beat values into the given array without reallocating it when its size already matches. Suitable for calling every tick
+	 *
+	 * @param Values The array to fill
+	 * @return Whether the array was filled successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Fill FFT Beat Values"), Category = "Beat Detection|Main")
+	bool FillFFTBeatValues(UPARAM(ref) TArray<float>& Values) const;
+
 protected:
 	/**
 	 * Update FFT data (sub-bands, average energy, etc.)
 	 * 
 	 * @param MagnitudeSpectrum An array containing the magnitude spectrum
+	 * @param SampleRate The sample rate of the analyzed audio. Not used by the linear layout
 	 */
-	void UpdateFFT(const TArray64<float>& MagnitudeSpectrum);
+	void UpdateFFT(const TArray64<float>& MagnitudeSpectrum, int32 SampleRate);
+
+	/**
+	 * Calculate the sub-band values and variances for the frequency-based layouts
+	 *
+	 * @param MagnitudeSpectrum An array containing the magnitude spectrum
+	 * @param SampleRate The sample rate of the analyzed audio
+	 */
+	void UpdateMappedSubbands(const TArray64<float>& MagnitudeSpectrum, int32 SampleRate);
+
+	/** Recalculate the sub-band edges (and the kick, snare and hi-hat sub-band ranges) for the frequency-based layouts */
+	void UpdateBandEdges();
+
+	/** Range of sub-bands (inclusive) */
+	struct FSubbandRange
+	{
+		int64 Low = 0;
+		int64 High = -1;
+	};
+
+	/**
+	 * Find the sub-bands whose center frequency lies in the frequency range
+	 *
+	 * @param LowFrequency The lower frequency, in Hz
+	 * @param HighFrequency The upper frequency, in Hz
+	 * @return The sub-band range, or the sub-band closest to the frequency range if none is within it
+	 */
+	FSubbandRange FindSubbandRange(float LowFrequency, float HighFrequency) const;
+
+	/**
+	 * Calculate if there was a beat within the sub-band range, in a majority sense for ranges of more than one sub-band
+	 *
+	 * @param Range The sub-band range
+	 * @return Whether there was a beat or not
+	 */
+	bool IsBeatInRange(const FSubbandRange& Range) const;
 
 	/** Raw value for each sub-band */
 	TArray64<float> FFTSubbands;
@@ -187,8 +405,17 @@ protected:
 	/** Normalized beat values for each sub-band */
 	TArray64<float> FFTBeatValues;
 
-	/** History of energy needed to "memorize" previous magnitudes */
-	TArray64<TArray64<float>> EnergyHistory;
+	/** Whether there was a beat in each sub-band, one bit per sub-band. Computed once per processed magnitude spectrum */
+	TArray64<uint64> BeatMask;
+
+	/** History of energy needed to "memorize" previous magnitudes. Stored contiguously, band-major: [Subband * EnergyHistorySize + Position] */
+	TArray64<float> EnergyHistory;
+
+	/** Running sum of the energy history of each sub-band, updated on every insertion so the average costs O(1) per sub-band */
+	TArray64<double> EnergyHistorySums;
+
+	/** Neumaier compensation of each running sum, collecting the rounding errors of the insertions so they do not accumulate */
+	TArray64<double> EnergyHistoryCompensations;
 
 	/** Current position to track energy history */
 	int64 HistoryPosition;
@@ -198,4 +425,40 @@ protected:
 
 	/** Energy history storage size */
 	int64 EnergyHistorySize;
+
+	/** How the magnitude spectrum is split into sub-bands */
+	EBeatDetectionBandLayout BandLayout;
+
+	/** The lower edge of the first sub-band for the logarithmic and mel layouts, in Hz */
+	float MinFrequency;
+
+	/** The upper edge of the last sub-band for the logarithmic and mel layouts, in Hz */
+	float MaxFrequency;
+
+	/** The lower edge of each sub-band, in Hz. Not used by the linear layout */
+	TArray64<float> LowEdges;
+
+	/** The upper edge of each sub-band, in Hz. Not used by the linear layout */
+	TArray64<float> HighEdges;
+
+	/** The edge frequencies of the custom layout, in Hz */
+	TArray64<float> CustomEdges;
+
+	/** Precomputed bin ranges of the sub-bands, rebuilt when the spectrum size or the sample rate changes. Not used by the linear layout */
+	FSpectrumBandMap BandMap;
+
+	/** The sub-bands used for the kick detection with the frequency-based layouts */
+	FSubbandRange KickRange;
+
+	/** The sub-bands used for the snare detection with the frequency-based layouts */
+	FSubbandRange SnareRange;
+
+	/** The sub-bands used for the hi-hat detection with the frequency-based layouts */
+	FSubbandRange HiHatRange;
+
+	/** The number of ProcessMagnitude calls, used as the timestamp when none is given */
+	int64 NumProcessedSpectrums;
+
+	/** The history of each beat signal calculated by ProcessMagnitude. Disabled unless EnableHistory is called */
+	FSignalHistory BeatHistories[static_cast<int32>(EBeatDetectionSignal::Count)];
 };
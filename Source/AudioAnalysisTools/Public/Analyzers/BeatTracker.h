@@ -0,0 +1,173 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "UObject/Object.h"
+#include "BeatTracker.generated.h"
+
+/**
+ * Predictive beat tracker based on the dynamic programming approach of BTrack (Stark, Davies, Plumbley, "Real-time beat-synchronous analysis of musical audio", 2009)
+ * Keeps a cumulative score of the onset detection function and predicts the time of the next beat, so that events can be scheduled ahead of it
+ */
+UCLASS(BlueprintType, Category = "Beat Tracker")
+class AUDIOANALYSISTOOLS_API UBeatTracker : public UObject
+{
+	GENERATED_BODY()
+
+	UBeatTracker();
+
+public:
+	/**
+	 * Instantiates a Beat Tracker object
+	 *
+	 * @param ScoreHistorySize The number of cumulative score values to keep. Must be larger than twice the longest beat period, in frames
+	 * @param Alpha The weight of the past cumulative score against the current onset detection function value (commonly 0.9)
+	 * @param Tightness How strictly the beats are kept at the beat period from each other (commonly 5)
+	 * @return The BeatTracker object
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Tracker|Main")
+	static UBeatTracker* CreateBeatTracker(int64 ScoreHistorySize = 512, float Alpha = 0.9f, float Tightness = 5.f);
+
+	/**
+	 * Update the beat tracker parameters. Resets the tracking
+	 *
+	 * @param ScoreHistorySize The number of cumulative score values to keep
+	 * @param Alpha The weight of the past cumulative score against the current onset detection function value
+	 * @param Tightness How strictly the beats are kept at the beat period from each other
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Tracker|Update")
+	void UpdateParameters(int64 ScoreHistorySize = 512, float Alpha = 0.9f, float Tightness = 5.f);
+
+	/**
+	 * Process the next onset detection function value
+	 *
+	 * @param OnsetValue The onset detection function value of the frame
+	 * @param Timestamp The time of the frame, in seconds
+	 * @param DeltaTime The time elapsed since the previous value, in seconds
+	 * @param BeatPeriod The beat period in frames (e.g. from the Tempo Estimation). Values <= 0 keep the previous period (120 BPM initially)
+	 * @return Whether a beat falls on this frame or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Tracker|Main")
+	bool ProcessOnsetValue(float OnsetValue, float Timestamp, float DeltaTime, float BeatPeriod = 0.f);
+
+	/**
+	 * Process the next onset detection function value. Suitable for long running streams, where the timestamp needs double precision
+	 *
+	 * @param OnsetValue The onset detection function value of the frame
+	 * @param Timestamp The time of the frame, in seconds
+	 * @param DeltaTime The time elapsed since the previous value, in seconds
+	 * @param BeatPeriod The beat period in frames (e.g. from the Tempo Estimation). Values <= 0 keep the previous period (120 BPM initially)
+	 * @return Whether a beat falls on this frame or not
+	 */
+	bool ProcessOnsetValue(float OnsetValue, double Timestamp, float DeltaTime, float BeatPeriod = 0.f);
+
+	/**
+	 * Whether a beat falls on the last processed frame or not
+	 * @return Whether there was a beat or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Tracker|Main")
+	bool IsBeatDue() const { return bBeatDue; }
+
+	/**
+	 * Get the position within the current beat
+	 * @return The beat phase in the [0, 1) range, where 0 is the last beat and 1 is the predicted next beat
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Tracker|Main")
+	float GetBeatPhase() const;
+
+	/**
+	 * Get the time until the predicted next beat
+	 * @return The time in seconds, relative to the last processed frame
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Tracker|Main")
+	float GetTimeToNextBeat() const;
+
+	/**
+	 * Get the predicted time of the next beat
+	 * @return The timestamp in seconds, on the same timeline as the processed frames
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Beat Tracker|Main")
+	float GetNextBeatTimestamp() const;
+
+	/**
+	 * Get the predicted time of the next beat in double precision
+	 * @return The timestamp in seconds, on the same timeline as the processed frames
+	 */
+	double GetPreciseNextBeatTimestamp() const;
+
+	/**
+	 * Get the tempo the beats are tracked at
+	 * @return The tempo in beats per minute
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get BPM"), Category = "Beat Tracker|Main")
+	float GetBPM() const;
+
+protected:
+	/**
+	 * Get the cumulative score of the frame, using the predicted future scores for frames after the current one
+	 *
+	 * @param Frame The absolute frame index
+	 * @return The cumulative score
+	 */
+	float GetScore(int64 Frame) const;
+
+	/**
+	 * Calculate the best weighted past score for the frame, searching between two and a half beat periods back
+	 *
+	 * @param Frame The absolute frame index
+	 * @return The maximum of the transition-weighted cumulative scores
+	 */
+	float GetBestPastScore(int64 Frame) const;
+
+	/**
+	 * Set the beat period and rebuild the transition weights if it changed
+	 *
+	 * @param NewBeatPeriod The beat period, in frames
+	 */
+	void SetBeatPeriod(float NewBeatPeriod);
+
+	/** Predict the next beat by extending the cumulative score into the future with no onsets */
+	void PredictNextBeat();
+
+	/** Ring of cumulative score values, indexed by the absolute frame index */
+	TArray64<float> CumulativeScore;
+
+	/** Predicted cumulative score values for the frames after the current one */
+	TArray64<float> FutureScore;
+
+	/** Log-Gaussian transition weights for the lags between half and twice the beat period, cached per beat period */
+	TArray64<float> TransitionWeights;
+
+	/** The lag corresponding to the first transition weight */
+	int64 MinTransitionLag;
+
+	/** The weight of the past cumulative score */
+	float Alpha;
+
+	/** How strictly the beats are kept at the beat period from each other */
+	float Tightness;
+
+	/** The beat period, in frames */
+	float BeatPeriod;
+
+	/** Smoothed duration of a frame, in seconds */
+	float FrameDuration;
+
+	/** The absolute index of the last processed frame */
+	int64 CurrentFrame;
+
+	/** The absolute index of the last beat frame */
+	int64 LastBeatFrame;
+
+	/** The absolute index of the predicted next beat frame */
+	int64 NextBeatFrame;
+
+	/** The absolute frame index at which the next beat is re-estimated from the score (half a period after a beat, which first extrapolates it one period ahead) */
+	int64 PredictionFrame;
+
+	/** The time of the last processed frame, in seconds */
+	double CurrentTimestamp;
+
+	/** Whether a beat falls on the last processed frame or not */
+	bool bBeatDue;
+};
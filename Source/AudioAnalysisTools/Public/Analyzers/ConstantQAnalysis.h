@@ -0,0 +1,153 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "UObject/Object.h"
+#include "ConstantQAnalysis.generated.h"
+
+/**
+ * Constant-Q transform and chroma features computed from the FFT output
+ * Uses the sparse spectral kernel described by Brown and Puckette ("An efficient algorithm for the calculation of a constant Q transform", 1992)
+ * The kernel is computed once per configuration and then applied to each FFT frame as a sparse matrix-vector product
+ * Each temporal kernel is Hamming-windowed and centered in the frame. If the FFT frame was windowed too (e.g. with the Hann window of the Audio Analysis Tools), the two windows multiply,
+ * which shortens the effective window of the low bins whose kernels span most of the frame and so widens their bandwidth. Analyze rectangular-windowed frames to keep the nominal Q
+ */
+UCLASS(BlueprintType, Category = "Constant-Q Analysis")
+class AUDIOANALYSISTOOLS_API UConstantQAnalysis : public UObject
+{
+	GENERATED_BODY()
+
+	UConstantQAnalysis();
+
+public:
+	/**
+	 * Instantiates a Constant-Q Analysis object
+	 *
+	 * @param MinFrequency The frequency of the lowest constant-Q bin, in Hz (C2 by default)
+	 * @param BinsPerOctave The number of constant-Q bins per octave. Should be a multiple of 12 for meaningful chroma features
+	 * @param NumOctaves The number of octaves covered by the transform
+	 * @return The ConstantQAnalysis object
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Constant-Q Analysis|Main")
+	static UConstantQAnalysis* CreateConstantQAnalysis(float MinFrequency = 65.406f, int32 BinsPerOctave = 12, int32 NumOctaves = 6);
+
+	/**
+	 * Update the constant-Q parameters. The spectral kernel will be rebuilt on the next processed frame
+	 *
+	 * @param MinFrequency The frequency of the lowest constant-Q bin, in Hz
+	 * @param BinsPerOctave The number of constant-Q bins per octave
+	 * @param NumOctaves The number of octaves covered by the transform
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Constant-Q Analysis|Update")
+	void UpdateParameters(float MinFrequency = 65.406f, int32 BinsPerOctave = 12, int32 NumOctaves = 6);
+
+	/**
+	 * Process the complex FFT output of a frame
+	 *
+	 * @param FFTReal An array containing the real part of the FFT (full length, i.e. mirrored)
+	 * @param FFTImaginary An array containing the imaginary part of the FFT (full length, i.e. mirrored)
+	 * @param SampleRate The sample rate of the analyzed audio
+	 * @return Whether the frame was processed successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Process FFT"), Category = "Constant-Q Analysis|Main")
+	bool ProcessFFT(const TArray<float>& FFTReal, const TArray<float>& FFTImaginary, int32 SampleRate = 44100);
+
+	/**
+	 * Process the complex FFT output of a frame. Suitable for use with 64-bit data size
+	 *
+	 * @param FFTReal An array containing the real part of the FFT (full length, i.e. mirrored)
+	 * @param FFTImaginary An array containing the imaginary part of the FFT (full length, i.e. mirrored)
+	 * @param SampleRate The sample rate of the analyzed audio
+	 * @return Whether the frame was processed successfully or not
+	 */
+	bool ProcessFFT(const TArray64<float>& FFTReal, const TArray64<float>& FFTImaginary, int32 SampleRate = 44100);
+
+	/**
+	 * Get the center frequency of the specified constant-Q bin
+	 *
+	 * @param Bin Constant-Q bin index
+	 * @return The center frequency in Hz
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Constant-Q Analysis|Main")
+	float GetBinFrequency(int64 Bin) const;
+
+	/**
+	 * Get the magnitudes of the constant-Q bins of the last processed frame
+	 * @return Constant-Q spectrum
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Constant-Q Spectrum"), Category = "Constant-Q Analysis|Main")
+	TArray<float> GetConstantQSpectrum_BP() const;
+
+	/**
+	 * Get the magnitudes of the constant-Q bins of the last processed frame. Suitable for use with 64-bit data size
+	 * @return Constant-Q spectrum
+	 */
+	const TArray64<float>& GetConstantQSpectrum() const { return ConstantQSpectrum; }
+
+	/**
+	 * Get the 12-bin chroma vector (pitch classes starting from C) of the last processed frame, normalized to the [0, 1] range
+	 * @return Chroma vector
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Chroma"), Category = "Constant-Q Analysis|Main")
+	TArray<float> GetChroma_BP() const;
+
+	/**
+	 * Get the 12-bin chroma vector (pitch classes starting from C) of the last processed frame, normalized to the [0, 1] range
+	 * @return Chroma vector
+	 */
+	const TArray64<float>& GetChroma() const { return Chroma; }
+
+	/**
+	 * Get the revision of the parameters, incremented on every parameter update
+	 * @return The parameters revision
+	 */
+	int32 GetParametersRevision() const { return ParametersRevision; }
+
+protected:
+	/**
+	 * Build the sparse spectral kernel for the given FFT size and sample rate
+	 *
+	 * @param FFTSize The size of the FFT the kernel will be applied to
+	 * @param SampleRate The sample rate of the analyzed audio
+	 */
+	void UpdateKernel(int64 FFTSize, int32 SampleRate);
+
+	/** The frequency of the lowest constant-Q bin, in Hz */
+	float MinFrequency;
+
+	/** The number of constant-Q bins per octave */
+	int32 BinsPerOctave;
+
+	/** The number of octaves covered by the transform */
+	int32 NumOctaves;
+
+	/** Incremented on every parameter update, so that results cached by the callers can be invalidated */
+	int32 ParametersRevision;
+
+	/** The FFT size the current kernel was built for (0 if the kernel needs to be rebuilt) */
+	int64 KernelFFTSize;
+
+	/** The sample rate the current kernel was built for */
+	int32 KernelSampleRate;
+
+	/** Offsets of each constant-Q bin row in the sparse kernel (compressed sparse row layout, NumBins + 1 entries) */
+	TArray64<int64> KernelRowOffsets;
+
+	/** FFT bin index of each non-zero kernel entry */
+	TArray64<int64> KernelBinIndices;
+
+	/** Real part of each non-zero kernel entry (conjugated and normalized by the FFT size) */
+	TArray64<float> KernelReal;
+
+	/** Imaginary part of each non-zero kernel entry (conjugated and normalized by the FFT size) */
+	TArray64<float> KernelImaginary;
+
+	/** Pitch class (0 = C) of each constant-Q bin */
+	TArray64<int32> ChromaIndices;
+
+	/** Constant-Q magnitudes of the last processed frame */
+	TArray64<float> ConstantQSpectrum;
+
+	/** Chroma vector of the last processed frame */
+	TArray64<float> Chroma;
+};
@@ -5,6 +5,44 @@
 #include "UObject/Object.h"
 #include "CoreTimeDomainFeatures.generated.h"
 
+/**
+ * Time domain features of a single frame, computed together in one pass
+ */
+USTRUCT(BlueprintType, Category = "Core Time Domain Features")
+struct AUDIOANALYSISTOOLS_API FTimeDomainFrameStats
+{
+	GENERATED_BODY()
+
+	FTimeDomainFrameStats()
+		: Energy(0),
+		  RootMeanSquare(0),
+		  PeakEnergy(0),
+		  ZeroCrossingRate(0),
+		  DCOffset(0)
+	{
+	}
+
+	/** The sum of the squared audio frames (the energy envelope) */
+	UPROPERTY(BlueprintReadOnly, Category = "Core Time Domain Features")
+	float Energy;
+
+	/** The root mean square (RMS) of the audio frames */
+	UPROPERTY(BlueprintReadOnly, Category = "Core Time Domain Features")
+	float RootMeanSquare;
+
+	/** The max absolute value of the audio frames */
+	UPROPERTY(BlueprintReadOnly, Category = "Core Time Domain Features")
+	float PeakEnergy;
+
+	/** The number of sign changes between neighbouring audio frames */
+	UPROPERTY(BlueprintReadOnly, Category = "Core Time Domain Features")
+	float ZeroCrossingRate;
+
+	/** The mean of the audio frames */
+	UPROPERTY(BlueprintReadOnly, Category = "Core Time Domain Features")
+	float DCOffset;
+};
+
 /**
  * Implementations of common time domain audio features
  */
@@ -67,4 +105,22 @@ public:
 	 * @return The zero crossing rate
 	 */
 	static float GetZeroCrossingRate(const TArray64<float>& AudioFrames);
+
+	/**
+	 * Calculate the energy, RMS, peak energy, zero crossing rate and DC offset of a time domain audio signal buffer in a single vectorized pass
+	 *
+	 * @param AudioFrames An array containing audio frame in 32-bit float PCM format
+	 * @return The time domain features of the buffer
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Core Time Domain Features")
+	static FTimeDomainFrameStats GetFrameStats(const TArray<float>& AudioFrames);
+
+	/**
+	 * Calculate the energy, RMS, peak energy, zero crossing rate and DC offset of a time domain audio signal buffer in a single vectorized pass
+	 * Suitable for use with 64-bit data size
+	 *
+	 * @param AudioFrames A view of audio frames in 32-bit float PCM format
+	 * @return The time domain features of the buffer
+	 */
+	static FTimeDomainFrameStats GetFrameStats(TArrayView64<const float> AudioFrames);
 };
@@ -0,0 +1,161 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "UObject/Object.h"
+#include "HAL/CriticalSection.h"
+#include "EnvelopeAnalysis.generated.h"
+
+/**
+ * What the envelope follows
+ */
+UENUM(BlueprintType, Category = "Envelope Analysis")
+enum class EEnvelopeDetectionMode : uint8
+{
+	/** The absolute value of the samples */
+	Peak,
+
+	/** The mean square of the samples, output as its square root */
+	RootMeanSquare
+};
+
+/**
+ * Streaming envelope follower working directly on the time domain samples, without an FFT
+ * Each channel is followed sample by sample with separate attack and release coefficients (four channels at a time in vector lanes), and the envelope is decimated to a control rate suitable for driving lights or animation
+ */
+UCLASS(BlueprintType, Category = "Envelope Analysis")
+class AUDIOANALYSISTOOLS_API UEnvelopeAnalysis : public UObject
+{
+	GENERATED_BODY()
+
+	UEnvelopeAnalysis();
+
+public:
+	/**
+	 * Instantiates an Envelope Analysis object
+	 *
+	 * @param Mode What the envelope follows
+	 * @param AttackTime The time constant of the envelope when it rises, in seconds. 0 follows the rise instantly
+	 * @param ReleaseTime The time constant of the envelope when it falls, in seconds. 0 follows the fall instantly
+	 * @param ControlRate The rate the envelope is output at, in Hz (e.g. 60 - 240)
+	 * @return The EnvelopeAnalysis object
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Envelope Analysis|Main")
+	static UEnvelopeAnalysis* CreateEnvelopeAnalysis(EEnvelopeDetectionMode Mode = EEnvelopeDetectionMode::Peak, float AttackTime = 0.005f, float ReleaseTime = 0.15f, float ControlRate = 120.f);
+
+	/**
+	 * Update the envelope follower parameters. Keeps the current envelope, so the output does not jump
+	 *
+	 * @param Mode What the envelope follows
+	 * @param AttackTime The time constant of the envelope when it rises, in seconds. 0 follows the rise instantly
+	 * @param ReleaseTime The time constant of the envelope when it falls, in seconds. 0 follows the fall instantly
+	 * @param ControlRate The rate the envelope is output at, in Hz (e.g. 60 - 240)
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Envelope Analysis|Update")
+	void UpdateParameters(EEnvelopeDetectionMode Mode = EEnvelopeDetectionMode::Peak, float AttackTime = 0.005f, float ReleaseTime = 0.15f, float ControlRate = 120.f);
+
+	/**
+	 * Clear the envelope and the pending control values
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Envelope Analysis|Main")
+	void Reset();
+
+	/**
+	 * Process the next block of audio
+	 *
+	 * @param AudioFrames An array containing interleaved audio frames in 32-bit float PCM format
+	 * @param NumChannels The number of interleaved channels
+	 * @param SampleRate The sample rate of the audio
+	 * @return Whether the audio was processed successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Envelope Analysis|Main")
+	bool ProcessAudioFrames(const TArray<float>& AudioFrames, int32 NumChannels = 1, int32 SampleRate = 44100);
+
+	/**
+	 * Process the next block of audio. Suitable for use with 64-bit data size
+	 *
+	 * @param AudioFrames A view of interleaved audio frames in 32-bit float PCM format
+	 * @param NumChannels The number of interleaved channels
+	 * @param SampleRate The sample rate of the audio
+	 * @return Whether the audio was processed successfully or not
+	 */
+	bool ProcessAudioFrames(TArrayView64<const float> AudioFrames, int32 NumChannels = 1, int32 SampleRate = 44100);
+
+	/**
+	 * Get the envelope of the channel at the last control point
+	 *
+	 * @param Channel Channel index
+	 * @return The envelope value, or 0 if the channel is invalid
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Envelope Analysis|Main")
+	float GetEnvelope(int32 Channel = 0) const;
+
+	/**
+	 * Get the largest envelope across the channels at the last control point
+	 * @return The envelope value
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Envelope Analysis|Main")
+	float GetCombinedEnvelope() const { return CombinedEnvelope; }
+
+	/**
+	 * Get the combined envelope values output at the control rate since the last call and remove them from the queue. Thread safe
+	 *
+	 * @param ControlValues The envelope values, in chronological order and spaced 1 / ControlRate seconds apart
+	 * @return Whether there were any control values or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Envelope Analysis|Main")
+	bool ConsumeControlValues(TArray<float>& ControlValues);
+
+	/**
+	 * Get the rate the envelope is output at
+	 * @return The control rate in Hz
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Envelope Analysis|Main")
+	float GetControlRate() const { return ControlRate; }
+
+protected:
+	/** Recalculate the coefficients and the control interval for the sample rate */
+	void UpdateCoefficients(int32 InSampleRate);
+
+	/** What the envelope follows */
+	EEnvelopeDetectionMode Mode;
+
+	/** The time constant of the envelope when it rises, in seconds */
+	float AttackTime;
+
+	/** The time constant of the envelope when it falls, in seconds */
+	float ReleaseTime;
+
+	/** The rate the envelope is output at, in Hz */
+	float ControlRate;
+
+	/** The sample rate the coefficients were calculated for */
+	int32 SampleRate;
+
+	/** The one-pole coefficient used when the envelope rises */
+	float AttackCoefficient;
+
+	/** The one-pole coefficient used when the envelope falls */
+	float ReleaseCoefficient;
+
+	/** The number of frames between two control points. Fractional, so the control rate does not drift */
+	double FramesPerControlValue;
+
+	/** The number of frames left until the next control point */
+	double FramesUntilControlValue;
+
+	/** The running envelope of each channel, in the detector domain (squared for the RMS mode) */
+	TArray<float> Envelopes;
+
+	/** The output envelope of each channel at the last control point */
+	TArray<float> ControlEnvelopes;
+
+	/** The largest output envelope across the channels at the last control point */
+	float CombinedEnvelope;
+
+	/** Control values not consumed yet */
+	TArray<float> PendingControlValues;
+
+	/** Guard for the pending control values, which are usually consumed from a different thread than the one processing the audio */
+	mutable FCriticalSection ControlValuesGuard;
+};
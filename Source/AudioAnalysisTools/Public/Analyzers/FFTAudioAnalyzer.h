@@ -14,6 +14,31 @@ struct FFTComplexSamples
 
 constexpr int32 MaxFactors = 32;
 
+/**
+ * Outputs derived from the FFT of an audio frame
+ */
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"), Category = "Audio Analysis Tools")
+enum class EFFTOutputs : uint8
+{
+	None = 0 UMETA(Hidden),
+
+	/** The real and imaginary parts of all bins */
+	Complex = 1 << 0,
+
+	/** The magnitude spectrum */
+	Magnitude = 1 << 1,
+
+	/** The power (squared magnitude) spectrum */
+	Power = 1 << 2,
+
+	/** The phase spectrum, in radians */
+	Phase = 1 << 3,
+
+	/** The power spectrum in decibels (10 * log10(Power)), floored at -200 dB */
+	Decibels = 1 << 4
+};
+ENUM_CLASS_FLAGS(EFFTOutputs);
+
 struct FFTStateStruct
 {
 	int64 NFFT;
@@ -36,4 +61,46 @@ public:
 	static FFTStateStruct* PerformFFTAlloc(int64 NFFT, int64 Inverse_FFT, void* MemoryPtr, int64* MemoryLength);
 	
 	static void PerformFFTStride(FFTStateStruct* FFTState, const FFTComplexSamples* SamplesIn, FFTComplexSamples* SamplesOut, int64 Stride);
+
+	/**
+	 * Get the smallest FFT size >= the given size that only has the factors 2, 3 and 5, which are handled by the specialized butterflies
+	 *
+	 * @param Size The minimum FFT size
+	 * @return The fast FFT size
+	 */
+	static int64 GetNextFastSize(int64 Size);
+
+	/**
+	 * Get the center frequency of an FFT bin
+	 *
+	 * @param Bin The bin index
+	 * @param FFTSize The FFT size, including any zero-padding
+	 * @param SampleRate The sample rate of the analyzed audio
+	 * @return The bin frequency in Hz
+	 */
+	static float GetBinFrequency(int64 Bin, int64 FFTSize, int32 SampleRate);
+
+	/**
+	 * Multiply the audio frames by the window and pack them as the real parts of the FFT input, in a single vectorized pass
+	 *
+	 * @param AudioFrames The audio frames
+	 * @param Window The window, of the same size as the audio frames
+	 * @param FrameSize The number of audio frames
+	 * @param SamplesOut The FFT input, with the imaginary parts set to zero
+	 */
+	static void WindowAndPack(const float* AudioFrames, const float* Window, int64 FrameSize, FFTComplexSamples* SamplesOut);
+
+	/**
+	 * Unpack the FFT output and calculate the spectra of the first bins, in a single vectorized pass. Any output may be nullptr to skip it
+	 *
+	 * @param Samples The FFT output
+	 * @param FrameSize The number of FFT output samples
+	 * @param OutReal The real parts of all FrameSize samples
+	 * @param OutImaginary The imaginary parts of all FrameSize samples
+	 * @param NumBins The number of bins the spectra are calculated for, at most FrameSize
+	 * @param OutMagnitude The magnitude spectrum
+	 * @param OutPower The power (squared magnitude) spectrum
+	 * @param OutDecibels The power spectrum in decibels, floored at -200 dB
+	 */
+	static void UnpackSpectrum(const FFTComplexSamples* Samples, int64 FrameSize, float* OutReal, float* OutImaginary, int64 NumBins, float* OutMagnitude, float* OutPower, float* OutDecibels);
 };
@@ -0,0 +1,228 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "UObject/Object.h"
+#include "LoudnessAnalysis.generated.h"
+
+class UImportedSoundWave;
+
+/**
+ * Loudness statistics of a whole sound wave
+ */
+USTRUCT(BlueprintType, Category = "Loudness Analysis")
+struct AUDIOANALYSISTOOLS_API FLoudnessStatistics
+{
+	GENERATED_BODY()
+
+	FLoudnessStatistics()
+		: IntegratedLoudness(0),
+		  MaxMomentaryLoudness(0),
+		  MaxShortTermLoudness(0)
+	{
+	}
+
+	/** The gated loudness over the whole duration, in LUFS */
+	UPROPERTY(BlueprintReadOnly, Category = "Loudness Analysis")
+	float IntegratedLoudness;
+
+	/** The largest loudness over 400 ms, in LUFS */
+	UPROPERTY(BlueprintReadOnly, Category = "Loudness Analysis")
+	float MaxMomentaryLoudness;
+
+	/** The largest loudness over 3 s, in LUFS */
+	UPROPERTY(BlueprintReadOnly, Category = "Loudness Analysis")
+	float MaxShortTermLoudness;
+};
+
+/**
+ * Coefficients of a biquad filter, normalized so that a0 is 1
+ */
+struct FLoudnessBiquadCoefficients
+{
+	double B0 = 1;
+	double B1 = 0;
+	double B2 = 0;
+	double A1 = 0;
+	double A2 = 0;
+};
+
+/**
+ * Histogram of the 400 ms gating block energies, used for the gated integrated loudness
+ * Adding a block costs O(1) and the integrated loudness is read in a number of steps that depends only on the histogram resolution, not on the number of blocks
+ */
+class AUDIOANALYSISTOOLS_API FLoudnessGatingHistogram
+{
+public:
+	FLoudnessGatingHistogram();
+
+	/** Remove all blocks */
+	void Reset();
+
+	/**
+	 * Add a gating block. Blocks below the absolute gate are ignored
+	 *
+	 * @param Energy The channel-weighted mean square of the block
+	 */
+	void Add(double Energy);
+
+	/**
+	 * Get the integrated loudness, gated with the absolute and the relative gate
+	 * @return The integrated loudness in LUFS, or the silence loudness if no block passed the absolute gate
+	 */
+	float GetIntegratedLoudness() const;
+
+private:
+	/** The number of blocks in each bin */
+	TArray64<int64> BinCounts;
+
+	/** The summed energy of the blocks in each bin, so the result does not depend on the bin width apart from the bin the relative gate falls into */
+	TArray64<double> BinEnergies;
+
+	/** The number of blocks above the absolute gate */
+	int64 NumBlocks;
+
+	/** The summed energy of the blocks above the absolute gate */
+	double TotalEnergy;
+};
+
+/**
+ * Loudness meter following ITU-R BS.1770 / EBU R128
+ * The audio is K-weighted, the weighted energy is accumulated into 100 ms blocks, and the momentary (400 ms), short-term (3 s) and gated integrated loudness are derived from them
+ * Silence is reported as -144 LUFS
+ */
+UCLASS(BlueprintType, Category = "Loudness Analysis")
+class AUDIOANALYSISTOOLS_API ULoudnessAnalysis : public UObject
+{
+	GENERATED_BODY()
+
+	ULoudnessAnalysis();
+
+public:
+	/**
+	 * Instantiates a Loudness Analysis object
+	 * @return The LoudnessAnalysis object
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Loudness Analysis|Main")
+	static ULoudnessAnalysis* CreateLoudnessAnalysis();
+
+	/**
+	 * Clear the filter states and all measured loudness, e.g. to start a new integrated measurement
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Loudness Analysis|Main")
+	void Reset();
+
+	/**
+	 * Process the next block of audio. Changing the number of channels or the sample rate resets the measurement
+	 *
+	 * @param AudioFrames An array containing interleaved audio frames in 32-bit float PCM format
+	 * @param NumChannels The number of interleaved channels. Six channels are treated as 5.1 (L, R, C, LFE, Ls, Rs)
+	 * @param SampleRate The sample rate of the audio
+	 * @return Whether the audio was processed successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Loudness Analysis|Main")
+	bool ProcessAudioFrames(const TArray<float>& AudioFrames, int32 NumChannels = 1, int32 SampleRate = 44100);
+
+	/**
+	 * Process the next block of audio. Suitable for use with 64-bit data size
+	 *
+	 * @param AudioFrames A view of interleaved audio frames in 32-bit float PCM format
+	 * @param NumChannels The number of interleaved channels. Six channels are treated as 5.1 (L, R, C, LFE, Ls, Rs)
+	 * @param SampleRate The sample rate of the audio
+	 * @return Whether the audio was processed successfully or not
+	 */
+	bool ProcessAudioFrames(TArrayView64<const float> AudioFrames, int32 NumChannels = 1, int32 SampleRate = 44100);
+
+	/**
+	 * Get the loudness of the last 400 ms
+	 * @return The momentary loudness in LUFS
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Loudness Analysis|Main")
+	float GetMomentaryLoudness() const { return MomentaryLoudness; }
+
+	/**
+	 * Get the loudness of the last 3 s
+	 * @return The short-term loudness in LUFS
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Loudness Analysis|Main")
+	float GetShortTermLoudness() const { return ShortTermLoudness; }
+
+	/**
+	 * Get the gated loudness of everything processed since the last reset
+	 * @return The integrated loudness in LUFS
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Loudness Analysis|Main")
+	float GetIntegratedLoudness() const;
+
+	/**
+	 * Get the largest momentary loudness since the last reset
+	 * @return The max momentary loudness in LUFS
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Loudness Analysis|Main")
+	float GetMaxMomentaryLoudness() const { return MaxMomentaryLoudness; }
+
+	/**
+	 * Measure the loudness of the whole imported sound wave. The audio is split into chunks analyzed in parallel, each one starting with a short filter warm-up
+	 *
+	 * @param ImportedSoundWave The sound wave to measure
+	 * @param Statistics The measured loudness statistics
+	 * @return Whether the sound wave was measured successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Loudness Analysis|Main")
+	static bool AnalyzeImportedSoundWave(UImportedSoundWave* ImportedSoundWave, FLoudnessStatistics& Statistics);
+
+protected:
+	/** Reset the measurement and recalculate the filters for the channel layout and sample rate */
+	void Configure(int32 InNumChannels, int32 InSampleRate);
+
+	/** Complete the current 100 ms block and update the loudness values */
+	void FinishBlock();
+
+	/** The number of interleaved channels */
+	int32 NumChannels;
+
+	/** The sample rate the filters were calculated for */
+	int32 SampleRate;
+
+	/** The number of frames in a 100 ms block */
+	int64 FramesPerBlock;
+
+	/** The number of frames accumulated in the current block */
+	int64 NumBlockFrames;
+
+	/** The K-weighting high shelf (first stage) */
+	FLoudnessBiquadCoefficients ShelfCoefficients;
+
+	/** The K-weighting high pass (second stage) */
+	FLoudnessBiquadCoefficients HighPassCoefficients;
+
+	/** The filter states, four per channel (two per stage) */
+	TArray<double> FilterStates;
+
+	/** The weight of each channel in the summed energy */
+	TArray<float> ChannelWeights;
+
+	/** The summed squares of the weighted audio of each channel in the current block */
+	TArray<double> BlockChannelSums;
+
+	/** Ring of the channel-weighted mean squares of the last 30 blocks (3 s) */
+	TArray<double> BlockEnergies;
+
+	/** The position the next block energy will be written to */
+	int32 BlockPosition;
+
+	/** The number of completed blocks */
+	int64 NumBlocks;
+
+	/** The loudness of the last 400 ms, in LUFS */
+	float MomentaryLoudness;
+
+	/** The loudness of the last 3 s, in LUFS */
+	float ShortTermLoudness;
+
+	/** The largest momentary loudness since the last reset, in LUFS */
+	float MaxMomentaryLoudness;
+
+	/** The gating blocks since the last reset */
+	FLoudnessGatingHistogram GatingHistogram;
+};
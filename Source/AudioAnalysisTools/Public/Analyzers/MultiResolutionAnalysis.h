@@ -0,0 +1,295 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "UObject/Object.h"
+#include "HAL/CriticalSection.h"
+#include "Analyzers/CoreTimeDomainFeatures.h"
+#include "Analyzers/FFTAudioAnalyzer.h"
+#include "Analyzers/PolyphaseDecimator.h"
+#include "WindowsLibrary.h"
+#include "MultiResolutionAnalysis.generated.h"
+
+/**
+ * A single resolution of the multi-resolution analysis
+ */
+USTRUCT(BlueprintType, Category = "Multi-Resolution Analysis")
+struct AUDIOANALYSISTOOLS_API FAnalysisResolution
+{
+	GENERATED_BODY()
+
+	FAnalysisResolution()
+		: FrameSize(1024),
+		  HopSize(512),
+		  Decimation(EAudioDecimationFactor::None)
+	{
+	}
+
+	/** The number of (decimated) audio frames each FFT is performed on */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Multi-Resolution Analysis")
+	int64 FrameSize;
+
+	/** The number of (decimated) audio frames between the starts of consecutive analysis frames */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Multi-Resolution Analysis")
+	int64 HopSize;
+
+	/** The decimation applied before the FFT. Resolutions with the same decimation share the decimated audio */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Multi-Resolution Analysis")
+	EAudioDecimationFactor Decimation;
+};
+
+/**
+ * Delegate called on the processing thread for each analysis frame of each resolution
+ * Receives the resolution index and the timestamp of the analysis frame start, in seconds since the last reset
+ */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnMultiResolutionFrameNative, int32, double);
+
+/**
+ * Multi-resolution analysis of a single input stream
+ * The input is processed once: each distinct decimation factor decimates it once into a shared buffer, and every resolution performs its FFT over that buffer at its own hop size
+ * Windows are shared through the window cache, so resolutions of the same frame size use the same window
+ */
+UCLASS(BlueprintType, Category = "Multi-Resolution Analysis")
+class AUDIOANALYSISTOOLS_API UMultiResolutionAnalysis : public UObject
+{
+	GENERATED_BODY()
+
+	UMultiResolutionAnalysis();
+
+public:
+	//~ Begin UObject Interface
+	virtual void BeginDestroy() override;
+	//~ End UObject Interface
+
+	/**
+	 * Instantiates a Multi-Resolution Analysis object
+	 *
+	 * @param Resolutions The resolutions to analyze, addressed by their index
+	 * @param WindowType The type of window function used by all resolutions
+	 * @return The MultiResolutionAnalysis object
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Main")
+	static UMultiResolutionAnalysis* CreateMultiResolutionAnalysis(const TArray<FAnalysisResolution>& Resolutions, EAnalysisWindowType WindowType = EAnalysisWindowType::HanningWindow);
+
+	/**
+	 * Update the analyzed resolutions. Resets the analysis
+	 *
+	 * @param Resolutions The resolutions to analyze, addressed by their index
+	 * @param WindowType The type of window function used by all resolutions
+	 * @return Whether the resolutions were updated successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Update")
+	bool UpdateParameters(const TArray<FAnalysisResolution>& Resolutions, EAnalysisWindowType WindowType = EAnalysisWindowType::HanningWindow);
+
+	/**
+	 * Clear the buffered audio, the filter states and all analysis results
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Main")
+	void Reset();
+
+	/**
+	 * Process the next block of mono audio. Each resolution analyzes every analysis frame completed by the block. Changing the sample rate resets the analysis
+	 *
+	 * @param AudioFrames An array containing audio frames in 32-bit float PCM format
+	 * @param SampleRate The sample rate of the audio
+	 * @return Whether the audio was processed successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Main")
+	bool ProcessAudioFrames(const TArray<float>& AudioFrames, int32 SampleRate = 44100);
+
+	/**
+	 * Process the next block of mono audio. Suitable for use with 64-bit data size
+	 *
+	 * @param AudioFrames A view of audio frames in 32-bit float PCM format
+	 * @param SampleRate The sample rate of the audio
+	 * @return Whether the audio was processed successfully or not
+	 */
+	bool ProcessAudioFrames(TArrayView64<const float> AudioFrames, int32 SampleRate = 44100);
+
+	/**
+	 * Get the number of analyzed resolutions
+	 * @return The number of resolutions
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Main")
+	int32 GetNumResolutions() const;
+
+	/**
+	 * Get the number of analysis frames the resolution has processed since the last reset. Can be compared between calls to detect new frames
+	 *
+	 * @param ResolutionIndex The resolution index
+	 * @return The number of processed analysis frames
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Main")
+	int64 GetNumProcessedFrames(int32 ResolutionIndex) const;
+
+	/**
+	 * Get the start of the latest analysis frame of the resolution
+	 *
+	 * @param ResolutionIndex The resolution index
+	 * @return The timestamp in seconds since the last reset
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Main")
+	float GetFrameTimestamp(int32 ResolutionIndex) const;
+
+	/**
+	 * Get the start of the latest analysis frame of the resolution in double precision
+	 *
+	 * @param ResolutionIndex The resolution index
+	 * @return The timestamp in seconds since the last reset
+	 */
+	double GetPreciseFrameTimestamp(int32 ResolutionIndex) const;
+
+	/**
+	 * Get the magnitude spectrum of the latest analysis frame of the resolution
+	 *
+	 * @param ResolutionIndex The resolution index
+	 * @return The magnitude spectrum
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Main")
+	TArray<float> GetMagnitudeSpectrum(int32 ResolutionIndex) const;
+
+	/**
+	 * Copy the magnitude spectrum of the latest analysis frame of the resolution into the given array without reallocating it when its size already matches
+	 *
+	 * @param ResolutionIndex The resolution index
+	 * @param Spectrum The array to fill
+	 * @return Whether the array was filled successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Main")
+	bool FillMagnitudeSpectrum(int32 ResolutionIndex, UPARAM(ref) TArray<float>& Spectrum) const;
+
+	/**
+	 * Read the magnitude spectrum of the latest analysis frame of the resolution while the analysis is locked. Suitable for use with 64-bit data size
+	 *
+	 * @param ResolutionIndex The resolution index
+	 * @param Reader Called with the magnitude spectrum, unless the index is invalid
+	 */
+	void ReadMagnitudeSpectrum(int32 ResolutionIndex, TFunctionRef<void(const TArray64<float>&)> Reader) const;
+
+	/**
+	 * Get the time domain features of the latest (decimated) analysis frame of the resolution
+	 *
+	 * @param ResolutionIndex The resolution index
+	 * @return The time domain frame statistics
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Main")
+	FTimeDomainFrameStats GetFrameStats(int32 ResolutionIndex) const;
+
+	/**
+	 * Get the half wave rectified spectral flux between the latest two analysis frames of the resolution, suitable for transient detection at short frame sizes
+	 *
+	 * @param ResolutionIndex The resolution index
+	 * @return The spectral flux
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Main")
+	float GetSpectralFlux(int32 ResolutionIndex) const;
+
+	/**
+	 * Get the sample rate the resolution is analyzed at, after decimation
+	 *
+	 * @param ResolutionIndex The resolution index
+	 * @return The sample rate
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Main")
+	int32 GetResolutionSampleRate(int32 ResolutionIndex) const;
+
+	/**
+	 * Get the center frequency of a bin of the magnitude spectrum of the resolution
+	 *
+	 * @param ResolutionIndex The resolution index
+	 * @param Bin The bin index
+	 * @return The bin frequency in Hz
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Multi-Resolution Analysis|Main")
+	float GetBinFrequency(int32 ResolutionIndex, int64 Bin) const;
+
+	/** Called on the processing thread, with the analysis locked, for each analysis frame of each resolution */
+	FOnMultiResolutionFrameNative OnFrameNative;
+
+protected:
+	/** The audio of a single decimation factor, shared by all resolutions using it */
+	struct FDecimatedStream
+	{
+		/** Decimates the input, keeping its filter state across blocks */
+		FPolyphaseDecimator Decimator;
+
+		/** The buffered decimated audio still needed by at least one resolution, followed by unused space. Only grows, so blocks of a constant size do not allocate */
+		TArray64<float> Samples;
+
+		/** The number of buffered samples */
+		int64 NumSamples = 0;
+
+		/** The decimated audio of the block being processed */
+		TArray64<float> NewSamples;
+
+		/** The absolute index of the first buffered sample */
+		int64 FirstSampleIndex = 0;
+	};
+
+	/** The state of a single resolution */
+	struct FResolutionState
+	{
+		/** The resolution parameters */
+		FAnalysisResolution Resolution;
+
+		/** The index of the decimated stream the resolution reads from */
+		int32 StreamIndex = 0;
+
+		/** The window function, shared through the window cache */
+		TSharedPtr<const FAnalysisWindow, ESPMode::ThreadSafe> Window;
+
+		/** FFT configuration */
+		FFTStateStruct* FFTConfiguration = nullptr;
+
+		/** FFT input samples */
+		TArray64<FFTComplexSamples> FFTInput;
+
+		/** FFT output samples */
+		TArray64<FFTComplexSamples> FFTOutput;
+
+		/** The magnitude spectrum of the latest analysis frame */
+		TArray64<float> MagnitudeSpectrum;
+
+		/** The magnitude spectrum of the previous analysis frame */
+		TArray64<float> PreviousMagnitudeSpectrum;
+
+		/** The absolute decimated sample index the next analysis frame ends at */
+		int64 NextFrameEnd = 0;
+
+		/** The number of analysis frames processed since the last reset */
+		int64 NumProcessedFrames = 0;
+
+		/** The start of the latest analysis frame, in seconds since the last reset */
+		double FrameTimestamp = 0;
+
+		/** Time domain features of the latest analysis frame */
+		FTimeDomainFrameStats FrameStats;
+
+		/** The half wave rectified spectral flux of the latest analysis frame */
+		float SpectralFlux = 0;
+	};
+
+	/**
+	 * Analyze a single analysis frame of a resolution
+	 *
+	 * @param State The resolution state
+	 * @param ResolutionIndex The resolution index
+	 * @param Frames The decimated audio frames of the analysis frame
+	 */
+	void AnalyzeFrame(FResolutionState& State, int32 ResolutionIndex, const float* Frames);
+
+	/** Free the FFT configurations of all resolutions */
+	void FreeFFTConfigurations();
+
+	/** The decimated streams, one per distinct decimation factor */
+	TArray<FDecimatedStream> Streams;
+
+	/** The resolution states */
+	TArray<FResolutionState> States;
+
+	/** The sample rate of the processed audio */
+	int32 SampleRate;
+
+	/** Data guard (mutex) for thread safety */
+	mutable FCriticalSection DataGuard;
+};
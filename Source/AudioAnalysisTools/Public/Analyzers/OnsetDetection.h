@@ -3,8 +3,68 @@
 #pragma once
 
 #include "UObject/Object.h"
+#include "Analyzers/CoreTimeDomainFeatures.h"
+#include "Analyzers/SignalHistory.h"
 #include "OnsetDetection.generated.h"
 
+/**
+ * Onset detection functions calculated by the combined onset pass
+ */
+UENUM(BlueprintType, Category = "Onset Detection")
+enum class EOnsetDetectionFunction : uint8
+{
+	EnergyEnvelope,
+	EnergyDifference,
+	SpectralDifference,
+	SpectralDifferenceHWR,
+	ComplexSpectralDifference,
+	HighFrequencyContent,
+	Count UMETA(Hidden)
+};
+
+/**
+ * Onset detection function values of a single frame, computed together in one pass
+ */
+USTRUCT(BlueprintType, Category = "Onset Detection")
+struct AUDIOANALYSISTOOLS_API FOnsetDetectionValues
+{
+	GENERATED_BODY()
+
+	FOnsetDetectionValues()
+		: EnergyEnvelope(0),
+		  EnergyDifference(0),
+		  SpectralDifference(0),
+		  SpectralDifferenceHWR(0),
+		  ComplexSpectralDifference(0),
+		  HighFrequencyContent(0)
+	{
+	}
+
+	/** The sum of the squared audio frames */
+	UPROPERTY(BlueprintReadOnly, Category = "Onset Detection")
+	float EnergyEnvelope;
+
+	/** The positive change of the energy envelope from the previous frame */
+	UPROPERTY(BlueprintReadOnly, Category = "Onset Detection")
+	float EnergyDifference;
+
+	/** The sum of the absolute magnitude changes from the previous frame */
+	UPROPERTY(BlueprintReadOnly, Category = "Onset Detection")
+	float SpectralDifference;
+
+	/** The sum of the positive magnitude changes from the previous frame */
+	UPROPERTY(BlueprintReadOnly, Category = "Onset Detection")
+	float SpectralDifferenceHWR;
+
+	/** The complex spectral difference from the prediction based on the two previous frames */
+	UPROPERTY(BlueprintReadOnly, Category = "Onset Detection")
+	float ComplexSpectralDifference;
+
+	/** The magnitudes weighted by their bin index */
+	UPROPERTY(BlueprintReadOnly, Category = "Onset Detection")
+	float HighFrequencyContent;
+};
+
 /**
  * Provides various functions to detect onset
  */
@@ -77,6 +137,14 @@ public:
 	 */
 	float GetEnergyDifference(const TArray64<float>& AudioFrames);
 
+	/**
+	 * Calculate the energy difference between the current and previous energy sum, reusing the energy of already computed frame stats
+	 *
+	 * @param FrameStats The time domain features of the audio frame, e.g. from UCoreTimeDomainFeatures::GetFrameStats
+	 * @return The energy difference onset detection function sample for the frame
+	 */
+	float GetEnergyDifference(const FTimeDomainFrameStats& FrameStats);
+
 	/**
 	 * Calculate the spectral difference between the current and the previous magnitude spectrum
 	 *
@@ -133,6 +201,30 @@ public:
 	 */
 	float GetComplexSpectralDifference(const TArray64<float>& FFTReal, const TArray64<float>& FFTImaginary);
 
+	/**
+	 * Calculate the complex spectral difference from the real and imaginary parts of the FFT, optimized for real input
+	 * Only the non-redundant N / 2 + 1 bins are processed, and polynomial approximations are used instead of atan2 and sin (phase error below 2e-6 rad per bin, sine error below 3.6e-6)
+	 * The result is about half the value of GetComplexSpectralDifference, since the mirrored upper half of the spectrum is not summed. Keeps its own history, separate from GetComplexSpectralDifference
+	 *
+	 * @param FFTReal An array containing the real part of the FFT
+	 * @param FFTImaginary An array containing the imaginary part of the FFT
+	 * @param MagnitudeSpectrum An array containing the magnitude spectrum of the same FFT, reused instead of recomputing the magnitudes. May be empty
+	 * @return The complex spectral difference onset detection function sample
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Detection")
+	float GetComplexSpectralDifferenceFast(const TArray<float>& FFTReal, const TArray<float>& FFTImaginary, const TArray<float>& MagnitudeSpectrum);
+
+	/**
+	 * Calculate the complex spectral difference from the real and imaginary parts of the FFT, optimized for real input
+	 * Suitable for use with 64-bit data size
+	 *
+	 * @param FFTReal An array containing the real part of the FFT
+	 * @param FFTImaginary An array containing the imaginary part of the FFT
+	 * @param MagnitudeSpectrum An array containing the magnitude spectrum of the same FFT, reused instead of recomputing the magnitudes. May be empty
+	 * @return The complex spectral difference onset detection function sample
+	 */
+	float GetComplexSpectralDifferenceFast(const TArray64<float>& FFTReal, const TArray64<float>& FFTImaginary, const TArray64<float>& MagnitudeSpectrum);
+
 	/**
 	 * Calculate the high frequency content onset detection function from the magnitude spectrum
 	 *
@@ -151,6 +243,114 @@ public:
 	 */
 	static float GetHighFrequencyContent(const TArray64<float>& MagnitudeSpectrum);
 
+	/**
+	 * Calculate all onset detection functions of the frame in a single pass over the non-redundant N / 2 + 1 bins
+	 * Uses its own history shared between the functions, so it does not interfere with the individual onset functions above. The result is cached until the next call
+	 *
+	 * @param AudioFrames An array containing the audio frame in 32-bit float PCM format (for the energy functions)
+	 * @param FFTReal An array containing the real part of the FFT of the frame
+	 * @param FFTImaginary An array containing the imaginary part of the FFT of the frame
+	 * @param MagnitudeSpectrum An array containing the magnitude spectrum of the same FFT, reused instead of recomputing the magnitudes. May be empty
+	 * @param bFastComplexSpectralDifference Whether to use the polynomial approximations of GetComplexSpectralDifferenceFast for the phase or not
+	 * @param Timestamp The time of the frame in seconds, stored in the history. Negative values use the number of processed frames instead
+	 * @return The onset detection function values of the frame
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Detection")
+	FOnsetDetectionValues ProcessFrame(const TArray<float>& AudioFrames, const TArray<float>& FFTReal, const TArray<float>& FFTImaginary, const TArray<float>& MagnitudeSpectrum, bool bFastComplexSpectralDifference = true, float Timestamp = -1);
+
+	/**
+	 * Calculate all onset detection functions of the frame in a single pass over the non-redundant N / 2 + 1 bins
+	 * Suitable for use with 64-bit data size
+	 *
+	 * @param AudioFrames An array containing the audio frame in 32-bit float PCM format (for the energy functions)
+	 * @param FFTReal An array containing the real part of the FFT of the frame
+	 * @param FFTImaginary An array containing the imaginary part of the FFT of the frame
+	 * @param MagnitudeSpectrum An array containing the magnitude spectrum of the same FFT, reused instead of recomputing the magnitudes. May be empty
+	 * @param bFastComplexSpectralDifference Whether to use the polynomial approximations of GetComplexSpectralDifferenceFast for the phase or not
+	 * @param Timestamp The time of the frame in seconds, stored in the history. Negative values use the number of processed frames instead
+	 * @return The onset detection function values of the frame
+	 */
+	const FOnsetDetectionValues& ProcessFrame(const TArray64<float>& AudioFrames, const TArray64<float>& FFTReal, const TArray64<float>& FFTImaginary, const TArray64<float>& MagnitudeSpectrum, bool bFastComplexSpectralDifference = true, double Timestamp = -1);
+
+	/**
+	 * Calculate all onset detection functions of the frame in a single pass over the non-redundant N / 2 + 1 bins, reusing the energy of already computed frame stats
+	 *
+	 * @param FrameStats The time domain features of the audio frame, e.g. from UCoreTimeDomainFeatures::GetFrameStats
+	 * @param FFTReal An array containing the real part of the FFT of the frame
+	 * @param FFTImaginary An array containing the imaginary part of the FFT of the frame
+	 * @param MagnitudeSpectrum An array containing the magnitude spectrum of the same FFT, reused instead of recomputing the magnitudes. May be empty
+	 * @param bFastComplexSpectralDifference Whether to use the polynomial approximations of GetComplexSpectralDifferenceFast for the phase or not
+	 * @param Timestamp The time of the frame in seconds, stored in the history. Negative values use the number of processed frames instead
+	 * @return The onset detection function values of the frame
+	 */
+	const FOnsetDetectionValues& ProcessFrame(const FTimeDomainFrameStats& FrameStats, const TArray64<float>& FFTReal, const TArray64<float>& FFTImaginary, const TArray64<float>& MagnitudeSpectrum, bool bFastComplexSpectralDifference = true, double Timestamp = -1);
+
+	/**
+	 * Get the onset detection function values calculated by the last ProcessFrame call
+	 * @return The onset detection function values of the last processed frame
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Detection")
+	FOnsetDetectionValues GetFrameValues() const { return FrameValues; }
+
+	/**
+	 * Keep a timestamped history of each onset detection function calculated by ProcessFrame. Clears the existing history
+	 *
+	 * @param Capacity The maximum number of frames kept per function
+	 * @param WindowDuration The duration the history aggregates (max, mean, count above threshold) are calculated over, in seconds
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Detection|History")
+	void EnableHistory(int64 Capacity = 512, float WindowDuration = 1.f);
+
+	/**
+	 * Stop keeping the history and free it
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Detection|History")
+	void DisableHistory();
+
+	/**
+	 * Update the threshold the values of the onset detection function are counted above. Clears the history of the function
+	 *
+	 * @param Function The onset detection function
+	 * @param Threshold The threshold
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Detection|History")
+	void UpdateHistoryThreshold(EOnsetDetectionFunction Function, float Threshold);
+
+	/**
+	 * Get the maximum value of the onset detection function over the history window
+	 *
+	 * @param Function The onset detection function
+	 * @return The maximum value, or 0 if the history is empty
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Detection|History")
+	float GetHistoryMax(EOnsetDetectionFunction Function) const;
+
+	/**
+	 * Get the mean value of the onset detection function over the history window
+	 *
+	 * @param Function The onset detection function
+	 * @return The mean value, or 0 if the history is empty
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Detection|History")
+	float GetHistoryMean(EOnsetDetectionFunction Function) const;
+
+	/**
+	 * Get the number of values of the onset detection function above its threshold over the history window
+	 *
+	 * @param Function The onset detection function
+	 * @return The number of values above the threshold
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Detection|History")
+	int64 GetHistoryCountAboveThreshold(EOnsetDetectionFunction Function) const;
+
+	/**
+	 * Get the history of the onset detection function, for zero-copy lookback reads
+	 *
+	 * @param Function The onset detection function
+	 * @return The history
+	 */
+	const FSignalHistory& GetHistory(EOnsetDetectionFunction Function) const { return FrameHistories[static_cast<int32>(Function)]; }
+
 private:
 	/**
 	 * Set phase values between [-pi:pi] range
@@ -193,5 +393,35 @@ private:
 	/** An array containing the previous magnitude spectrum passed to the last complex spectral difference call */
 	TArray64<float> PrevMagnitudeSpectrum_ComplexSpectralDifference;
 
+	/** An array containing the previous phase spectrum (N / 2 + 1 bins) passed to the last fast complex spectral difference call */
+	TArray64<float> PrevPhaseSpectrum_ComplexSpectralDifferenceFast;
+
+	/** An array containing the second previous phase spectrum (N / 2 + 1 bins) passed to the last fast complex spectral difference call */
+	TArray64<float> PrevPhaseSpectrum2_ComplexSpectralDifferenceFast;
+
+	/** An array containing the previous magnitude spectrum (N / 2 + 1 bins) passed to the last fast complex spectral difference call */
+	TArray64<float> PrevMagnitudeSpectrum_ComplexSpectralDifferenceFast;
+
+	/** The onset detection function values of the last ProcessFrame call */
+	FOnsetDetectionValues FrameValues;
+
+	/** The energy envelope of the previous ProcessFrame call */
+	float PreviousFrameEnergy;
+
+	/** The number of ProcessFrame calls, used as the timestamp when none is given */
+	int64 NumProcessedFrames;
+
+	/** The history of each onset detection function calculated by ProcessFrame. Disabled unless EnableHistory is called */
+	FSignalHistory FrameHistories[static_cast<int32>(EOnsetDetectionFunction::Count)];
+
+	/** The magnitude spectrum (N / 2 + 1 bins) of the previous ProcessFrame call, shared by all spectral functions */
+	TArray64<float> PrevMagnitudeSpectrum_Frame;
+
+	/** The phase spectrum (N / 2 + 1 bins) of the previous ProcessFrame call */
+	TArray64<float> PrevPhaseSpectrum_Frame;
+
+	/** The phase spectrum (N / 2 + 1 bins) of the second previous ProcessFrame call */
+	TArray64<float> PrevPhaseSpectrum2_Frame;
+
 	int64 FrameSize;
 };
@@ -0,0 +1,164 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "UObject/Object.h"
+#include "Analyzers/SlidingMedian.h"
+#include "HAL/CriticalSection.h"
+#include "OnsetPeakPicker.generated.h"
+
+/**
+ * Onset picked from an onset detection function
+ */
+USTRUCT(BlueprintType, Category = "Onset Peak Picker")
+struct AUDIOANALYSISTOOLS_API FOnsetEvent
+{
+	GENERATED_BODY()
+
+	FOnsetEvent()
+		: Timestamp(0),
+		  Strength(0)
+	{
+	}
+
+	FOnsetEvent(float InTimestamp, float InStrength)
+		: Timestamp(InTimestamp),
+		  Strength(InStrength)
+	{
+	}
+
+	/** The time of the frame the onset was picked at, in seconds */
+	UPROPERTY(BlueprintReadOnly, Category = "Onset Peak Picker")
+	float Timestamp;
+
+	/** The onset detection function value at the onset */
+	UPROPERTY(BlueprintReadOnly, Category = "Onset Peak Picker")
+	float Strength;
+};
+
+/**
+ * Streaming onset peak picker with an adaptive threshold
+ * A value is picked as an onset if it is a local maximum within the lookahead, exceeds the moving median and mean of the recent values by a margin and is far enough from the previous onset
+ */
+UCLASS(BlueprintType, Category = "Onset Peak Picker")
+class AUDIOANALYSISTOOLS_API UOnsetPeakPicker : public UObject
+{
+	GENERATED_BODY()
+
+	UOnsetPeakPicker();
+
+public:
+	/**
+	 * Instantiates an Onset Peak Picker object
+	 *
+	 * @param WindowSize The number of recent values the adaptive threshold is calculated over
+	 * @param Lookahead The number of values after a candidate that must be processed before it is picked. Each value adds one frame of latency
+	 * @param MinInterOnsetInterval The minimum time between two onsets, in seconds
+	 * @param Delta The constant added to the adaptive threshold
+	 * @param MedianWeight The weight of the moving median in the adaptive threshold
+	 * @param MeanWeight The weight of the moving mean in the adaptive threshold
+	 * @return The OnsetPeakPicker object
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Peak Picker|Main")
+	static UOnsetPeakPicker* CreateOnsetPeakPicker(int64 WindowSize = 16, int64 Lookahead = 2, float MinInterOnsetInterval = 0.05f, float Delta = 0.05f, float MedianWeight = 1.f, float MeanWeight = 0.f);
+
+	/**
+	 * Update the peak picker parameters. Clears the processed values, but keeps the pending onset events
+	 *
+	 * @param WindowSize The number of recent values the adaptive threshold is calculated over
+	 * @param Lookahead The number of values after a candidate that must be processed before it is picked
+	 * @param MinInterOnsetInterval The minimum time between two onsets, in seconds
+	 * @param Delta The constant added to the adaptive threshold
+	 * @param MedianWeight The weight of the moving median in the adaptive threshold
+	 * @param MeanWeight The weight of the moving mean in the adaptive threshold
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Peak Picker|Update")
+	void UpdateParameters(int64 WindowSize = 16, int64 Lookahead = 2, float MinInterOnsetInterval = 0.05f, float Delta = 0.05f, float MedianWeight = 1.f, float MeanWeight = 0.f);
+
+	/**
+	 * Process the next onset detection function value (e.g. from GetSpectralDifferenceHWR, GetComplexSpectralDifference or GetHighFrequencyContent)
+	 *
+	 * @param OnsetValue The onset detection function value of the frame
+	 * @param Timestamp The time of the frame, in seconds
+	 * @return Whether an onset was picked by this call or not. The picked onset belongs to the frame Lookahead values earlier
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Peak Picker|Main")
+	bool ProcessOnsetValue(float OnsetValue, float Timestamp);
+
+	/**
+	 * Process the next onset detection function value. Suitable for long running streams, where the timestamps need double precision to space the onsets apart
+	 *
+	 * @param OnsetValue The onset detection function value of the frame
+	 * @param Timestamp The time of the frame, in seconds
+	 * @return Whether an onset was picked by this call or not. The picked onset belongs to the frame Lookahead values earlier
+	 */
+	bool ProcessOnsetValue(float OnsetValue, double Timestamp);
+
+	/**
+	 * Get the onset events picked since the last call and remove them from the queue. Thread safe
+	 *
+	 * @param OnsetEvents The picked onset events, in chronological order
+	 * @return Whether there were any onset events or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Peak Picker|Main")
+	bool ConsumeOnsetEvents(TArray<FOnsetEvent>& OnsetEvents);
+
+	/**
+	 * Get the adaptive threshold for the last candidate
+	 * @return The threshold value
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Onset Peak Picker|Main")
+	float GetThreshold() const { return Threshold; }
+
+protected:
+	/** Moving median and mean of the recent values */
+	FSlidingMedian SlidingMedian;
+
+	/** Ring of the last 2 * Lookahead + 1 values, used to check for the local maximum */
+	TArray64<float> RecentValues;
+
+	/** Timestamps of the values in RecentValues */
+	TArray64<double> RecentTimestamps;
+
+	/** The number of processed values, saturated to the size of RecentValues */
+	int64 NumRecentValues;
+
+	/** The position the next value will be written to in RecentValues */
+	int64 RecentPosition;
+
+	/** The number of values after a candidate that must be processed before it is picked */
+	int64 Lookahead;
+
+	/** The minimum time between two onsets, in seconds */
+	float MinInterOnsetInterval;
+
+	/** The constant added to the adaptive threshold */
+	float Delta;
+
+	/** The weight of the moving median in the adaptive threshold */
+	float MedianWeight;
+
+	/** The weight of the moving mean in the adaptive threshold */
+	float MeanWeight;
+
+	/** The adaptive threshold for the last candidate */
+	float Threshold;
+
+	/** The time of the last picked onset, in seconds */
+	double LastOnsetTimestamp;
+
+	/** Whether any onset was picked yet or not */
+	bool bHasPickedOnset;
+
+	/** Ring of the onset events not consumed yet. Grows up to the maximum number of pending events and is then overwritten from the oldest event */
+	TArray<FOnsetEvent> PendingEvents;
+
+	/** The position of the oldest pending event in PendingEvents */
+	int32 FirstPendingEvent;
+
+	/** The number of pending events */
+	int32 NumPendingEvents;
+
+	/** Guard for the pending onset events, which are usually consumed from a different thread than the one processing the values */
+	mutable FCriticalSection EventsGuard;
+};
@@ -0,0 +1,157 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "UObject/Object.h"
+#include "Analyzers/FFTAudioAnalyzer.h"
+#include "PitchDetection.generated.h"
+
+/**
+ * Pitch detection method
+ */
+UENUM(BlueprintType, Category = "Pitch Detection")
+enum class EPitchDetectionMethod : uint8
+{
+	/** McLeod Pitch Method, based on the normalized square difference function (NSDF) */
+	McLeod,
+
+	/** YIN, based on the cumulative mean normalized difference function */
+	Yin
+};
+
+/**
+ * Fundamental frequency (pitch) tracking for monophonic signals such as voice
+ * The autocorrelation is computed with a zero-padded FFT (power spectrum followed by an inverse FFT), so each frame costs O(N log N) instead of O(N^2)
+ */
+UCLASS(BlueprintType, Category = "Pitch Detection")
+class AUDIOANALYSISTOOLS_API UPitchDetection : public UObject
+{
+	GENERATED_BODY()
+
+	UPitchDetection();
+
+	//~ Begin UObject Interface
+	virtual void BeginDestroy() override;
+	//~ End UObject Interface
+
+public:
+	/**
+	 * Instantiates a Pitch Detection object
+	 *
+	 * @param Method The pitch detection method
+	 * @param MinFrequency The lowest detectable pitch, in Hz. The frame should be at least two periods of this frequency long
+	 * @param MaxFrequency The highest detectable pitch, in Hz
+	 * @param Threshold McLeod: the fraction of the highest NSDF peak a peak must reach to be selected (0.9 by default). YIN: the absolute threshold of the normalized difference (0.15 by default). Negative values use the default of the method
+	 * @return The PitchDetection object
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Pitch Detection|Main")
+	static UPitchDetection* CreatePitchDetection(EPitchDetectionMethod Method = EPitchDetectionMethod::McLeod, float MinFrequency = 60.f, float MaxFrequency = 1500.f, float Threshold = -1.f);
+
+	/**
+	 * Update the pitch detection parameters
+	 *
+	 * @param Method The pitch detection method
+	 * @param MinFrequency The lowest detectable pitch, in Hz
+	 * @param MaxFrequency The highest detectable pitch, in Hz
+	 * @param Threshold McLeod: the fraction of the highest NSDF peak a peak must reach to be selected (0.9 by default). YIN: the absolute threshold of the normalized difference (0.15 by default). Negative values use the default of the method
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Pitch Detection|Update")
+	void UpdateParameters(EPitchDetectionMethod Method = EPitchDetectionMethod::McLeod, float MinFrequency = 60.f, float MaxFrequency = 1500.f, float Threshold = -1.f);
+
+	/**
+	 * Process audio frames
+	 *
+	 * @param AudioFrames An array containing mono audio frames in 32-bit float PCM format (not windowed)
+	 * @param SampleRate The sample rate of the audio frames
+	 * @return Whether a pitch was detected or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Pitch Detection|Main")
+	bool ProcessAudioFrames(const TArray<float>& AudioFrames, int32 SampleRate = 44100);
+
+	/**
+	 * Process audio frames. Suitable for use with 64-bit data size
+	 *
+	 * @param AudioFrames An array containing mono audio frames in 32-bit float PCM format (not windowed)
+	 * @param SampleRate The sample rate of the audio frames
+	 * @return Whether a pitch was detected or not
+	 */
+	bool ProcessAudioFrames(const TArray64<float>& AudioFrames, int32 SampleRate = 44100);
+
+	/**
+	 * Get the pitch detected in the last processed frame
+	 * @return The fundamental frequency in Hz, or 0 if no pitch was detected
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Pitch Detection|Main")
+	float GetPitch() const { return Pitch; }
+
+	/**
+	 * Get the confidence of the pitch detected in the last processed frame
+	 * @return The confidence in the [0, 1] range (the height of the selected NSDF peak, or 1 minus the selected YIN difference)
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Pitch Detection|Main")
+	float GetConfidence() const { return Confidence; }
+
+protected:
+	/**
+	 * Reallocate the FFT plans and buffers if the padded size changes
+	 *
+	 * @param FrameSize The number of audio frames to process
+	 */
+	void UpdateFrameSize(int64 FrameSize);
+
+	/** Free the FFT plans */
+	void FreeFFT();
+
+	/**
+	 * Compute the autocorrelation of the audio frames into Autocorrelation through the FFT
+	 *
+	 * @param AudioFrames Pointer to the audio frames
+	 * @param NumFrames The number of audio frames
+	 */
+	void ComputeAutocorrelation(const float* AudioFrames, int64 NumFrames);
+
+	/** Select the pitch period from the NSDF stored in Autocorrelation */
+	bool SelectMcLeodPeriod(int64 MinLag, int64 MaxLag, float& OutPeriod, float& OutConfidence) const;
+
+	/** Select the pitch period from the cumulative mean normalized difference stored in Autocorrelation */
+	bool SelectYinPeriod(int64 MinLag, int64 MaxLag, float& OutPeriod, float& OutConfidence) const;
+
+	/** The pitch detection method */
+	EPitchDetectionMethod Method;
+
+	/** The lowest detectable pitch, in Hz */
+	float MinFrequency;
+
+	/** The highest detectable pitch, in Hz */
+	float MaxFrequency;
+
+	/** Peak selection threshold, see UpdateParameters */
+	float Threshold;
+
+	/** The pitch detected in the last processed frame, in Hz */
+	float Pitch;
+
+	/** The confidence of the pitch detected in the last processed frame */
+	float Confidence;
+
+	/** The number of audio frames the buffers were allocated for */
+	int64 FrameSize;
+
+	/** The zero-padded FFT size (at least 2 * FrameSize - 1, rounded up to a fast size) */
+	int64 PaddedSize;
+
+	/** Forward FFT plan, reused across frames */
+	FFTStateStruct* ForwardFFT;
+
+	/** Inverse FFT plan, reused across frames */
+	FFTStateStruct* InverseFFT;
+
+	/** FFT input buffer, reused across frames */
+	TArray64<FFTComplexSamples> FFTInput;
+
+	/** FFT output buffer, reused across frames */
+	TArray64<FFTComplexSamples> FFTOutput;
+
+	/** Autocorrelation of the last processed frame, later normalized in place into the NSDF or the YIN difference function */
+	TArray64<float> Autocorrelation;
+};
@@ -0,0 +1,77 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PolyphaseDecimator.generated.h"
+
+/**
+ * Factor the sample rate of audio is reduced by. The enum value is the base-2 logarithm of the factor
+ */
+UENUM(BlueprintType, Category = "Audio Analysis Tools")
+enum class EAudioDecimationFactor : uint8
+{
+	/** No decimation */
+	None = 0 UMETA(DisplayName = "None"),
+
+	/** Half the sample rate */
+	Two = 1 UMETA(DisplayName = "2x"),
+
+	/** A quarter of the sample rate */
+	Four = 2 UMETA(DisplayName = "4x"),
+
+	/** An eighth of the sample rate */
+	Eight = 3 UMETA(DisplayName = "8x")
+};
+
+/**
+ * Anti-aliased decimator for streamed mono audio
+ * A Kaiser-windowed sinc low pass is evaluated only at the retained output samples (one polyphase branch set per output), and the filter state is carried across blocks so consecutive blocks decimate seamlessly
+ */
+class AUDIOANALYSISTOOLS_API FPolyphaseDecimator
+{
+public:
+	FPolyphaseDecimator();
+
+	/**
+	 * Clear the filter state and design the low pass for the given factor
+	 *
+	 * @param Factor The decimation factor
+	 */
+	void Reset(EAudioDecimationFactor Factor);
+
+	/**
+	 * Decimate the next block of audio
+	 *
+	 * @param AudioFrames The audio frames in 32-bit float PCM format
+	 * @param OutDecimatedFrames The decimated audio frames. Blocks whose size is not a multiple of the factor produce one more or one less frame from time to time
+	 */
+	void Process(TArrayView64<const float> AudioFrames, TArray64<float>& OutDecimatedFrames);
+
+	/** Get the decimation factor */
+	EAudioDecimationFactor GetFactor() const { return Factor; }
+
+	/** Get the decimation factor as a number */
+	int32 GetFactorValue() const { return GetFactorValue(Factor); }
+
+	/**
+	 * Get the given decimation factor as a number
+	 *
+	 * @param Factor The decimation factor
+	 * @return The number the sample rate is divided by
+	 */
+	static int32 GetFactorValue(EAudioDecimationFactor Factor) { return 1 << static_cast<int32>(Factor); }
+
+private:
+	/** The decimation factor */
+	EAudioDecimationFactor Factor;
+
+	/** The low pass filter taps in reversed order, so each output is a forward dot product with the input history */
+	TArray64<float> ReversedTaps;
+
+	/** The last (number of taps - 1) input samples, followed by space for the block being processed */
+	TArray64<float> History;
+
+	/** The offset of the next retained sample from the start of the next block */
+	int64 NextOutputOffset;
+};
@@ -0,0 +1,131 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fixed-capacity history of a timestamped signal (e.g. an onset detection function)
+ * Aggregates over the values of the last WindowDuration seconds (max, mean and count above a threshold) are updated incrementally on each insertion, so reading them does not scan the history
+ */
+class AUDIOANALYSISTOOLS_API FSignalHistory
+{
+public:
+	FSignalHistory();
+
+	/**
+	 * Clear the history and set its parameters
+	 *
+	 * @param Capacity The maximum number of values kept. Zero disables the history
+	 * @param WindowDuration The duration the aggregates are calculated over, in seconds (or in values when the timestamps are value indices)
+	 * @param Threshold The threshold the values are counted above
+	 */
+	void Reset(int64 Capacity, double WindowDuration, float Threshold);
+
+	/** Clear the history, keeping its parameters */
+	void Clear();
+
+	/**
+	 * Add a value. If the timestamp goes backwards (e.g. after a seek), the history is cleared first
+	 *
+	 * @param Value The signal value
+	 * @param Timestamp The time of the value
+	 */
+	void Add(float Value, double Timestamp);
+
+	/** Whether the history is enabled (has a non-zero capacity) or not */
+	bool IsEnabled() const { return Values.Num() > 0; }
+
+	/** Get the number of stored values */
+	int64 Num() const { return NumValues; }
+
+	/** Get the maximum number of values kept */
+	int64 GetCapacity() const { return Values.Num(); }
+
+	/** Get the duration the aggregates are calculated over */
+	double GetWindowDuration() const { return WindowDuration; }
+
+	/** Get the threshold the values are counted above */
+	float GetThreshold() const { return Threshold; }
+
+	/** Get the maximum value within the aggregate window, or 0 if it is empty */
+	float GetWindowMax() const;
+
+	/** Get the mean value within the aggregate window, or 0 if it is empty */
+	float GetWindowMean() const;
+
+	/** Get the number of values above the threshold within the aggregate window */
+	int64 GetWindowCountAboveThreshold() const { return WindowCountAboveThreshold; }
+
+	/** Get the number of values within the aggregate window */
+	int64 GetWindowNum() const { return NumValues - (WindowStart - FirstIndex); }
+
+	/**
+	 * Get the value by age
+	 *
+	 * @param Age The age of the value, where 0 is the latest one. Must be less than Num()
+	 * @return The value
+	 */
+	float GetValue(int64 Age) const { return Values[ToSlot(FirstIndex + NumValues - 1 - Age)]; }
+
+	/**
+	 * Get the timestamp of the value by age
+	 *
+	 * @param Age The age of the value, where 0 is the latest one. Must be less than Num()
+	 * @return The timestamp
+	 */
+	double GetTimestamp(int64 Age) const { return Timestamps[ToSlot(FirstIndex + NumValues - 1 - Age)]; }
+
+	/**
+	 * Get the values of the last Duration seconds without copying. The values are split into two chronological views, since the history wraps around
+	 *
+	 * @param Duration The lookback duration. Negative values return the whole history
+	 * @param OutValues First and second views of the values, where the second one may be empty
+	 * @param OutTimestamps First and second views of the matching timestamps
+	 * @return The total number of values in both views
+	 */
+	int64 GetLookback(double Duration, TArrayView64<const float> OutValues[2], TArrayView64<const double> OutTimestamps[2]) const;
+
+private:
+	/** Convert an absolute value index into the ring slot */
+	int64 ToSlot(int64 Index) const { return Index % Values.Num(); }
+
+	/** Remove the oldest value from the aggregate window */
+	void PopWindowFront();
+
+	/** Ring of values, indexed by the absolute value index modulo the capacity */
+	TArray64<float> Values;
+
+	/** Ring of timestamps, matching the values */
+	TArray64<double> Timestamps;
+
+	/** Ring of absolute value indices with decreasing values, whose front is the maximum of the aggregate window */
+	TArray64<int64> MaxCandidates;
+
+	/** The ring position of the front of MaxCandidates */
+	int64 MaxCandidatesFront;
+
+	/** The number of entries in MaxCandidates */
+	int64 NumMaxCandidates;
+
+	/** The absolute index of the oldest stored value */
+	int64 FirstIndex;
+
+	/** The number of stored values */
+	int64 NumValues;
+
+	/** The absolute index of the oldest value within the aggregate window */
+	int64 WindowStart;
+
+	/** Running sum of the values within the aggregate window */
+	double WindowSum;
+
+	/** Running count of the values above the threshold within the aggregate window */
+	int64 WindowCountAboveThreshold;
+
+	/** The duration the aggregates are calculated over */
+	double WindowDuration;
+
+	/** The threshold the values are counted above */
+	float Threshold;
+};
@@ -0,0 +1,100 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Median and mean of the latest values over a fixed-size sliding window
+ * The window is split between a max-heap (lower half) and a min-heap (upper half). Both heaps store window slots and each slot remembers its heap position, so evicting the oldest value costs O(log W) instead of O(W)
+ */
+class AUDIOANALYSISTOOLS_API FSlidingMedian
+{
+public:
+	FSlidingMedian();
+
+	/**
+	 * Clear the window and set its size
+	 *
+	 * @param WindowSize The number of latest values the median and mean are calculated over
+	 */
+	void Reset(int64 WindowSize);
+
+	/**
+	 * Add a value, evicting the oldest one if the window is full
+	 *
+	 * @param Value The value to add
+	 */
+	void Add(float Value);
+
+	/** Get the median of the values in the window, or 0 if the window is empty */
+	float GetMedian() const;
+
+	/** Get the mean of the values in the window, or 0 if the window is empty */
+	float GetMean() const;
+
+	/** Get the number of values in the window */
+	int64 Num() const { return NumValues; }
+
+	/** Get the size of the window */
+	int64 GetWindowSize() const { return Values.Num(); }
+
+private:
+	/** Heap of window slots, ordered by their values */
+	struct FHeap
+	{
+		/** Window slots in heap order. Allocated for half the window up front, only the first Num are used */
+		TArray64<int64> Slots;
+
+		/** The number of slots in the heap */
+		int64 Num = 0;
+
+		/** Whether the largest value is on top (lower half) or the smallest one (upper half) */
+		bool bMaxHeap = false;
+	};
+
+	/** Whether the value of the first slot should be above the value of the second slot in the heap */
+	bool IsAbove(const FHeap& Heap, int64 FirstSlot, int64 SecondSlot) const;
+
+	/** Place the slot at the heap position and record the position */
+	void SetHeapSlot(FHeap& Heap, int64 Position, int64 Slot);
+
+	/** Move the slot at the heap position towards the top while it is above its parent */
+	void SiftUp(FHeap& Heap, int64 Position);
+
+	/** Move the slot at the heap position towards the bottom while one of its children is above it */
+	void SiftDown(FHeap& Heap, int64 Position);
+
+	/** Insert the slot into the heap */
+	void Push(FHeap& Heap, int64 Slot);
+
+	/** Remove the slot at the heap position from the heap */
+	void RemoveAt(FHeap& Heap, int64 Position);
+
+	/** Keep the lower half the same size as the upper half or one value larger */
+	void Rebalance();
+
+	/** Ring of window values, indexed by slot */
+	TArray64<float> Values;
+
+	/** The heap position of each slot */
+	TArray64<int64> HeapPositions;
+
+	/** Whether each slot is in the lower half or not */
+	TArray64<bool> InLowerHalf;
+
+	/** Max-heap of the lower half of the window */
+	FHeap LowerHalf;
+
+	/** Min-heap of the upper half of the window */
+	FHeap UpperHalf;
+
+	/** The slot the next value will be written to (the oldest slot once the window is full) */
+	int64 NextSlot;
+
+	/** The number of values in the window */
+	int64 NumValues;
+
+	/** Running sum of the values in the window */
+	double Sum;
+};
@@ -0,0 +1,91 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Precomputed mapping from magnitude spectrum bins to frequency bands
+ * Each band covers a contiguous range of bins, where the first and the last bins may only be partially covered by the band (fractional edge weights)
+ */
+class AUDIOANALYSISTOOLS_API FSpectrumBandMap
+{
+public:
+	/** Bin range covered by a single band */
+	struct FBand
+	{
+		/** The first bin touched by the band */
+		int64 FirstBin = 0;
+
+		/** The last bin touched by the band (inclusive) */
+		int64 LastBin = -1;
+
+		/** The fraction of the first bin covered by the band */
+		float FirstWeight = 0;
+
+		/** The fraction of the last bin covered by the band. Zero if the band touches a single bin */
+		float LastWeight = 0;
+
+		/** The sum of all bin weights of the band */
+		float TotalWeight = 0;
+	};
+
+	FSpectrumBandMap();
+
+	/**
+	 * Build the mapping for the given band edges
+	 *
+	 * @param LowEdges The lower edge of each band, in Hz
+	 * @param HighEdges The upper edge of each band, in Hz
+	 * @param SpectrumSize The size of the magnitude spectrum (half the FFT size)
+	 * @param SampleRate The sample rate of the analyzed audio
+	 */
+	void Build(const TArray64<float>& LowEdges, const TArray64<float>& HighEdges, int64 SpectrumSize, int32 SampleRate);
+
+	/** Whether the mapping was built for the given spectrum size and sample rate or not */
+	bool IsBuiltFor(int64 InSpectrumSize, int32 InSampleRate) const { return SpectrumSize == InSpectrumSize && SampleRate == InSampleRate; }
+
+	/** Invalidate the mapping so that it is rebuilt on the next use */
+	void Invalidate() { SpectrumSize = 0; }
+
+	/** Get the number of bands */
+	int64 Num() const { return Bands.Num(); }
+
+	/** Get the bin range of the band */
+	const FBand& GetBand(int64 Index) const { return Bands[Index]; }
+
+	/**
+	 * Calculate the weighted mean magnitude of each band
+	 *
+	 * @param Spectrum Pointer to the magnitude spectrum. Must contain SpectrumSize values
+	 * @param OutBands Pointer to the output values. Must contain Num() values
+	 */
+	void ComputeMean(const float* Spectrum, float* OutBands) const;
+
+	/**
+	 * Calculate the root mean square magnitude (i.e. the band level) of each band
+	 *
+	 * @param Spectrum Pointer to the magnitude spectrum. Must contain SpectrumSize values
+	 * @param OutBands Pointer to the output values. Must contain Num() values
+	 */
+	void ComputeRootMeanSquare(const float* Spectrum, float* OutBands) const;
+
+	/**
+	 * Calculate the weighted mean magnitude and the weighted variance of the magnitudes around it for each band
+	 *
+	 * @param Spectrum Pointer to the magnitude spectrum. Must contain SpectrumSize values
+	 * @param OutMeans Pointer to the output means. Must contain Num() values
+	 * @param OutVariances Pointer to the output variances. Must contain Num() values
+	 */
+	void ComputeMeanAndVariance(const float* Spectrum, float* OutMeans, float* OutVariances) const;
+
+private:
+	/** Bin ranges of all bands */
+	TArray64<FBand> Bands;
+
+	/** The spectrum size the mapping was built for */
+	int64 SpectrumSize;
+
+	/** The sample rate the mapping was built for */
+	int32 SampleRate;
+};
@@ -0,0 +1,141 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "UObject/Object.h"
+#include "Analyzers/FFTAudioAnalyzer.h"
+#include "TempoEstimation.generated.h"
+
+/**
+ * Streaming tempo (BPM) estimation from an onset detection function
+ * Keeps a bounded ring of onset detection function values and recomputes its autocorrelation with the FFT every few frames, so each update has a fixed cost regardless of the stream length
+ */
+UCLASS(BlueprintType, Category = "Tempo Estimation")
+class AUDIOANALYSISTOOLS_API UTempoEstimation : public UObject
+{
+	GENERATED_BODY()
+
+	UTempoEstimation();
+
+	//~ Begin UObject Interface
+	virtual void BeginDestroy() override;
+	//~ End UObject Interface
+
+public:
+	/**
+	 * Instantiates a Tempo Estimation object
+	 *
+	 * @param HistorySize The number of onset detection function values kept for the autocorrelation. Should cover at least a few beats at the lowest tempo
+	 * @param UpdateInterval The number of processed values between tempo updates
+	 * @param MinBPM The lowest detectable tempo
+	 * @param MaxBPM The highest detectable tempo
+	 * @return The TempoEstimation object
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Tempo Estimation|Main")
+	static UTempoEstimation* CreateTempoEstimation(int64 HistorySize = 512, int64 UpdateInterval = 8, float MinBPM = 60.f, float MaxBPM = 200.f);
+
+	/**
+	 * Update the tempo estimation parameters. Clears the onset history
+	 *
+	 * @param HistorySize The number of onset detection function values kept for the autocorrelation
+	 * @param UpdateInterval The number of processed values between tempo updates
+	 * @param MinBPM The lowest detectable tempo
+	 * @param MaxBPM The highest detectable tempo
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Tempo Estimation|Update")
+	void UpdateParameters(int64 HistorySize = 512, int64 UpdateInterval = 8, float MinBPM = 60.f, float MaxBPM = 200.f);
+
+	/**
+	 * Process the next onset detection function value
+	 *
+	 * @param OnsetValue The onset detection function value of the frame (e.g. the half wave rectified spectral difference)
+	 * @param DeltaTime The time elapsed since the previous value, in seconds
+	 * @return Whether the tempo was updated by this call or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Tempo Estimation|Main")
+	bool ProcessOnsetValue(float OnsetValue, float DeltaTime);
+
+	/**
+	 * Get the estimated tempo
+	 * @return The tempo in beats per minute, or 0 if not enough values have been processed yet
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get BPM"), Category = "Tempo Estimation|Main")
+	float GetBPM() const { return BPM; }
+
+	/**
+	 * Get the confidence of the estimated tempo
+	 * @return The normalized autocorrelation at the beat period, in the [0, 1] range
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Tempo Estimation|Main")
+	float GetConfidence() const { return Confidence; }
+
+	/**
+	 * Get the estimated beat period
+	 * @return The beat period in onset detection function frames, or 0 if the tempo is not known yet
+	 */
+	float GetBeatPeriod() const { return BeatPeriod; }
+
+	/**
+	 * Get the average rate of the onset detection function
+	 * @return The number of onset detection function values per second
+	 */
+	float GetFrameRate() const { return FrameRate; }
+
+protected:
+	/** Recompute the autocorrelation of the onset history and select the beat period */
+	void UpdateTempo();
+
+	/** Free the FFT plans */
+	void FreeFFT();
+
+	/** Ring of the latest onset detection function values */
+	TArray64<float> OnsetHistory;
+
+	/** The position the next value will be written to */
+	int64 HistoryPosition;
+
+	/** The number of values stored in the ring */
+	int64 NumValues;
+
+	/** The number of values processed since the last tempo update */
+	int64 ValuesSinceUpdate;
+
+	/** The number of processed values between tempo updates */
+	int64 UpdateInterval;
+
+	/** The lowest detectable tempo */
+	float MinBPM;
+
+	/** The highest detectable tempo */
+	float MaxBPM;
+
+	/** Smoothed rate of the onset detection function, in values per second */
+	float FrameRate;
+
+	/** The estimated tempo */
+	float BPM;
+
+	/** The confidence of the estimated tempo */
+	float Confidence;
+
+	/** The estimated beat period, in onset detection function frames */
+	float BeatPeriod;
+
+	/** The zero-padded FFT size used for the autocorrelation */
+	int64 PaddedSize;
+
+	/** Forward FFT plan, reused across updates */
+	FFTStateStruct* ForwardFFT;
+
+	/** Inverse FFT plan, reused across updates */
+	FFTStateStruct* InverseFFT;
+
+	/** FFT input buffer, reused across updates */
+	TArray64<FFTComplexSamples> FFTInput;
+
+	/** FFT output buffer, reused across updates */
+	TArray64<FFTComplexSamples> FFTOutput;
+
+	/** Autocorrelation of the onset history, reused across updates */
+	TArray64<float> Autocorrelation;
+};
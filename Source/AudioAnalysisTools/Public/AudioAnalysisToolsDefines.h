@@ -9,3 +9,31 @@
 #include "Logging/LogVerbosity.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogAudioAnalysis, Log, All);
+
+namespace AudioAnalysisTools
+{
+	/**
+	 * Copy a 64-bit array into a Blueprint-compatible array, reusing the allocation of the destination when the size matches
+	 *
+	 * @param Source The array to copy
+	 * @param Destination The array to copy into
+	 * @param Description The description of the copied data, used when logging an error
+	 * @return Whether the array was copied successfully or not
+	 */
+	inline bool CopyToBlueprintArray(const TArray64<float>& Source, TArray<float>& Destination, const TCHAR* Description)
+	{
+		if (Source.Num() > TNumericLimits<int32>::Max())
+		{
+			UE_LOG(LogAudioAnalysis, Error, TEXT("Unable to copy the %s: array with int32 size (max length: %d) cannot fit int64 size data (retrieved length: %lld)"), Description, TNumericLimits<int32>::Max(), Source.Num());
+			return false;
+		}
+
+		if (Destination.Num() != Source.Num())
+		{
+			Destination.SetNumUninitialized(static_cast<int32>(Source.Num()));
+		}
+
+		FMemory::Memcpy(Destination.GetData(), Source.GetData(), Source.Num() * sizeof(float));
+		return true;
+	}
+}
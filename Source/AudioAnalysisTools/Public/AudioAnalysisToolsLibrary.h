@@ -4,16 +4,71 @@
 
 #include "UObject/Object.h"
 #include "Sound/ImportedSoundWave.h"
+#include "Analyzers/FFTAudioAnalyzer.h"
+#include "Analyzers/OnsetDetection.h"
+#include "Analyzers/PolyphaseDecimator.h"
+#include "SpectrogramHistory.h"
 #include "WindowsLibrary.h"
 
-struct FFTStateStruct;
-struct FFTComplexSamples;
-
 #include "AudioAnalysisToolsLibrary.generated.h"
 
+class UBandAnalysis;
 class UBeatDetection;
+class UBeatTracker;
+class UConstantQAnalysis;
 class UEnvelopeAnalysis;
-class UOnsetDetection;
+class ULoudnessAnalysis;
+class UOnsetPeakPicker;
+class UPitchDetection;
+class UTempoEstimation;
+
+/** Delegate broadcast when a kick, snare or hi-hat beat is detected */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAudioAnalysisBeat, float, Timestamp);
+
+/** Delegate broadcast when a beat is detected in a beat detection sub-band */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAudioAnalysisBandBeat, int64, Subband, float, Timestamp);
+
+/** Delegate broadcast when an onset is picked */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAudioAnalysisOnset, float, Timestamp, float, Strength);
+
+/**
+ * Immutable snapshot of the analysis of a single audio frame
+ * Only the FFT outputs the snapshot was requested with are filled, the other arrays are empty
+ */
+struct AUDIOANALYSISTOOLS_API FAudioAnalysisFrameSnapshot
+{
+	/** The FFT outputs included in the snapshot */
+	EFFTOutputs Outputs = EFFTOutputs::None;
+
+	/** The time of the first audio frame, in seconds */
+	double Timestamp = 0;
+
+	/** The sample rate of the analyzed audio */
+	int32 SampleRate = 0;
+
+	/** Time domain features of the audio frame */
+	FTimeDomainFrameStats FrameStats;
+
+	/** The real part of the FFT */
+	TArray64<float> FFTReal;
+
+	/** The imaginary part of the FFT */
+	TArray64<float> FFTImaginary;
+
+	/** The magnitude spectrum */
+	TArray64<float> MagnitudeSpectrum;
+
+	/** The power (squared magnitude) spectrum */
+	TArray64<float> PowerSpectrum;
+
+	/** The phase spectrum, in radians */
+	TArray64<float> PhaseSpectrum;
+
+	/** The power spectrum in decibels, floored at -200 dB */
+	TArray64<float> DecibelSpectrum;
+};
+
+using FAudioAnalysisFrameSnapshotRef = TSharedRef<const FAudioAnalysisFrameSnapshot, ESPMode::ThreadSafe>;
 
 /**
  * Audio Analysis Tools object. Main class simplifying the analysis of audio data.
@@ -43,15 +98,50 @@ public:
 	/**
 	 * Process audio frames
 	 * 
-	 * @param AudioFrames An array containing audio frames in 32-bit float PCM format
+	 * @param AudioFrames An array containing audio frames in 32-bit float PCM format, interleaved if there is more than one channel
 	 * @param bProcessToBeatDetection Whether to process audio frame to beat detection or not
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Main")
 	void ProcessAudioFrames(TArray<float> AudioFrames, bool bProcessToBeatDetection = true);
 
+	/**
+	 * Process audio frames that start at the specified time
+	 *
+	 * @param AudioFrames An array containing audio frames in 32-bit float PCM format, interleaved if there is more than one channel
+	 * @param Timestamp The time of the first audio frame, in seconds (for example, the playback time of the sound wave). Negative values continue from the previously processed frames
+	 * @param bProcessToBeatDetection Whether to process audio frame to beat detection or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Main")
+	void ProcessAudioFramesAtTime(TArray<float> AudioFrames, float Timestamp, bool bProcessToBeatDetection = true);
+
+	/**
+	 * Process audio frames that start at the specified time. Suitable for long running streams, where the timestamp needs double precision
+	 *
+	 * @param AudioFrames An array containing audio frames in 32-bit float PCM format, interleaved if there is more than one channel
+	 * @param Timestamp The time of the first audio frame, in seconds. Negative values continue from the previously processed frames
+	 * @param bProcessToBeatDetection Whether to process audio frame to beat detection or not
+	 */
+	void ProcessAudioFramesAtTime(TArray<float> AudioFrames, double Timestamp, bool bProcessToBeatDetection = true);
+
+	/**
+	 * Get the timestamp of the currently stored audio frame
+	 *
+	 * @return The time of the first audio frame, in seconds
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Main")
+	float GetCurrentTimestamp() const;
+
+	/**
+	 * Get the timestamp of the currently stored audio frame in double precision
+	 *
+	 * @return The time of the first audio frame, in seconds
+	 */
+	double GetPreciseCurrentTimestamp() const;
+
 	/**
 	 * Get audio from imported sound wave by current playback time
 	 * Gets the audio data starting from the current playback time of the sound wave with the size of FrameSize
+	 * Also updates the sample rate and the number of channels to those of the sound wave, so the retrieved audio is processed in its format
 	 *
 	 * @param ImportedSoundWave Sound wave to extract audio data
 	 * @param AudioFrames An array containing audio frames in 32-bit float PCM format
@@ -106,12 +196,62 @@ public:
 	/**
 	 * Update the frame size. The smaller the buffer size, the greater the performance, but less accuracy
 	 *
-	 * @param FrameSize The frame size of internal buffers
+	 * @param FrameSize The frame size of internal buffers, per channel
 	 * @note You do not need to call it manually if you use "ProcessAudioFrames"
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Advanced")
 	void UpdateFrameSize(int64 FrameSize);
 
+	/**
+	 * Update the sample rate of the processed audio. Used by the analyzers that map spectrum bins to frequencies
+	 *
+	 * @param SampleRate The sample rate of the audio passed to "ProcessAudioFrames"
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Advanced")
+	void UpdateSampleRate(int32 SampleRate = 44100);
+
+	/**
+	 * Get the sample rate of the processed audio
+	 *
+	 * @return The sample rate used by the analyzers
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Advanced")
+	int32 GetSampleRate() const;
+
+	/**
+	 * Update the number of interleaved channels of the processed audio. Used to calculate the frame duration and by the analyzers that process each channel
+	 * The FFT, the analyzers that map the spectrum to frequencies and the pitch detection work on the audio mixed down to mono
+	 *
+	 * @param NumChannels The number of channels of the audio passed to "ProcessAudioFrames"
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Advanced")
+	void UpdateNumChannels(int32 NumChannels = 1);
+
+	/**
+	 * Get the number of interleaved channels of the processed audio
+	 *
+	 * @return The number of channels
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Advanced")
+	int32 GetNumChannels() const;
+
+	/**
+	 * Get the size of the FFT performed on each audio frame. Larger than the frame size when the frames are zero-padded
+	 *
+	 * @return The FFT size
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get FFT Size"), Category = "Audio Analysis Tools|Advanced")
+	int64 GetFFTSize() const;
+
+	/**
+	 * Get the center frequency of a bin of the spectra, taking the zero-padding into account
+	 *
+	 * @param Bin The bin index
+	 * @return The bin frequency in Hz
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Advanced")
+	float GetBinFrequency(int64 Bin) const;
+
 private:
 	/**
 	 * Initialize Audio Analysis
@@ -132,10 +272,11 @@ public:
 
 	/**
 	 * Get magnitude spectrum. Suitable for use with 64-bit data size
+	 * Returns a copy taken while the analysis is locked, since the next audio frame may be processed on another thread at any time
 	 *
 	 * @return The current magnitude spectrum
 	 */
-	const TArray64<float>& GetMagnitudeSpectrum64() const;
+	TArray64<float> GetMagnitudeSpectrum64() const;
 
 	/**
 	 * Get FFT Real
@@ -144,8 +285,13 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get FFT Real"), Category = "Audio Analysis Tools|Analyzers|Advanced")
 	TArray<float> GetFFTReal() const;
-	
-	const TArray64<float>& GetFFTReal64() const;
+
+	/**
+	 * Get FFT Real. Suitable for use with 64-bit data size
+	 *
+	 * @return The current FFT Real
+	 */
+	TArray64<float> GetFFTReal64() const;
 
 	/**
 	 * Get FFT Imaginary
@@ -160,7 +306,150 @@ public:
 	 *
 	 * @return The current FFT Imaginary
 	 */
-	const TArray64<float>& GetFFTImaginary64() const;
+	TArray64<float> GetFFTImaginary64() const;
+
+	/**
+	 * Get power spectrum
+	 *
+	 * @return The current power (squared magnitude) spectrum
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Advanced")
+	TArray<float> GetPowerSpectrum() const;
+
+	/**
+	 * Get power spectrum. Suitable for use with 64-bit data size
+	 *
+	 * @return The current power (squared magnitude) spectrum
+	 */
+	TArray64<float> GetPowerSpectrum64() const;
+
+	/**
+	 * Get phase spectrum
+	 *
+	 * @return The current phase spectrum, in radians
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Advanced")
+	TArray<float> GetPhaseSpectrum() const;
+
+	/**
+	 * Get phase spectrum. Suitable for use with 64-bit data size
+	 *
+	 * @return The current phase spectrum, in radians
+	 */
+	TArray64<float> GetPhaseSpectrum64() const;
+
+	/**
+	 * Get decibel spectrum
+	 *
+	 * @return The current power spectrum in decibels, floored at -200 dB
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Advanced")
+	TArray<float> GetDecibelSpectrum() const;
+
+	/**
+	 * Get decibel spectrum. Suitable for use with 64-bit data size
+	 *
+	 * @return The current power spectrum in decibels, floored at -200 dB
+	 */
+	TArray64<float> GetDecibelSpectrum64() const;
+
+	/**
+	 * Copy the current magnitude spectrum into the given array without reallocating it when its size already matches. Suitable for calling every tick
+	 *
+	 * @param Spectrum The array to fill
+	 * @return Whether the array was filled successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Advanced")
+	bool FillMagnitudeSpectrum(UPARAM(ref) TArray<float>& Spectrum) const;
+
+	/**
+	 * Copy the current FFT Real into the given array without reallocating it when its size already matches. Suitable for calling every tick
+	 *
+	 * @param Values The array to fill
+	 * @return Whether the array was filled successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Fill FFT Real"), Category = "Audio Analysis Tools|Analyzers|Advanced")
+	bool FillFFTReal(UPARAM(ref) TArray<float>& Values) const;
+
+	/**
+	 * Copy the current FFT Imaginary into the given array without reallocating it when its size already matches. Suitable for calling every tick
+	 *
+	 * @param Values The array to fill
+	 * @return Whether the array was filled successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Fill FFT Imaginary"), Category = "Audio Analysis Tools|Analyzers|Advanced")
+	bool FillFFTImaginary(UPARAM(ref) TArray<float>& Values) const;
+
+	/**
+	 * Copy the current power spectrum into the given array without reallocating it when its size already matches. Suitable for calling every tick
+	 *
+	 * @param Spectrum The array to fill
+	 * @return Whether the array was filled successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Advanced")
+	bool FillPowerSpectrum(UPARAM(ref) TArray<float>& Spectrum) const;
+
+	/**
+	 * Copy the current phase spectrum, in radians into the given array without reallocating it when its size already matches. Suitable for calling every tick
+	 *
+	 * @param Spectrum The array to fill
+	 * @return Whether the array was filled successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Advanced")
+	bool FillPhaseSpectrum(UPARAM(ref) TArray<float>& Spectrum) const;
+
+	/**
+	 * Copy the current decibel spectrum into the given array without reallocating it when its size already matches. Suitable for calling every tick
+	 *
+	 * @param Spectrum The array to fill
+	 * @return Whether the array was filled successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Advanced")
+	bool FillDecibelSpectrum(UPARAM(ref) TArray<float>& Spectrum) const;
+
+	/**
+	 * Get an immutable snapshot of the current audio frame, which can be held and read from any thread without copying or locking
+	 * Snapshots are reused from a small pool once no one holds them anymore, and repeated calls for the same audio frame share the same snapshot
+	 *
+	 * @param Outputs The FFT outputs to include in the snapshot
+	 * @return The frame snapshot
+	 */
+	FAudioAnalysisFrameSnapshotRef GetFrameSnapshot(EFFTOutputs Outputs = EFFTOutputs::Magnitude) const;
+
+	/**
+	 * Enable the spectrogram history. Each processed audio frame adds its magnitude spectrum as a row, overwriting the oldest row once the history is full
+	 *
+	 * @param Capacity The maximum number of rows (spectra) to keep
+	 * @param Scale The scale of the stored values
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Spectrogram History")
+	void EnableSpectrogramHistory(int64 Capacity = 256, ESpectrogramHistoryScale Scale = ESpectrogramHistoryScale::Magnitude);
+
+	/**
+	 * Disable the spectrogram history and free its memory
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Spectrogram History")
+	void DisableSpectrogramHistory();
+
+	/**
+	 * Export the spectrogram history into contiguous arrays, oldest row first
+	 *
+	 * @param Layout The memory layout of the exported values
+	 * @param Values The exported values, NumRows * RowSize in total
+	 * @param Timestamps The timestamps of the rows, in seconds
+	 * @param NumRows The number of exported rows
+	 * @param RowSize The number of values in each row
+	 * @return Whether the history was exported successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Spectrogram History")
+	bool GetSpectrogramHistory(ESpectrogramHistoryLayout Layout, TArray<float>& Values, TArray<float>& Timestamps, int64& NumRows, int64& RowSize) const;
+
+	/**
+	 * Read the spectrogram history without copying. The reader is called while the history is locked, so the row views stay valid for the duration of the call
+	 *
+	 * @param Reader The function that reads the history
+	 */
+	void ReadSpectrogramHistory(TFunctionRef<void(const FSpectrogramHistory&)> Reader) const;
 
 public:
 	/**
@@ -240,6 +529,14 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Core Time Domain Features")
 	float GetZeroCrossingRate();
 
+	/**
+	 * Get all time domain features (energy, RMS, peak energy, zero crossing rate and DC offset) of the currently stored audio frame, calculated once per frame in a single pass
+	 *
+	 * @return The time domain features of the currently stored audio frame
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Core Time Domain Features")
+	FTimeDomainFrameStats GetTimeDomainFrameStats() const;
+
 	/**
 	 * Calculate the spectral centroid given the first half of the magnitude spectrum of an audio signal
 	 *
@@ -313,6 +610,14 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Onset Detection")
 	float GetComplexSpectralDifference();
 
+	/**
+	 * Calculate the complex spectral difference over the non-redundant half of the spectrum using fast approximations, reusing the magnitude spectrum
+	 *
+	 * @return the fast complex spectral difference onset detection function sample for the magnitude spectrum frame
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Onset Detection")
+	float GetComplexSpectralDifferenceFast();
+
 	/**
 	 * Calculate the high frequency content onset detection function
 	 *
@@ -321,10 +626,49 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Onset Detection")
 	float GetHighFrequencyContent();
 
+	/**
+	 * Get all onset detection function values of the currently stored audio frame, calculated once per frame in a single pass
+	 * Requires bProcessToOnsetDetection, or one of the analyzers driven by the onset detection function (tempo estimation, beat tracker, onset peak picker)
+	 *
+	 * @return The onset detection function values
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Onset Detection")
+	FOnsetDetectionValues GetOnsetDetectionValues() const;
+
+	/**
+	 * Calculate the constant-Q spectrum (log-frequency spaced bins) from the real and imaginary parts of the FFT
+	 *
+	 * The transform is calculated once per audio frame and shared with GetChroma
+	 *
+	 * @return The magnitudes of the constant-Q bins for the current audio frame
+	 * @note The bins are configured through the Constant-Q Analysis reference. Changes recalculate the transform of the current audio frame on the next call
+	 */
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Constant-Q Spectrum"), Category = "Audio Analysis Tools|Analyzers|Constant-Q Analysis")
+	TArray<float> GetConstantQSpectrum();
+
+	/**
+	 * Calculate the 12-bin chroma vector (pitch classes starting from C) from the constant-Q spectrum
+	 *
+	 * @return The chroma vector for the current audio frame, normalized to the [0, 1] range
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Analyzers|Constant-Q Analysis")
+	TArray<float> GetChroma();
+
 private:
 	/** Configure the FFT implementation given the audio frame size) */
 	void ConfigureFFT();
 
+	/**
+	 * Calculate the FFT size for the given audio frame size, following bZeroPadToFastFFTSize
+	 *
+	 * @param FrameSize The number of audio frames
+	 * @return The FFT size
+	 */
+	int64 CalculateFFTSize(int64 FrameSize) const;
+
+	/** The size of the FFT, equal to the number of audio frames unless they are zero-padded */
+	int64 FFTSize;
+
 	/** Whether the FFT is configured or not */
 	bool FFTConfigured;
 
@@ -344,10 +688,42 @@ private:
 	FFTComplexSamples* FFT_OutSamples;
 
 	/** The real part of the FFT for the current audio frame */
-	TArray64<float> FFTReal;
+	mutable TArray64<float> FFTReal;
 
 	/** The imaginary part of the FFT for the current audio frame */
-	TArray64<float> FFTImaginary;
+	mutable TArray64<float> FFTImaginary;
+
+	/** The power spectrum of the current audio frame */
+	mutable TArray64<float> PowerSpectrum;
+
+	/** The phase spectrum of the current audio frame */
+	mutable TArray64<float> PhaseSpectrum;
+
+	/** The decibel spectrum of the current audio frame */
+	mutable TArray64<float> DecibelSpectrum;
+
+	/** The FFT outputs already calculated for the current audio frame */
+	mutable EFFTOutputs MaterializedFFTOutputs;
+
+	/**
+	 * Calculate the given FFT outputs of the current audio frame from the stored FFT output, unless they are already calculated
+	 *
+	 * @param Outputs The FFT outputs to calculate
+	 */
+	void MaterializeFFTOutputs(EFFTOutputs Outputs) const;
+
+	/** Whether the constant-Q transform of the current audio frame is already calculated */
+	bool bConstantQProcessed;
+
+	/** The Constant-Q Analysis parameters revision the current constant-Q transform was calculated with */
+	int32 ConstantQParametersRevision;
+
+	/**
+	 * Calculate the constant-Q transform of the current audio frame, unless it is already calculated
+	 *
+	 * @return Whether the constant-Q transform is available or not
+	 */
+	bool ProcessConstantQ();
 
 private:
 	/** The window type used in FFT analysis */
@@ -356,15 +732,95 @@ private:
 	/** Current audio frames */
 	TArray64<float> CurrentAudioFrames;
 
-	/** The window function used in FFT processing */
-	TArray64<float> WindowFunction;
+	/** The current audio frames mixed down to mono, reused between frames. Only filled when there is more than one channel */
+	TArray64<float> MonoAudioFrames;
+
+	/** Time domain features of the current audio frames, computed once per frame in a single pass */
+	FTimeDomainFrameStats CurrentFrameStats;
+
+	/** The window function used in FFT processing, shared through the window cache */
+	TSharedPtr<const FAnalysisWindow, ESPMode::ThreadSafe> WindowFunction;
 
 	/** The magnitude spectrum of the current audio frame */
-	TArray64<float> MagnitudeSpectrum;
+	mutable TArray64<float> MagnitudeSpectrum;
+
+	/** The sample rate of the processed audio */
+	int32 SampleRate;
+
+	/** The number of interleaved channels of the processed audio */
+	int32 NumChannels;
+
+	/** The time of the first audio frame of the currently stored audio frames, in seconds */
+	double CurrentTimestamp;
+
+	/** The time right after the currently stored audio frames, used when no explicit timestamp is given */
+	double NextTimestamp;
+
+	/** The time elapsed between the previously and the currently stored audio frames, in seconds */
+	float FrameDeltaTime;
+
+	/** The history of magnitude spectra. Disabled unless EnableSpectrogramHistory is called */
+	FSpectrogramHistory SpectrogramHistory;
+
+	/** The onset detection function value (half wave rectified spectral difference of the combined onset pass) that drives the streaming analyzers */
+	float CurrentOnsetValue;
+
+	/**
+	 * Collect the beat and onset events of the current audio frame and broadcast them on the game thread
+	 *
+	 * @param bProcessedBeatDetection Whether the beat detection was processed for the current audio frame or not
+	 */
+	void BroadcastFrameEvents(bool bProcessedBeatDetection);
 
 	/** Data guard (mutex) for thread safety */
 	mutable FCriticalSection DataGuard;
 
+	/** Decimate the current audio frames and process their magnitude spectrum to the beat detection */
+	void ProcessDecimatedBeatDetection();
+
+	/** Mix the current audio frames down to mono, averaging the interleaved channels. Does nothing if there is only one channel */
+	void MixCurrentAudioFramesToMono();
+
+	/**
+	 * Get the current audio frames mixed down to mono, as analyzed by the FFT and the pitch detection
+	 *
+	 * @return The mono audio frames. The current audio frames themselves if there is only one channel
+	 */
+	const TArray64<float>& GetMonoAudioFrames() const;
+
+	/** Free the FFT configuration of the decimated audio */
+	void FreeDecimatedFFT();
+
+	/** Decimator of the audio processed to the beat detection, keeping its filter state across audio frames */
+	FPolyphaseDecimator BeatDecimator;
+
+	/** The decimated audio frames of the latest decimated frame duration, updated as a sliding buffer */
+	TArray64<float> DecimatedAudioFrames;
+
+	/** The decimated audio frames produced from the current audio frames */
+	TArray64<float> NewDecimatedAudioFrames;
+
+	/** The window function used for the decimated audio frames */
+	TSharedPtr<const FAnalysisWindow, ESPMode::ThreadSafe> DecimatedWindowFunction;
+
+	/** FFT configuration of the decimated audio */
+	FFTStateStruct* DecimatedFFT_Configuration;
+
+	/** FFT input samples of the decimated audio */
+	TArray64<FFTComplexSamples> DecimatedFFT_InSamples;
+
+	/** FFT output samples of the decimated audio */
+	TArray64<FFTComplexSamples> DecimatedFFT_OutSamples;
+
+	/** The magnitude spectrum of the decimated audio, zero-extended to the full rate frequency range */
+	TArray64<float> DecimatedMagnitudeSpectrum;
+
+	/** The snapshot of the current audio frame, if one was requested. Reset whenever a new audio frame is processed */
+	mutable TSharedPtr<FAudioAnalysisFrameSnapshot, ESPMode::ThreadSafe> CurrentFrameSnapshot;
+
+	/** Snapshots that can be reused once the pool holds the only reference to them */
+	mutable TArray<TSharedRef<FAudioAnalysisFrameSnapshot, ESPMode::ThreadSafe>> FrameSnapshotPool;
+
 public:
 	/** Reference to the Beat Detection */
 	UPROPERTY(BlueprintReadOnly, Category = "Audio Analysis Tools|References")
@@ -373,4 +829,119 @@ public:
 	/** Reference to the Onset Detection */
 	UPROPERTY(BlueprintReadOnly, Category = "Audio Analysis Tools|References")
 	UOnsetDetection* OnsetDetection;
+
+	/** Whether to calculate the combined onset detection function values for each audio frame or not */
+	UPROPERTY(BlueprintReadWrite, Category = "Audio Analysis Tools|Settings")
+	bool bProcessToOnsetDetection;
+
+	/** Reference to the Constant-Q Analysis */
+	UPROPERTY(BlueprintReadOnly, Category = "Audio Analysis Tools|References")
+	UConstantQAnalysis* ConstantQAnalysis;
+
+	/** Reference to the Band Analysis */
+	UPROPERTY(BlueprintReadOnly, Category = "Audio Analysis Tools|References")
+	UBandAnalysis* BandAnalysis;
+
+	/** Whether to process each audio frame to the band analysis or not */
+	UPROPERTY(BlueprintReadWrite, Category = "Audio Analysis Tools|Settings")
+	bool bProcessToBandAnalysis;
+
+	/** Reference to the Pitch Detection */
+	UPROPERTY(BlueprintReadOnly, Category = "Audio Analysis Tools|References")
+	UPitchDetection* PitchDetection;
+
+	/** Whether to process each audio frame to the pitch detection or not */
+	UPROPERTY(BlueprintReadWrite, Category = "Audio Analysis Tools|Settings")
+	bool bProcessToPitchDetection;
+
+	/** Reference to the Tempo Estimation */
+	UPROPERTY(BlueprintReadOnly, Category = "Audio Analysis Tools|References")
+	UTempoEstimation* TempoEstimation;
+
+	/** Whether to process the onset detection function of each audio frame to the tempo estimation or not */
+	UPROPERTY(BlueprintReadWrite, Category = "Audio Analysis Tools|Settings")
+	bool bProcessToTempoEstimation;
+
+	/** Reference to the Beat Tracker */
+	UPROPERTY(BlueprintReadOnly, Category = "Audio Analysis Tools|References")
+	UBeatTracker* BeatTracker;
+
+	/** Whether to process the onset detection function of each audio frame to the beat tracker or not. Uses the beat period of the tempo estimation when it is enabled too */
+	UPROPERTY(BlueprintReadWrite, Category = "Audio Analysis Tools|Settings")
+	bool bProcessToBeatTracker;
+
+	/** Reference to the Onset Peak Picker */
+	UPROPERTY(BlueprintReadOnly, Category = "Audio Analysis Tools|References")
+	UOnsetPeakPicker* OnsetPeakPicker;
+
+	/** Whether to process the onset detection function of each audio frame to the onset peak picker or not */
+	UPROPERTY(BlueprintReadWrite, Category = "Audio Analysis Tools|Settings")
+	bool bProcessToOnsetPeakPicker;
+
+	/** Reference to the Envelope Analysis. It does not need an FFT, so it can also be fed directly with the interleaved audio of any channel count */
+	UPROPERTY(BlueprintReadOnly, Category = "Audio Analysis Tools|References")
+	UEnvelopeAnalysis* EnvelopeAnalysis;
+
+	/** Whether to process each audio frame to the envelope analysis or not */
+	UPROPERTY(BlueprintReadWrite, Category = "Audio Analysis Tools|Settings")
+	bool bProcessToEnvelopeAnalysis;
+
+	/** Reference to the Loudness Analysis. Whole sound waves can be measured offline with ULoudnessAnalysis::AnalyzeImportedSoundWave */
+	UPROPERTY(BlueprintReadOnly, Category = "Audio Analysis Tools|References")
+	ULoudnessAnalysis* LoudnessAnalysis;
+
+	/** Whether to process each audio frame to the loudness analysis or not */
+	UPROPERTY(BlueprintReadWrite, Category = "Audio Analysis Tools|Settings")
+	bool bProcessToLoudnessAnalysis;
+
+	/**
+	 * Whether to broadcast the beat and onset delegates or not
+	 * The events of each processed audio frame are collected on the analysis thread and broadcast on the game thread in a single batch
+	 * While enabled, the onset events of the onset peak picker are consumed by the library and broadcast with OnOnset instead
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Audio Analysis Tools|Settings")
+	bool bBroadcastEvents;
+
+	/**
+	 * The FFT outputs (EFFTOutputs flags) calculated right after the FFT of each audio frame
+	 * Other outputs are calculated on first access for the current audio frame (by a getter or an enabled analyzer), and never if nobody accesses them
+	 */
+	UPROPERTY(BlueprintReadWrite, meta = (Bitmask, BitmaskEnum = "EFFTOutputs"), Category = "Audio Analysis Tools|Settings")
+	int32 EagerFFTOutputs;
+
+	/**
+	 * Whether to zero-pad each audio frame to the next size that only has the factors 2, 3 and 5 or not
+	 * Frame sizes calculated from a time length are often awkward for the FFT, and padding them avoids the slow generic butterflies. The spectra get more (interpolated) bins, see GetBinFrequency
+	 */
+	UPROPERTY(BlueprintReadWrite, meta = (DisplayName = "Zero Pad To Fast FFT Size"), Category = "Audio Analysis Tools|Settings")
+	bool bZeroPadToFastFFTSize;
+
+	/**
+	 * The decimation of the audio processed to the beat detection
+	 * The beat detection then uses its own FFT over the decimated audio, smaller by the factor at the same frequency resolution and time span
+	 * The decimated spectrum is laid out over the full rate frequency range, so every band layout (including the linear one) keeps the meaning of its sub-band indices
+	 * The decimated audio only reaches the reduced Nyquist frequency, so sub-bands (and the hi-hat range) above it stay silent
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Audio Analysis Tools|Settings")
+	EAudioDecimationFactor BeatDetectionDecimation;
+
+	/** Called on the game thread when a kick beat is detected. Requires the beat detection to be processed */
+	UPROPERTY(BlueprintAssignable, Category = "Audio Analysis Tools|Delegates")
+	FOnAudioAnalysisBeat OnKick;
+
+	/** Called on the game thread when a snare beat is detected. Requires the beat detection to be processed */
+	UPROPERTY(BlueprintAssignable, Category = "Audio Analysis Tools|Delegates")
+	FOnAudioAnalysisBeat OnSnare;
+
+	/** Called on the game thread when a hi-hat beat is detected. Requires the beat detection to be processed */
+	UPROPERTY(BlueprintAssignable, Category = "Audio Analysis Tools|Delegates")
+	FOnAudioAnalysisBeat OnHiHat;
+
+	/** Called on the game thread for each beat detection sub-band with a beat. Requires the beat detection to be processed */
+	UPROPERTY(BlueprintAssignable, Category = "Audio Analysis Tools|Delegates")
+	FOnAudioAnalysisBandBeat OnBandBeat;
+
+	/** Called on the game thread for each onset picked by the onset peak picker. Requires bProcessToOnsetPeakPicker */
+	UPROPERTY(BlueprintAssignable, Category = "Audio Analysis Tools|Delegates")
+	FOnAudioAnalysisOnset OnOnset;
 };
@@ -0,0 +1,126 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "UObject/Object.h"
+#include "UObject/WeakObjectPtr.h"
+#include "HAL/CriticalSection.h"
+#include "ImportedSoundWaveAnalysisHook.generated.h"
+
+class UImportedSoundWave;
+class UEnvelopeAnalysis;
+class ULoudnessAnalysis;
+class UMultiResolutionAnalysis;
+
+/**
+ * Delegate called on the decoding thread for each chunk of audio populated into the sound wave
+ * Receives the interleaved audio frames, the number of channels and the sample rate
+ */
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnImportedAudioChunkNative, TArrayView64<const float>, int32, int32);
+
+/**
+ * Feeds the audio of an imported sound wave to streaming analyzers while it is being decoded, instead of reading it back from the PCM buffer afterwards
+ * The analysis results (e.g. the integrated loudness or the multi-resolution frames) are ready as soon as the import finishes
+ * The hook does not reduce memory usage: the sound wave keeps its full decoded PCM buffer resident as usual, it only saves a second pass over it
+ * The chunks are processed on the thread they were populated on, so the analyzers should only be read through their thread-safe getters until the import finishes
+ * A chunk with a different sample rate than the previous ones resets the analyzers, so audio of different rates is never mixed into one measurement
+ */
+UCLASS(BlueprintType, Category = "Audio Analysis Tools")
+class AUDIOANALYSISTOOLS_API UImportedSoundWaveAnalysisHook : public UObject
+{
+	GENERATED_BODY()
+
+	UImportedSoundWaveAnalysisHook();
+
+public:
+	//~ Begin UObject Interface
+	virtual void BeginDestroy() override;
+	//~ End UObject Interface
+
+	/**
+	 * Instantiates a hook and binds it to the populated audio data of the sound wave. The hook must be referenced for as long as it should feed the analyzers
+	 *
+	 * @param ImportedSoundWave The sound wave to analyze while it is populated, typically before starting the import or a streaming sound wave
+	 * @return The ImportedSoundWaveAnalysisHook object, or nullptr if the sound wave is invalid
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Import Analysis")
+	static UImportedSoundWaveAnalysisHook* CreateImportedSoundWaveAnalysisHook(UImportedSoundWave* ImportedSoundWave);
+
+	/**
+	 * Stop receiving the audio of the sound wave
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Import Analysis")
+	void Unbind();
+
+	/**
+	 * Feed each populated chunk to the loudness analysis, keeping all channels
+	 *
+	 * @param LoudnessAnalysis The loudness analysis to feed. Nullptr stops feeding it
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Import Analysis")
+	void SetLoudnessAnalysis(ULoudnessAnalysis* LoudnessAnalysis);
+
+	/**
+	 * Feed each populated chunk to the envelope analysis, keeping all channels
+	 *
+	 * @param EnvelopeAnalysis The envelope analysis to feed. Nullptr stops feeding it
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Import Analysis")
+	void SetEnvelopeAnalysis(UEnvelopeAnalysis* EnvelopeAnalysis);
+
+	/**
+	 * Feed each populated chunk to the multi-resolution analysis, mixed down to mono
+	 *
+	 * @param MultiResolutionAnalysis The multi-resolution analysis to feed. Nullptr stops feeding it
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Import Analysis")
+	void SetMultiResolutionAnalysis(UMultiResolutionAnalysis* MultiResolutionAnalysis);
+
+	/**
+	 * Get the duration of the audio fed to the analyzers so far
+	 * @return The duration in seconds
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Audio Analysis Tools|Import Analysis")
+	float GetProcessedDuration() const;
+
+	/** Called on the decoding thread for each populated chunk after the analyzers processed it, for custom streaming analyzers. Broadcast without the hook being locked */
+	FOnImportedAudioChunkNative OnImportedAudioChunkNative;
+
+protected:
+	/**
+	 * Handle a chunk of audio populated into the sound wave
+	 *
+	 * @param PopulatedAudioData The interleaved audio frames of the chunk
+	 */
+	void HandlePopulatedAudioData(const TArray<float>& PopulatedAudioData);
+
+	/** The sound wave the hook is bound to */
+	TWeakObjectPtr<UImportedSoundWave> ImportedSoundWave;
+
+	/** The handle of the populated audio data binding */
+	FDelegateHandle PopulateAudioDataHandle;
+
+	/** The loudness analysis fed with the populated audio */
+	UPROPERTY()
+	ULoudnessAnalysis* LoudnessAnalysis;
+
+	/** The envelope analysis fed with the populated audio */
+	UPROPERTY()
+	UEnvelopeAnalysis* EnvelopeAnalysis;
+
+	/** The multi-resolution analysis fed with the populated audio */
+	UPROPERTY()
+	UMultiResolutionAnalysis* MultiResolutionAnalysis;
+
+	/** The populated audio mixed down to mono */
+	TArray64<float> MonoAudioFrames;
+
+	/** The number of audio frames (per channel) fed to the analyzers */
+	int64 NumProcessedFrames;
+
+	/** The sample rate of the fed audio */
+	int32 SampleRate;
+
+	/** Data guard (mutex) for thread safety */
+	mutable FCriticalSection DataGuard;
+};
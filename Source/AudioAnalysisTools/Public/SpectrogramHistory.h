@@ -0,0 +1,130 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpectrogramHistory.generated.h"
+
+/**
+ * Scale of the values stored in the spectrogram history
+ */
+UENUM(BlueprintType, Category = "Audio Analysis Tools")
+enum class ESpectrogramHistoryScale : uint8
+{
+	/** Linear magnitude, as returned by GetMagnitudeSpectrum */
+	Magnitude,
+
+	/** Magnitude in decibels (20 * log10(Magnitude)), floored at -200 dB */
+	Decibels,
+
+	/** Octave or third-octave band levels from the Band Analysis. Rows are only added while the band analysis is processed */
+	BandLevels
+};
+
+/**
+ * Memory layout of the exported spectrogram history
+ */
+UENUM(BlueprintType, Category = "Audio Analysis Tools")
+enum class ESpectrogramHistoryLayout : uint8
+{
+	/** Rows are stored one after another, oldest first: Values[RowIndex * RowSize + BinIndex] */
+	TimeMajor,
+
+	/** Bins are stored one after another, each holding all rows oldest first: Values[BinIndex * NumRows + RowIndex] */
+	FrequencyMajor
+};
+
+/**
+ * Fixed-capacity ring buffer of spectrum rows with timestamps
+ * All rows are stored in a single contiguous allocation, so reading a row does not copy
+ */
+class AUDIOANALYSISTOOLS_API FSpectrogramHistory
+{
+public:
+	FSpectrogramHistory();
+
+	/**
+	 * Reallocate the history and remove all rows
+	 *
+	 * @param Capacity The maximum number of rows to keep
+	 * @param RowSize The number of values in each row
+	 * @param Scale The scale applied to the values when they are added
+	 */
+	void Reset(int64 Capacity, int64 RowSize, ESpectrogramHistoryScale Scale);
+
+	/** Remove all rows while keeping the allocation */
+	void Clear();
+
+	/**
+	 * Add a row, overwriting the oldest one if the history is full
+	 *
+	 * @param Values Pointer to the magnitude values. Must contain RowSize values
+	 * @param Timestamp The timestamp of the row, in seconds
+	 */
+	void AddRow(const float* Values, double Timestamp);
+
+	/** Whether the history has been allocated or not */
+	bool IsEnabled() const { return Capacity > 0 && RowSize > 0; }
+
+	/** Get the number of stored rows */
+	int64 Num() const { return NumRows; }
+
+	/** Get the maximum number of rows */
+	int64 GetCapacity() const { return Capacity; }
+
+	/** Get the number of values in each row */
+	int64 GetRowSize() const { return RowSize; }
+
+	/** Get the scale applied to the stored values */
+	ESpectrogramHistoryScale GetScale() const { return Scale; }
+
+	/**
+	 * Get a view of the row without copying
+	 *
+	 * @param Index Row index, where 0 is the oldest row and Num() - 1 is the latest one
+	 * @return The row values. Only valid until the next call to AddRow
+	 */
+	TArrayView64<const float> GetRow(int64 Index) const;
+
+	/**
+	 * Get the timestamp of the row
+	 *
+	 * @param Index Row index, where 0 is the oldest row and Num() - 1 is the latest one
+	 * @return The timestamp in seconds
+	 */
+	double GetRowTimestamp(int64 Index) const;
+
+	/**
+	 * Export all rows, oldest first, into a contiguous array
+	 *
+	 * @param Layout The memory layout of the exported values
+	 * @param OutValues The exported values. Reallocated only if the size changes
+	 * @param OutTimestamps The exported timestamps, one per row
+	 */
+	void Export(ESpectrogramHistoryLayout Layout, TArray64<float>& OutValues, TArray64<double>& OutTimestamps) const;
+
+private:
+	/** Convert the logical row index (0 is the oldest row) to the physical slot in the ring */
+	int64 GetSlotIndex(int64 Index) const;
+
+	/** Row values, Capacity * RowSize in total */
+	TArray64<float> Rows;
+
+	/** Row timestamps, Capacity in total */
+	TArray64<double> Timestamps;
+
+	/** The maximum number of rows */
+	int64 Capacity;
+
+	/** The number of values in each row */
+	int64 RowSize;
+
+	/** The slot the next row will be written to */
+	int64 WritePosition;
+
+	/** The number of stored rows */
+	int64 NumRows;
+
+	/** The scale applied to the values when they are added */
+	ESpectrogramHistoryScale Scale;
+};
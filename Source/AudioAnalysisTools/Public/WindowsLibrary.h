@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "Templates/SharedPointer.h"
 #include "WindowsLibrary.generated.h"
 
 /**
@@ -16,9 +17,29 @@ enum class EAnalysisWindowType : uint8
 	HanningWindow,
 	HammingWindow,
 	BlackmanWindow,
-	TukeyWindow
+	TukeyWindow,
+	KaiserWindow,
+	BlackmanHarrisWindow,
+	FlatTopWindow
 };
 
+/**
+ * Immutable window shared through the window cache, together with the gains used to normalize spectra of windowed signals
+ */
+struct AUDIOANALYSISTOOLS_API FAnalysisWindow
+{
+	/** The window values */
+	TArray64<float> Values;
+
+	/** The mean of the window values. Dividing an amplitude spectrum by FrameSize * CoherentGain restores the amplitudes of sinusoids */
+	float CoherentGain = 0;
+
+	/** The sum of the squared window values. Dividing a power spectrum by it restores the power of broadband signals */
+	float Energy = 0;
+};
+
+using FAnalysisWindowRef = TSharedRef<const FAnalysisWindow, ESPMode::ThreadSafe>;
+
 /**
  * Library for creating windows functions of different types
  */
@@ -34,10 +55,11 @@ public:
 	 *
 	 * @param FrameSize The frame size of internal buffers
 	 * @param WindowType A type of the window
+	 * @param Parameter The cosine fraction of the Tukey window or the beta of the Kaiser window. Negative values use the default of the window type. Ignored by the other window types
 	 * @return A window with the specified type
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Window Library")
-	static TArray<float> CreateWindowByType(int32 FrameSize, EAnalysisWindowType WindowType);
+	static TArray<float> CreateWindowByType(int32 FrameSize, EAnalysisWindowType WindowType, float Parameter = -1.f);
 
 	/**
 	 * Create a window with a specified type. It is used in spectral analysis
@@ -45,9 +67,43 @@ public:
 	 *
 	 * @param FrameSize The frame size of internal buffers
 	 * @param WindowType A type of the window
+	 * @param Parameter The cosine fraction of the Tukey window or the beta of the Kaiser window. Negative values use the default of the window type. Ignored by the other window types
 	 * @return A window with the specified type
 	 */
-	static TArray64<float> CreateWindowByType(int64 FrameSize, EAnalysisWindowType WindowType);
+	static TArray64<float> CreateWindowByType(int64 FrameSize, EAnalysisWindowType WindowType, float Parameter = -1.f);
+
+	/**
+	 * Get a window from the process-wide window cache, creating it on the first request
+	 * The window is shared between all users with the same frame size, type and parameter, so it must not be modified. Thread safe
+	 *
+	 * @param FrameSize The frame size of internal buffers
+	 * @param WindowType A type of the window
+	 * @param Parameter The cosine fraction of the Tukey window or the beta of the Kaiser window. Negative values use the default of the window type. Ignored by the other window types
+	 * @return The shared window
+	 */
+	static FAnalysisWindowRef GetCachedWindow(int64 FrameSize, EAnalysisWindowType WindowType, float Parameter = -1.f);
+
+	/**
+	 * Get the coherent gain (mean value) of a window, used to normalize amplitude spectra
+	 *
+	 * @param FrameSize The frame size of internal buffers
+	 * @param WindowType A type of the window
+	 * @param Parameter The cosine fraction of the Tukey window or the beta of the Kaiser window. Negative values use the default of the window type
+	 * @return The coherent gain
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Window Library")
+	static float GetWindowCoherentGain(int32 FrameSize, EAnalysisWindowType WindowType, float Parameter = -1.f);
+
+	/**
+	 * Get the energy (sum of the squared values) of a window, used to normalize power spectra
+	 *
+	 * @param FrameSize The frame size of internal buffers
+	 * @param WindowType A type of the window
+	 * @param Parameter The cosine fraction of the Tukey window or the beta of the Kaiser window. Negative values use the default of the window type
+	 * @return The window energy
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Window Library")
+	static float GetWindowEnergy(int32 FrameSize, EAnalysisWindowType WindowType, float Parameter = -1.f);
 
 	/**
 	 * Create a window with Hanning type. It is used in spectral analysis
@@ -140,4 +196,63 @@ public:
 	 * @return A window with a Rectangular type
 	 */
 	static TArray64<float> CreateRectangularWindow(int64 FrameSize);
+
+	/**
+	 * Create a window with Kaiser type. It is used in spectral analysis
+	 * Its side lobe level and main lobe width are traded off by Beta (e.g. 5 is close to Hamming, 8.6 to Blackman)
+	 *
+	 * @param FrameSize The frame size of internal buffers
+	 * @param Beta The shape parameter of the Kaiser window
+	 * @return A window with a Kaiser type
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Window Library")
+	static TArray<float> CreateKaiserWindow(int32 FrameSize, float Beta = 8.6f);
+
+	/**
+	 * Create a window with Kaiser type. It is used in spectral analysis
+	 * Suitable for use with 64-bit data size
+	 *
+	 * @param FrameSize The frame size of internal buffers
+	 * @param Beta The shape parameter of the Kaiser window
+	 * @return A window with a Kaiser type
+	 */
+	static TArray64<float> CreateKaiserWindow(int64 FrameSize, float Beta = 8.6f);
+
+	/**
+	 * Create a window with Blackman-Harris type. It is used in spectral analysis
+	 * Four-term window with side lobes below -92 dB
+	 *
+	 * @param FrameSize The frame size of internal buffers
+	 * @return A window with a Blackman-Harris type
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Window Library")
+	static TArray<float> CreateBlackmanHarrisWindow(int32 FrameSize);
+
+	/**
+	 * Create a window with Blackman-Harris type. It is used in spectral analysis
+	 * Suitable for use with 64-bit data size
+	 *
+	 * @param FrameSize The frame size of internal buffers
+	 * @return A window with a Blackman-Harris type
+	 */
+	static TArray64<float> CreateBlackmanHarrisWindow(int64 FrameSize);
+
+	/**
+	 * Create a window with flat-top type. It is used in spectral analysis
+	 * Window with a nearly flat main lobe, so peak amplitudes are measured accurately regardless of where the frequency falls between bins
+	 *
+	 * @param FrameSize The frame size of internal buffers
+	 * @return A window with a flat-top type
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Window Library")
+	static TArray<float> CreateFlatTopWindow(int32 FrameSize);
+
+	/**
+	 * Create a window with flat-top type. It is used in spectral analysis
+	 * Suitable for use with 64-bit data size
+	 *
+	 * @param FrameSize The frame size of internal buffers
+	 * @return A window with a flat-top type
+	 */
+	static TArray64<float> CreateFlatTopWindow(int64 FrameSize);
 };
\ No newline at end of file